@@ -0,0 +1,19 @@
+#version 410 core
+// Draws vertices skinned once per pose into a cache (SkinCache), so this pass only places them.
+// Positions are stored one channel per axis.
+layout (location = 0) in float aPosX;
+layout (location = 1) in float aPosY;
+layout (location = 2) in float aPosZ;
+layout (location = 6) in vec2 aTexCoords;
+
+out vec2 TexCoords;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+void main()
+{
+    TexCoords = aTexCoords;
+    gl_Position = projection * view * model * vec4(aPosX, aPosY, aPosZ, 1.0);
+}
@@ -1,31 +1,163 @@
 #version 410 core
-const int MAX_JOINTS = 50;
 const int MAX_WEIGHTS = 4;
 
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
-layout (location = 5) in ivec4 aJointID;
+layout (location = 3) in vec3 aTangent;
+layout (location = 4) in vec3 aBitangent;
+layout (location = 5) in uvec4 aJointID;
 layout (location = 6) in vec4 aJointWeights;
+// PackedVertex tangent: two 15 bit octahedral coordinates and the bitangent sign in bit 31.
+layout (location = 7) in uint aPackedTangent;
 
 out vec2 TexCoords;
+out vec3 Normal;
+// Tangent in xyz, bitangent sign in w.
+out vec4 Tangent;
 
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
-uniform mat4 jointTransforms[MAX_JOINTS];
 uniform bool animated;
+// Whether the mesh was uploaded as PackedVertex, aNormal then holds an octahedral normal.
+uniform bool packedVertices;
+
+// Live playback, every instance's palette sits in one stream in the same encoding.
+uniform samplerBuffer palette;
+// First bone of this instance's palette in the stream.
+uniform int paletteBase;
+// PaletteEncoding of the stream: 4 columns per bone, 3 affine rows, or a dual quaternion in
+// 2 texels. Half precision variants read the same texels from an RGBA16F stream.
+uniform int paletteEncoding;
+const int ENCODING_MATRIX = 0;
+const int ENCODING_AFFINE = 1;
+const int ENCODING_DUAL_QUATERNION = 2;
+const int ENCODING_AFFINE_HALF = 3;
+const int ENCODING_DUAL_QUATERNION_HALF = 4;
+
+// Baked playback, palettes are fetched from a stream of 3 rows per bone per frame.
+uniform bool baked;
+uniform samplerBuffer bakedPalette;
+uniform int bakedBoneCount;
+// First frame, frame count, frames per second and length of the clip being played.
+uniform vec4 bakedClip;
+uniform float bakedTime;
+
+vec3 octahedralDecode(vec2 encoded)
+{
+	vec3 direction = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+	float fold = max(-direction.z, 0.0);
+	direction.xy += mix(vec2(fold), vec2(-fold), greaterThanEqual(direction.xy, vec2(0.0)));
+	return normalize(direction);
+}
+
+vec3 vertexNormal()
+{
+	return packedVertices ? octahedralDecode(aNormal.xy) : aNormal;
+}
+
+vec4 vertexTangent()
+{
+	if (!packedVertices) {
+		float sign = dot(cross(aNormal, aTangent), aBitangent) < 0.0 ? -1.0 : 1.0;
+		return vec4(aTangent, sign);
+	}
+	vec2 encoded = vec2(aPackedTangent & 0x7FFFu, (aPackedTangent >> 15) & 0x7FFFu);
+	float sign = (aPackedTangent & 0x80000000u) != 0u ? -1.0 : 1.0;
+	return vec4(octahedralDecode(encoded / 32767.0 * 2.0 - 1.0), sign);
+}
+
+bool isDualQuaternion()
+{
+	return paletteEncoding == ENCODING_DUAL_QUATERNION ||
+	       paletteEncoding == ENCODING_DUAL_QUATERNION_HALF;
+}
+
+mat4 paletteJoint(int joint)
+{
+	if (paletteEncoding == ENCODING_AFFINE || paletteEncoding == ENCODING_AFFINE_HALF) {
+		int row = (paletteBase + joint) * 3;
+		return transpose(mat4(texelFetch(palette, row), texelFetch(palette, row + 1),
+		                      texelFetch(palette, row + 2), vec4(0.0, 0.0, 0.0, 1.0)));
+	}
+	int row = (paletteBase + joint) * 4;
+	return mat4(texelFetch(palette, row), texelFetch(palette, row + 1),
+	            texelFetch(palette, row + 2), texelFetch(palette, row + 3));
+}
+
+// Blends the dual quaternions of the vertex's joints and returns the rigid transform they give.
+mat4 dualQuaternionTransform(ivec4 joints)
+{
+	vec4 real = vec4(0.0);
+	vec4 dual = vec4(0.0);
+	vec4 first = texelFetch(palette, (paletteBase + joints[0]) * 2);
+	for (int i = 0; i < MAX_WEIGHTS; ++i) {
+		int row = (paletteBase + joints[i]) * 2;
+		vec4 jointReal = texelFetch(palette, row);
+		// q and -q are the same rotation, blend every joint on the first joint's side.
+		float weight = dot(jointReal, first) < 0.0 ? -aJointWeights[i] : aJointWeights[i];
+		real += jointReal * weight;
+		dual += texelFetch(palette, row + 1) * weight;
+	}
+	float len = length(real);
+	real /= len;
+	dual /= len;
+	vec3 translation = 2.0 * (real.w * dual.xyz - dual.w * real.xyz + cross(real.xyz, dual.xyz));
+	float x = real.x, y = real.y, z = real.z, w = real.w;
+	return mat4(1.0 - 2.0 * (y * y + z * z), 2.0 * (x * y + w * z), 2.0 * (x * z - w * y), 0.0,
+	            2.0 * (x * y - w * z), 1.0 - 2.0 * (x * x + z * z), 2.0 * (y * z + w * x), 0.0,
+	            2.0 * (x * z + w * y), 2.0 * (y * z - w * x), 1.0 - 2.0 * (x * x + y * y), 0.0,
+	            translation, 1.0);
+}
+
+mat4 bakedJoint(int frame, int joint)
+{
+	int row = (frame * bakedBoneCount + joint) * 3;
+	return transpose(mat4(texelFetch(bakedPalette, row),
+	                      texelFetch(bakedPalette, row + 1),
+	                      texelFetch(bakedPalette, row + 2),
+	                      vec4(0.0, 0.0, 0.0, 1.0)));
+}
+
+mat4 bakedTransform(int joint, int first, int second, float progression)
+{
+	return bakedJoint(first, joint) * (1.0 - progression) + bakedJoint(second, joint) * progression;
+}
 
 void main()
 {
-	mat4 bone_transform = jointTransforms[aJointID[0]] * aJointWeights[0];
-		bone_transform += jointTransforms[aJointID[1]] * aJointWeights[1];
-		bone_transform += jointTransforms[aJointID[2]] * aJointWeights[2];
-		bone_transform += jointTransforms[aJointID[3]] * aJointWeights[3];
+	ivec4 joints = ivec4(aJointID);
+	mat4 bone_transform;
+	if (baked) {
+		float position = mod(bakedTime, max(bakedClip.w, 0.0001)) * bakedClip.z;
+		int lastFrame = int(bakedClip.y) - 1;
+		int frame = min(int(position), lastFrame);
+		// The closing frame sits at the clip length, the last segment may be shorter.
+		float segment = min(1.0, bakedClip.w * bakedClip.z - float(frame));
+		float progression = segment > 0.0 ? (position - float(frame)) / segment : 0.0;
+		int first = int(bakedClip.x) + frame;
+		int second = int(bakedClip.x) + min(frame + 1, lastFrame);
+		bone_transform = bakedTransform(joints[0], first, second, progression) * aJointWeights[0];
+		bone_transform += bakedTransform(joints[1], first, second, progression) * aJointWeights[1];
+		bone_transform += bakedTransform(joints[2], first, second, progression) * aJointWeights[2];
+		bone_transform += bakedTransform(joints[3], first, second, progression) * aJointWeights[3];
+	} else if (isDualQuaternion()) {
+		bone_transform = dualQuaternionTransform(joints);
+	} else {
+		bone_transform = paletteJoint(joints[0]) * aJointWeights[0];
+		bone_transform += paletteJoint(joints[1]) * aJointWeights[1];
+		bone_transform += paletteJoint(joints[2]) * aJointWeights[2];
+		bone_transform += paletteJoint(joints[3]) * aJointWeights[3];
+	}
 
     vec4 boned_position = bone_transform * vec4(aPos, 1.0);
 
     TexCoords = aTexCoords;
+    mat3 normalMatrix = mat3(model) * mat3(bone_transform);
+    Normal = normalize(normalMatrix * vertexNormal());
+    vec4 tangent = vertexTangent();
+    Tangent = vec4(normalize(normalMatrix * tangent.xyz), tangent.w);
     gl_Position = projection * view * model * boned_position;
 
 }
\ No newline at end of file
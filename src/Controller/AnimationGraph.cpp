@@ -0,0 +1,272 @@
+#include "AnimationGraph.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+size_t Controller::AnimationGraph::addParameter(const std::string &name, float defaultValue) {
+    parameterNames.push_back(name);
+    parameterDefaults.push_back(defaultValue);
+    return parameterNames.size() - 1;
+}
+
+size_t Controller::AnimationGraph::addClip(const Model::Animation *clip, float speed) {
+    Node node  = {};
+    node.type  = NodeType::CLIP;
+    node.clip  = clip;
+    node.speed = speed;
+    nodes.push_back(node);
+    return nodes.size() - 1;
+}
+
+size_t Controller::AnimationGraph::addBlend(size_t first, size_t second, size_t parameter) {
+    Node node      = {};
+    node.type      = NodeType::BLEND;
+    node.first     = first;
+    node.second    = second;
+    node.parameter = parameter;
+    nodes.push_back(node);
+    return nodes.size() - 1;
+}
+
+size_t Controller::AnimationGraph::addFixedBlend(size_t first, size_t second, float weight) {
+    Node node   = {};
+    node.type   = NodeType::BLEND;
+    node.first  = first;
+    node.second = second;
+    node.weight = weight;
+    nodes.push_back(node);
+    return nodes.size() - 1;
+}
+
+size_t Controller::AnimationGraph::addMaskedBlend(size_t base, size_t layer, size_t parameter,
+                                                  std::vector<float> jointWeights) {
+    masks.push_back(std::move(jointWeights));
+    Node node      = {};
+    node.type      = NodeType::MASKED_BLEND;
+    node.first     = base;
+    node.second    = layer;
+    node.parameter = parameter;
+    node.weight    = 1.0f;
+    node.mask      = masks.size() - 1;
+    nodes.push_back(node);
+    return nodes.size() - 1;
+}
+
+size_t Controller::AnimationGraph::addState(const std::string &name, size_t root) {
+    stateNames.push_back(name);
+    stateRoots.push_back(root);
+    return stateNames.size() - 1;
+}
+
+void Controller::AnimationGraph::addTransition(size_t from, size_t to, size_t parameter,
+                                               float threshold, bool above, double duration) {
+    transitions.push_back({from, to, parameter, threshold, above, duration});
+}
+
+int Controller::AnimationGraph::findParameter(const std::string &name) const {
+    auto found = std::find(parameterNames.begin(), parameterNames.end(), name);
+    return found == parameterNames.end() ? -1
+                                         : static_cast<int>(found - parameterNames.begin());
+}
+
+int Controller::AnimationGraph::findState(const std::string &name) const {
+    auto found = std::find(stateNames.begin(), stateNames.end(), name);
+    return found == stateNames.end() ? -1 : static_cast<int>(found - stateNames.begin());
+}
+
+Controller::CompiledGraph
+Controller::AnimationGraph::compile(const Model::Skeleton &skeleton) const {
+    return CompiledGraph(*this, skeleton);
+}
+
+Controller::CompiledGraph::CompiledGraph(const AnimationGraph &graph,
+                                         const Model::Skeleton &skeleton) {
+    if (graph.stateRoots.empty()) {
+        throw std::runtime_error("Animation graph has no states");
+    }
+    masks             = graph.masks;
+    parameterDefaults = graph.parameterDefaults;
+    restPose          = skeleton.bindPose;
+
+    std::vector<uint16_t> nodeSlots(graph.nodes.size(), GRAPH_NONE);
+    for (size_t state = 0; state < graph.stateRoots.size(); ++state) {
+        // Slots are only shared within a state. A transition restarts the target's clips, which
+        // must not move the clips the source state is still playing.
+        std::fill(nodeSlots.begin(), nodeSlots.end(), GRAPH_NONE);
+        size_t begin     = tape.size();
+        size_t slotBegin = stateSlots.size();
+        size_t used      = compileNode(graph, skeleton, graph.stateRoots[state], 0, nodeSlots);
+        registerCount    = std::max(registerCount, used + 1);
+        stateTapes.emplace_back(begin, tape.size());
+        for (size_t i = begin; i < tape.size(); ++i) {
+            if (tape[i].op == GraphOp::SAMPLE) {
+                stateSlots.push_back(tape[i].slot);
+            }
+        }
+        stateSlotRanges.emplace_back(slotBegin, stateSlots.size());
+
+        size_t transitionBegin = transitions.size();
+        for (const auto &transition : graph.transitions) {
+            if (transition.from == state) {
+                transitions.push_back({transition.to, static_cast<uint16_t>(transition.parameter),
+                                       transition.threshold, transition.above,
+                                       transition.duration});
+            }
+        }
+        stateTransitions.emplace_back(transitionBegin, transitions.size());
+    }
+    if (registerCount * 2 > 256) {
+        throw std::runtime_error("Animation graph is too deep to compile");
+    }
+}
+
+size_t Controller::CompiledGraph::compileNode(const AnimationGraph &graph,
+                                              const Model::Skeleton &skeleton, size_t node,
+                                              size_t target, std::vector<uint16_t> &nodeSlots) {
+    const auto &description = graph.nodes.at(node);
+    GraphInstruction instruction = {};
+    instruction.target = static_cast<uint8_t>(target);
+    if (description.type == AnimationGraph::NodeType::CLIP) {
+        if (nodeSlots[node] == GRAPH_NONE) {
+            nodeSlots[node] = static_cast<uint16_t>(clips.size());
+            clips.push_back(description.clip);
+            clipRestPoses.push_back(&description.clip->getRestPose(skeleton));
+            clipSpeeds.push_back(description.speed);
+        }
+        instruction.op   = GraphOp::SAMPLE;
+        instruction.slot = nodeSlots[node];
+        tape.push_back(instruction);
+        return target;
+    }
+    // The first input is evaluated straight into the target, so a chain of blends only needs
+    // one extra register per level of nesting on its second input.
+    size_t used = compileNode(graph, skeleton, description.first, target, nodeSlots);
+    used = std::max(used, compileNode(graph, skeleton, description.second, target + 1, nodeSlots));
+    instruction.op        = description.type == AnimationGraph::NodeType::MASKED_BLEND
+                                ? GraphOp::BLEND_MASKED
+                                : GraphOp::BLEND;
+    instruction.source    = static_cast<uint8_t>(target + 1);
+    instruction.parameter = static_cast<uint16_t>(description.parameter);
+    instruction.mask      = static_cast<uint16_t>(description.mask);
+    instruction.weight    = description.weight;
+    tape.push_back(instruction);
+    return used;
+}
+
+Controller::GraphInstance Controller::CompiledGraph::createInstance() const {
+    GraphInstance instance = {};
+    instance.parameters = parameterDefaults;
+    instance.clipTimes.assign(clips.size(), 0.0);
+    instance.cursors.resize(clips.size());
+    for (size_t i = 0; i < clips.size(); ++i) {
+        instance.cursors[i].assign(clips[i]->getTrackCount(), {});
+    }
+    instance.registers.assign(registerCount * 2, restPose);
+    return instance;
+}
+
+void Controller::CompiledGraph::advance(GraphInstance &instance, double dt) const {
+    for (size_t i = 0; i < clips.size(); ++i) {
+        double length = clips[i]->getLength();
+        double &time  = instance.clipTimes[i];
+        time += dt * clipSpeeds[i];
+        if (length > 0.0 && (time > length || time < 0.0)) {
+            time = std::fmod(time, length);
+            time += time < 0.0 ? length : 0.0;
+        }
+    }
+
+    if (instance.transition != GRAPH_NONE) {
+        instance.transitionTime += dt;
+        const auto &transition = transitions[instance.transition];
+        if (instance.transitionTime >= transition.duration) {
+            instance.state      = transition.to;
+            instance.transition = GRAPH_NONE;
+        }
+        return;
+    }
+    auto range = stateTransitions[instance.state];
+    for (size_t i = range.first; i < range.second; ++i) {
+        const auto &transition = transitions[i];
+        float value = instance.parameters[transition.parameter];
+        if (transition.above ? value > transition.threshold : value < transition.threshold) {
+            // The target's clips start from the beginning.
+            auto slots = stateSlotRanges[transition.to];
+            for (size_t slot = slots.first; slot < slots.second; ++slot) {
+                instance.clipTimes[stateSlots[slot]] = 0.0;
+                auto &cursors = instance.cursors[stateSlots[slot]];
+                std::fill(cursors.begin(), cursors.end(), Model::TrackCursor{});
+            }
+            if (transition.duration <= 0.0) {
+                instance.state = transition.to;
+            } else {
+                instance.transition     = i;
+                instance.transitionTime = 0.0;
+            }
+            break;
+        }
+    }
+}
+
+bool Controller::CompiledGraph::execute(GraphInstance &instance) const {
+    bool sampled = runTape(instance.state, instance, 0);
+    if (instance.transition != GRAPH_NONE) {
+        const auto &transition = transitions[instance.transition];
+        sampled = runTape(transition.to, instance, registerCount) && sampled;
+        auto progression = static_cast<float>(instance.transitionTime / transition.duration);
+        Model::Pose::blend(instance.registers[registerCount], std::min(progression, 1.0f),
+                           nullptr, instance.registers[0]);
+    }
+    return sampled;
+}
+
+bool Controller::CompiledGraph::runTape(size_t state, GraphInstance &instance,
+                                        size_t bank) const {
+    bool sampled = true;
+    Model::Pose *registers = &instance.registers[bank];
+    auto range = stateTapes[state];
+    for (size_t i = range.first; i < range.second; ++i) {
+        const auto &instruction = tape[i];
+        auto &target = registers[instruction.target];
+        switch (instruction.op) {
+            case GraphOp::SAMPLE: {
+                const auto &rest    = *clipRestPoses[instruction.slot];
+                target.translations = rest.translations;
+                target.rotations    = rest.rotations;
+                sampled = clips[instruction.slot]->sample(instance.clipTimes[instruction.slot],
+                                                          instance.cursors[instruction.slot],
+                                                          target) && sampled;
+            } break;
+            case GraphOp::BLEND: {
+                Model::Pose::blend(registers[instruction.source], getWeight(instruction, instance),
+                                   nullptr, target);
+            } break;
+            case GraphOp::BLEND_MASKED: {
+                Model::Pose::blend(registers[instruction.source], getWeight(instruction, instance),
+                                   masks[instruction.mask].data(), target);
+            } break;
+        }
+    }
+    return sampled;
+}
+
+float Controller::CompiledGraph::getWeight(const GraphInstruction &instruction,
+                                           const GraphInstance &instance) const {
+    float weight = instruction.parameter == GRAPH_NONE
+                       ? instruction.weight
+                       : instance.parameters[instruction.parameter];
+    return std::clamp(weight, 0.0f, 1.0f);
+}
+
+const std::vector<Controller::GraphInstruction> &Controller::CompiledGraph::getTape() const {
+    return tape;
+}
+
+size_t Controller::CompiledGraph::getRegisterCount() const {
+    return registerCount;
+}
+
+size_t Controller::CompiledGraph::getStateCount() const {
+    return stateTapes.size();
+}
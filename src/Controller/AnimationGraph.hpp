@@ -0,0 +1,249 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include "Model/Models/Animation.hpp"
+#include "Model/Models/Pose.hpp"
+#include "Model/Models/Skeleton.hpp"
+
+namespace Controller {
+    /// Marks an unused parameter or mask slot in a graph instruction.
+    constexpr uint16_t GRAPH_NONE = 0xffff;
+
+    /**
+     * Operation of one tape instruction, every operation writes into its target register.
+     */
+    enum class GraphOp : uint8_t {
+        /// Samples clip slot into target.
+        SAMPLE,
+        /// Blends source over target.
+        BLEND,
+        /// Blends source over target scaled by per joint weights.
+        BLEND_MASKED
+    };
+
+    /**
+     * One step of a compiled graph. Registers are indices into the instance's pose registers.
+     */
+    struct GraphInstruction {
+        GraphOp op = GraphOp::SAMPLE;
+        uint8_t target = 0;
+        uint8_t source = 0;
+        /// Clip slot sampled by SAMPLE.
+        uint16_t slot = 0;
+        /// Parameter that drives the blend weight, GRAPH_NONE to use weight.
+        uint16_t parameter = GRAPH_NONE;
+        /// Mask used by BLEND_MASKED.
+        uint16_t mask = GRAPH_NONE;
+        float weight = 0.0f;
+    };
+
+    /**
+     * Per character state of a compiled graph. Every buffer is sized once by
+     * CompiledGraph::createInstance, evaluation does not allocate.
+     */
+    struct GraphInstance {
+        std::vector<float> parameters = {};
+        size_t state = 0;
+        /// Index of the running transition, or GRAPH_NONE.
+        size_t transition = GRAPH_NONE;
+        double transitionTime = 0.0;
+        /// Playback time of each clip slot.
+        std::vector<double> clipTimes = {};
+        std::vector<std::vector<Model::TrackCursor>> cursors = {};
+        /// Pose registers, the result of an evaluation is left in register 0.
+        std::vector<Model::Pose> registers = {};
+    };
+
+    class CompiledGraph;
+
+    /**
+     * Description of a state machine whose states are blend trees. Nodes are referred to by
+     * the index returned when they are added. The description is compiled into a flat tape
+     * before use, see CompiledGraph.
+     */
+    class AnimationGraph {
+      public:
+        /**
+         * Adds a parameter that blends and transitions can read.
+         * @param name of the parameter.
+         * @param defaultValue value new instances start with.
+         * @return index of the parameter.
+         */
+        size_t addParameter(const std::string &name, float defaultValue = 0.0f);
+        /**
+         * Adds a node that plays a clip.
+         * @param clip to play, must outlive the compiled graph.
+         * @param speed playback rate.
+         * @return index of the node.
+         */
+        size_t addClip(const Model::Animation *clip, float speed = 1.0f);
+        /**
+         * Adds a node that blends two nodes with a weight read from a parameter.
+         * @param first node at weight 0.
+         * @param second node at weight 1.
+         * @param parameter index of the weight parameter.
+         * @return index of the node.
+         */
+        size_t addBlend(size_t first, size_t second, size_t parameter);
+        /**
+         * Adds a node that blends two nodes with a constant weight.
+         * @param first node at weight 0.
+         * @param second node at weight 1.
+         * @param weight of second.
+         * @return index of the node.
+         */
+        size_t addFixedBlend(size_t first, size_t second, float weight);
+        /**
+         * Adds a node that layers one node over another on a subset of joints.
+         * @param base node below the layer.
+         * @param layer node blended over base.
+         * @param parameter index of the weight parameter, or GRAPH_NONE for full weight.
+         * @param jointWeights per joint scale of the weight, see Skeleton::buildSubtreeMask.
+         * @return index of the node.
+         */
+        size_t addMaskedBlend(size_t base, size_t layer, size_t parameter,
+                              std::vector<float> jointWeights);
+        /**
+         * Adds a state evaluating a blend tree.
+         * @param name of the state.
+         * @param root node of the state's tree.
+         * @return index of the state, the first state added is the entry state.
+         */
+        size_t addState(const std::string &name, size_t root);
+        /**
+         * Adds a transition taken when a parameter crosses a threshold. Transitions are tested
+         * in the order they were added.
+         * @param from state index.
+         * @param to state index.
+         * @param parameter index of the tested parameter.
+         * @param threshold value the parameter is compared with.
+         * @param above take the transition when the parameter is above rather than below.
+         * @param duration of the crossfade between the states in seconds.
+         */
+        void addTransition(size_t from, size_t to, size_t parameter, float threshold, bool above,
+                           double duration);
+
+        int findParameter(const std::string &name) const;
+        int findState(const std::string &name) const;
+
+        /**
+         * Flattens every state into a tape of instructions.
+         * @param skeleton the clips animate.
+         * @return the compiled graph.
+         */
+        CompiledGraph compile(const Model::Skeleton &skeleton) const;
+
+      private:
+        enum class NodeType { CLIP, BLEND, MASKED_BLEND };
+        struct Node {
+            NodeType type = NodeType::CLIP;
+            const Model::Animation *clip = nullptr;
+            float speed = 1.0f;
+            size_t first = 0;
+            size_t second = 0;
+            size_t parameter = GRAPH_NONE;
+            float weight = 0.0f;
+            size_t mask = GRAPH_NONE;
+        };
+        struct Transition {
+            size_t from = 0;
+            size_t to = 0;
+            size_t parameter = 0;
+            float threshold = 0.0f;
+            bool above = true;
+            double duration = 0.0;
+        };
+
+        std::vector<std::string> parameterNames = {};
+        std::vector<float> parameterDefaults = {};
+        std::vector<Node> nodes = {};
+        std::vector<std::vector<float>> masks = {};
+        std::vector<std::string> stateNames = {};
+        std::vector<size_t> stateRoots = {};
+        std::vector<Transition> transitions = {};
+
+        friend class CompiledGraph;
+    };
+
+    /**
+     * A graph flattened into one instruction tape. Each state owns a contiguous range of the
+     * tape whose result ends up in register 0; while a transition runs the target state is
+     * evaluated into a second bank of registers and crossfaded in. Instances sharing a graph
+     * share the tape, clips and masks, and only carry their own registers and times.
+     * AnimationSystem updates the animators of one graph back to back, so a batch of them
+     * works through the same tape. Every state has its own clip slots.
+     */
+    class CompiledGraph {
+      public:
+        CompiledGraph() = default;
+        /**
+         * Compiles a graph, see AnimationGraph::compile.
+         * @param graph description to compile.
+         * @param skeleton the clips animate.
+         */
+        CompiledGraph(const AnimationGraph &graph, const Model::Skeleton &skeleton);
+
+        /**
+         * Creates the state of one character playing the graph, sized for every register.
+         * @return an instance in the entry state.
+         */
+        GraphInstance createInstance() const;
+        /**
+         * Advances clip times and starts or finishes transitions.
+         * @param instance to advance.
+         * @param dt the time step.
+         */
+        void advance(GraphInstance &instance, double dt) const;
+        /**
+         * Runs the tape of the instance's state, and of its transition target if one is
+         * running, leaving the pose in register 0.
+         * @param instance to evaluate.
+         * @return false if a clip could not be sampled, see Model::Animation::sample.
+         */
+        bool execute(GraphInstance &instance) const;
+
+        const std::vector<GraphInstruction> &getTape() const;
+        /// Registers used by one state, instances hold twice as many for transitions.
+        size_t getRegisterCount() const;
+        size_t getStateCount() const;
+
+      private:
+        struct CompiledTransition {
+            size_t to = 0;
+            uint16_t parameter = 0;
+            float threshold = 0.0f;
+            bool above = true;
+            double duration = 0.0;
+        };
+
+        std::vector<GraphInstruction> tape = {};
+        /// Range of the tape evaluating each state.
+        std::vector<std::pair<size_t, size_t>> stateTapes = {};
+        /// Range of stateSlots holding the clip slots of each state.
+        std::vector<std::pair<size_t, size_t>> stateSlotRanges = {};
+        std::vector<uint16_t> stateSlots = {};
+        /// Range of transitions leaving each state.
+        std::vector<std::pair<size_t, size_t>> stateTransitions = {};
+        std::vector<CompiledTransition> transitions = {};
+        std::vector<const Model::Animation *> clips = {};
+        /// Pose each clip slot starts sampling from, see Animation::getRestPose.
+        std::vector<const Model::Pose *> clipRestPoses = {};
+        std::vector<float> clipSpeeds = {};
+        std::vector<std::vector<float>> masks = {};
+        std::vector<float> parameterDefaults = {};
+        /// Bind pose instances start in.
+        Model::Pose restPose = {};
+        size_t registerCount = 1;
+
+        /**
+         * Emits the instructions evaluating a node into a register.
+         * @return the highest register used.
+         */
+        size_t compileNode(const AnimationGraph &graph, const Model::Skeleton &skeleton,
+                           size_t node, size_t target, std::vector<uint16_t> &nodeSlots);
+        bool runTape(size_t state, GraphInstance &instance, size_t bank) const;
+        float getWeight(const GraphInstruction &instruction, const GraphInstance &instance) const;
+    };
+}
@@ -0,0 +1,58 @@
+#include "AnimationLod.hpp"
+
+#include <cmath>
+
+Controller::AnimationLodPolicy::AnimationLodPolicy(const LodSettings &newSettings)
+    : settings(newSettings) {}
+
+Controller::AnimationLod Controller::AnimationLodPolicy::select(float screenSize,
+                                                                bool visible) const {
+    if (!visible) {
+        return AnimationLod::CULLED;
+    }
+    if (screenSize >= settings.fullRateSize) {
+        return AnimationLod::FULL;
+    }
+    if (screenSize >= settings.halfRateSize) {
+        return AnimationLod::HALF_RATE;
+    }
+    return AnimationLod::QUARTER_RATE;
+}
+
+bool Controller::AnimationLodPolicy::useReducedJoints(float screenSize) const {
+    return screenSize < settings.reducedJointSize;
+}
+
+size_t Controller::AnimationLodPolicy::getUpdateInterval(AnimationLod lod) {
+    switch (lod) {
+        case AnimationLod::FULL: return 1;
+        case AnimationLod::HALF_RATE: return 2;
+        case AnimationLod::QUARTER_RATE: return 4;
+        case AnimationLod::CULLED: return 0;
+    }
+    return 1;
+}
+
+float Controller::AnimationLodPolicy::screenSize(const glm::vec3 &center, float radius,
+                                                 const glm::mat4 &view, float fovY) {
+    float distance = glm::length(glm::vec3(view * glm::vec4(center, 1.0f)));
+    if (distance <= radius) {
+        return 1.0f;
+    }
+    return radius / (distance * std::tan(fovY * 0.5f));
+}
+
+bool Controller::AnimationLodPolicy::isVisible(const glm::vec3 &center, float radius,
+                                               const glm::mat4 &viewProjection) {
+    // Gribb-Hartmann plane extraction, rows of the matrix are columns in glm.
+    glm::mat4 m = glm::transpose(viewProjection);
+    const glm::vec4 planes[6] = {m[3] + m[0], m[3] - m[0], m[3] + m[1],
+                                 m[3] - m[1], m[3] + m[2], m[3] - m[2]};
+    for (const auto &plane : planes) {
+        float length = glm::length(glm::vec3(plane));
+        if (glm::dot(glm::vec3(plane), center) + plane.w < -radius * length) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <glm/glm.hpp>
+
+namespace Controller {
+    /**
+     * How much work an animator does per tick.
+     */
+    enum class AnimationLod { FULL, HALF_RATE, QUARTER_RATE, CULLED };
+
+    /// Number of AnimationLod levels.
+    constexpr size_t ANIMATION_LOD_COUNT = 4;
+
+    /**
+     * Screen-size thresholds for choosing a level, sizes are the projected diameter of the
+     * instance's bounding sphere as a fraction of the viewport height.
+     */
+    struct LodSettings {
+        /// Instances at least this size are evaluated every tick.
+        float fullRateSize = 0.2f;
+        /// Instances at least this size are evaluated every second tick, smaller ones every fourth.
+        float halfRateSize = 0.05f;
+        /// Instances smaller than this only evaluate the reduced joint set.
+        float reducedJointSize = 0.1f;
+        /// Fraction of the root's reach a joint needs to be part of the reduced joint set.
+        float reducedJointReach = 0.15f;
+    };
+
+    /**
+     * Per-level counts gathered by one AnimationSystem update.
+     */
+    struct LodStats {
+        /// Animators assigned to each level.
+        std::array<size_t, ANIMATION_LOD_COUNT> instances = {};
+        /// Animators of each level that sampled their clip this frame.
+        std::array<size_t, ANIMATION_LOD_COUNT> evaluated = {};
+        /// Animators that evaluated the reduced joint set this frame.
+        size_t reducedJoints = 0;
+    };
+
+    /**
+     * Picks an animation level of detail from how large and whether an instance is on screen.
+     */
+    class AnimationLodPolicy {
+      public:
+        LodSettings settings = {};
+
+        AnimationLodPolicy() = default;
+        explicit AnimationLodPolicy(const LodSettings &newSettings);
+
+        /**
+         * Selects the level for an instance.
+         * @param screenSize projected size, see screenSize.
+         * @param visible false if the instance is outside the view frustum.
+         * @return the level to animate at.
+         */
+        AnimationLod select(float screenSize, bool visible) const;
+        /**
+         * Whether the reduced joint set should be evaluated at a size.
+         * @param screenSize projected size, see screenSize.
+         * @return true if small joints can be frozen.
+         */
+        bool useReducedJoints(float screenSize) const;
+
+        /**
+         * Number of ticks between evaluations at a level.
+         * @param lod the level.
+         * @return 1, 2 or 4, or 0 for culled instances which are never evaluated.
+         */
+        static size_t getUpdateInterval(AnimationLod lod);
+        /**
+         * Projected diameter of a bounding sphere as a fraction of the viewport height.
+         * @param center of the sphere in world space.
+         * @param radius of the sphere in world space.
+         * @param view matrix of the camera.
+         * @param fovY vertical field of view in radians.
+         * @return the projected size, 1 or more if the camera is inside the sphere.
+         */
+        static float screenSize(const glm::vec3 &center, float radius, const glm::mat4 &view,
+                                float fovY);
+        /**
+         * Tests a bounding sphere against the planes of a view frustum.
+         * @param center of the sphere in world space.
+         * @param radius of the sphere in world space.
+         * @param viewProjection matrix of the camera.
+         * @return false if the sphere is entirely outside the frustum.
+         */
+        static bool isVisible(const glm::vec3 &center, float radius,
+                              const glm::mat4 &viewProjection);
+    };
+}
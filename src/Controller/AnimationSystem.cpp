@@ -0,0 +1,155 @@
+#include "AnimationSystem.hpp"
+
+#include <algorithm>
+#include <functional>
+
+Controller::AnimationSystem::AnimationSystem() : AnimationSystem(0, 16) {}
+
+Controller::AnimationSystem::AnimationSystem(size_t threadCount, size_t newBatchSize) {
+    batchSize = std::max<size_t>(newBatchSize, 1);
+    if (threadCount == 0) {
+        threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    // The thread calling update works through batches as well.
+    for (size_t i = 1; i < threadCount; ++i) {
+        workers.emplace_back(&AnimationSystem::workerLoop, this);
+    }
+}
+
+Controller::AnimationSystem::~AnimationSystem() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto &worker : workers) {
+        worker.join();
+    }
+}
+
+void Controller::AnimationSystem::add(std::shared_ptr<Animator> animator) {
+    animator->poseCache = sharePoses ? &poseCache : nullptr;
+    animators.push_back(std::move(animator));
+}
+
+void Controller::AnimationSystem::remove(const std::shared_ptr<Animator> &animator) {
+    animators.erase(std::remove(animators.begin(), animators.end(), animator), animators.end());
+}
+
+void Controller::AnimationSystem::update(double t, double dt) {
+    if (animators.empty()) {
+        return;
+    }
+    poseCache.beginFrame();
+    // Animators playing the same graph run back to back, so each batch works through one
+    // tape and one set of clips.
+    auto byGraph = [](const std::shared_ptr<Animator> &a, const std::shared_ptr<Animator> &b) {
+        return std::less<const CompiledGraph *>()(a->graph.get(), b->graph.get());
+    };
+    if (!std::is_sorted(animators.begin(), animators.end(), byGraph)) {
+        std::sort(animators.begin(), animators.end(), byGraph);
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        frameTime  = t;
+        frameDelta = dt;
+        batchCount = (animators.size() + batchSize - 1) / batchSize;
+        nextBatch  = 0;
+        remainingBatches = batchCount;
+        finishedWorkers  = 0;
+        ++generation;
+    }
+    wake.notify_all();
+    runBatches();
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        // Every worker has to be done with this generation, one waking late would otherwise
+        // claim a batch of the next update while its batch count is being written.
+        finished.wait(lock, [this] {
+            return remainingBatches == 0 && finishedWorkers == workers.size();
+        });
+    }
+    lodStats = {};
+    for (const auto &animator : animators) {
+        auto level = static_cast<size_t>(animator->lod);
+        ++lodStats.instances[level];
+        if (animator->evaluatedLastUpdate) {
+            ++lodStats.evaluated[level];
+            lodStats.reducedJoints += animator->reducedJoints ? 1 : 0;
+        }
+    }
+}
+
+void Controller::AnimationSystem::applyLod(Animator &animator, float screenSize,
+                                           bool visible) const {
+    animator.setLod(lodPolicy.select(screenSize, visible), lodPolicy.useReducedJoints(screenSize),
+                    lodPolicy.settings.reducedJointReach);
+}
+
+const std::vector<std::shared_ptr<Controller::Animator>> &
+Controller::AnimationSystem::getAnimators() const {
+    return animators;
+}
+
+size_t Controller::AnimationSystem::getThreadCount() const {
+    return workers.size() + 1;
+}
+
+const Controller::LodStats &Controller::AnimationSystem::getLodStats() const {
+    return lodStats;
+}
+
+void Controller::AnimationSystem::setPoseSharing(bool enabled) {
+    sharePoses = enabled;
+    for (auto &animator : animators) {
+        animator->poseCache = sharePoses ? &poseCache : nullptr;
+    }
+}
+
+Controller::PoseCache &Controller::AnimationSystem::getPoseCache() {
+    return poseCache;
+}
+
+void Controller::AnimationSystem::setPaletteEncoding(Model::PaletteEncoding encoding) {
+    paletteEncoding = encoding;
+}
+
+Model::PaletteEncoding Controller::AnimationSystem::getPaletteEncoding() const {
+    return paletteEncoding;
+}
+
+void Controller::AnimationSystem::workerLoop() {
+    size_t seenGeneration = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || generation != seenGeneration; });
+            if (stopping) {
+                return;
+            }
+            seenGeneration = generation;
+        }
+        runBatches();
+        std::lock_guard<std::mutex> lock(mutex);
+        ++finishedWorkers;
+        finished.notify_all();
+    }
+}
+
+void Controller::AnimationSystem::runBatches() {
+    while (true) {
+        size_t batch = nextBatch.fetch_add(1);
+        if (batch >= batchCount) {
+            return;
+        }
+        size_t end = std::min(animators.size(), (batch + 1) * batchSize);
+        for (size_t i = batch * batchSize; i < end; ++i) {
+            animators[i]->update(frameTime, frameDelta);
+            animators[i]->encodePalette(paletteEncoding);
+        }
+        if (remainingBatches.fetch_sub(1) == 1) {
+            std::lock_guard<std::mutex> lock(mutex);
+            finished.notify_all();
+        }
+    }
+}
@@ -0,0 +1,124 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Controller/AnimationLod.hpp"
+#include "Controller/Animator.hpp"
+#include "Controller/PoseCache.hpp"
+#include "Model/Models/PaletteEncoding.hpp"
+
+namespace Controller {
+    /**
+     * Owns every active animator and updates them in batches across a pool of worker threads.
+     * Animators only write to their own pose and palette buffers and read shared model data, so
+     * the result of an update does not depend on the thread count or on scheduling.
+     */
+    class AnimationSystem {
+      public:
+        /**
+         * Starts one thread per hardware thread.
+         */
+        AnimationSystem();
+        /**
+         * Starts the worker threads.
+         * @param threadCount total threads used by an update including the caller, 0 picks one
+         * per hardware thread.
+         * @param newBatchSize animators updated per job.
+         */
+        AnimationSystem(size_t threadCount, size_t newBatchSize);
+        /**
+         * Stops and joins the worker threads.
+         */
+        ~AnimationSystem();
+        AnimationSystem(const AnimationSystem &) = delete;
+        AnimationSystem &operator=(const AnimationSystem &) = delete;
+
+        /**
+         * Registers an animator, it is updated by every following call to update.
+         * @param animator to add.
+         */
+        void add(std::shared_ptr<Animator> animator);
+        /**
+         * Unregisters an animator.
+         * @param animator to remove.
+         */
+        void remove(const std::shared_ptr<Animator> &animator);
+
+        /**
+         * Updates every registered animator and returns once all of them are done.
+         * Must not be called while another update is running.
+         * @param t the total time.
+         * @param dt the time step.
+         */
+        void update(double t, double dt);
+
+        /**
+         * Chooses an animator's level of detail from its size on screen, see AnimationLodPolicy.
+         * @param animator to change.
+         * @param screenSize projected size of the instance.
+         * @param visible false if the instance is outside the view frustum.
+         */
+        void applyLod(Animator &animator, float screenSize, bool visible) const;
+
+        const std::vector<std::shared_ptr<Animator>> &getAnimators() const;
+        size_t getThreadCount() const;
+        /**
+         * Counts of how many animators ran at each level during the last update.
+         * @return the stats of the last update.
+         */
+        const LodStats &getLodStats() const;
+        /**
+         * Makes every registered animator, and every one added later, share evaluated poses
+         * through the system's pose cache, or stop doing so.
+         * @param enabled whether poses are shared.
+         */
+        void setPoseSharing(bool enabled);
+        /**
+         * The cache used when pose sharing is on, for its quantum and hit and miss counters.
+         * @return the pose cache.
+         */
+        PoseCache &getPoseCache();
+        /**
+         * Sets the encoding the renderer's PaletteStream uses. Every animator converts its
+         * palette to it at the end of its update, on the worker that updated it, see
+         * Animator::encodePalette.
+         * @param encoding of the palettes drawn, MATRIX skips the conversion.
+         */
+        void setPaletteEncoding(Model::PaletteEncoding encoding);
+        Model::PaletteEncoding getPaletteEncoding() const;
+
+        /// Thresholds used by applyLod.
+        AnimationLodPolicy lodPolicy = {};
+
+      private:
+        /// Animators updated each tick, grouped by graph.
+        std::vector<std::shared_ptr<Animator>> animators = {};
+        std::vector<std::thread> workers = {};
+        size_t batchSize = 16;
+        LodStats lodStats = {};
+        PoseCache poseCache = {};
+        bool sharePoses = false;
+        Model::PaletteEncoding paletteEncoding = Model::PaletteEncoding::MATRIX;
+
+        std::mutex mutex = {};
+        std::condition_variable wake = {};
+        std::condition_variable finished = {};
+        /// Bumped once per update so sleeping workers know there is new work.
+        size_t generation = 0;
+        bool stopping = false;
+        /// Workers done with the current generation.
+        size_t finishedWorkers = 0;
+
+        double frameTime = 0.0;
+        double frameDelta = 0.0;
+        size_t batchCount = 0;
+        std::atomic<size_t> nextBatch = 0;
+        std::atomic<size_t> remainingBatches = 0;
+
+        void workerLoop();
+        void runBatches();
+    };
+}
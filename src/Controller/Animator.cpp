@@ -1,19 +1,388 @@
-
 #include "Animator.hpp"
-#include "Model/Models/JointTransform.hpp"
+
+#include <algorithm>
+#include <cmath>
 #include "Model/Models/Model.hpp"
+Controller::Animator::Animator(Model::Model *model) {
+    animatedModel = model;
+    skeleton = model->skeleton;
+    currentPose = Model::Pose(skeleton->size());
+    previousPose = currentPose;
+    transitionTarget = currentPose;
+    modelTransforms.assign(skeleton->size(), glm::mat4(1.0f));
+    jointTransforms.assign(skeleton->getBoneCount(), glm::mat4(1.0f));
+    evaluatedPalette = jointTransforms;
+    previousPalette  = jointTransforms;
+    morphWeights.assign(model->morphTargetNames.size(), 0.0f);
+    for (auto &layer : layers) {
+        layer.pose = currentPose;
+    }
+    inertializer.resize(skeleton->size());
+}
 void Controller::Animator::queAnimation(Model::Animation* newAnimation) {
     animationTime = 0;
     animation = newAnimation;
+    if (skeleton == nullptr) {
+        skeleton = animatedModel->skeleton;
+    }
+    // Joints the new clip does not animate are held at its rest pose.
+    currentPose = animation->getRestPose(*skeleton);
+    previousPose = currentPose;
+    transitionTarget = currentPose;
+    poseModified = false;
+    cursors.assign(animation->getTrackCount(), {});
+    layerCount = 0;
+    needsEvaluation = true;
+    previousPoseValid = false;
+}
+void Controller::Animator::crossFade(Model::Animation *newAnimation, double duration) {
+    if (animation == nullptr || duration <= 0.0 || layerCount == MAX_LAYERS) {
+        queAnimation(newAnimation);
+        return;
+    }
+    // Crossfades stack directly above the base, under any other layer, so overlays such as an
+    // upper body layer keep playing on top.
+    size_t position = 0;
+    while (position < layerCount && layers[position].replacesBase) {
+        ++position;
+    }
+    size_t index = addLayer(newAnimation, 0.0f);
+    std::rotate(layers.begin() + static_cast<std::ptrdiff_t>(position),
+                layers.begin() + static_cast<std::ptrdiff_t>(index),
+                layers.begin() + static_cast<std::ptrdiff_t>(index) + 1);
+    layers[position].replacesBase = true;
+    fadeLayer(position, 1.0f, duration);
+}
+void Controller::Animator::inertialize(Model::Animation *newAnimation, double duration) {
+    if (animation != nullptr && sharedPalette != nullptr && !previousPoseValid) {
+        restoreSharedPose();
+    }
+    if (animation == nullptr || duration <= 0.0 || !previousPoseValid) {
+        queAnimation(newAnimation);
+        return;
+    }
+    // currentPose keeps the shown pose, so a second transition before the next evaluation
+    // still starts from it.
+    const auto &rest = newAnimation->getRestPose(*skeleton);
+    transitionTarget.translations = rest.translations;
+    transitionTarget.rotations    = rest.rotations;
+    cursors.assign(newAnimation->getTrackCount(), {});
+    if (!newAnimation->sample(0.0, cursors, transitionTarget)) {
+        queAnimation(newAnimation);
+        return;
+    }
+    inertializer.begin(currentPose, previousPose, evaluationSpacing, transitionTarget, duration);
+    animation      = newAnimation;
+    animationTime  = 0;
+    lastSampleTime = 0.0;
+    layerCount     = 0;
+    poseModified   = true;
+    needsEvaluation = true;
+}
+void Controller::Animator::transitionTo(Model::Animation *newAnimation, double duration) {
+    if (transitionMode == TransitionMode::INERTIALIZE) {
+        inertialize(newAnimation, duration);
+    } else {
+        crossFade(newAnimation, duration);
+    }
+}
+size_t Controller::Animator::addLayer(Model::Animation *clip, float weight,
+                                      const float *jointWeights) {
+    if (layerCount == MAX_LAYERS || clip == nullptr) {
+        return MAX_LAYERS;
+    }
+    auto &layer = layers[layerCount];
+    layer.animation    = clip;
+    layer.time         = 0.0;
+    layer.weight       = weight;
+    layer.targetWeight = weight;
+    layer.fadeSpeed    = 0.0f;
+    layer.jointWeights = jointWeights;
+    layer.replacesBase = false;
+    layer.cursors.assign(clip->getTrackCount(), {});
+    layer.pose.resize(skeleton->size());
+    return layerCount++;
+}
+void Controller::Animator::fadeLayer(size_t layer, float weight, double duration) {
+    if (layer >= layerCount) {
+        return;
+    }
+    auto &faded = layers[layer];
+    faded.targetWeight = weight;
+    if (duration <= 0.0) {
+        faded.weight    = weight;
+        faded.fadeSpeed = 0.0f;
+    } else {
+        faded.fadeSpeed = static_cast<float>(std::abs(weight - faded.weight) / duration);
+    }
+}
+void Controller::Animator::removeLayer(size_t layer) {
+    if (layer >= layerCount) {
+        return;
+    }
+    // Rotating swaps buffers rather than copying them, so nothing is reallocated.
+    std::rotate(layers.begin() + static_cast<std::ptrdiff_t>(layer),
+                layers.begin() + static_cast<std::ptrdiff_t>(layer) + 1,
+                layers.begin() + static_cast<std::ptrdiff_t>(layerCount));
+    --layerCount;
+}
+size_t Controller::Animator::getLayerCount() const {
+    return layerCount;
+}
+const Controller::AnimationLayer &Controller::Animator::getLayer(size_t layer) const {
+    return layers.at(layer);
+}
+void Controller::Animator::updateLayers(double dt) {
+    for (size_t i = 0; i < layerCount;) {
+        auto &layer = layers[i];
+        layer.time += dt;
+        if (layer.time > layer.animation->getLength()) {
+            layer.time = fmod(layer.time, layer.animation->getLength());
+        }
+        bool fadedOut = false;
+        if (layer.fadeSpeed > 0.0f) {
+            auto step = static_cast<float>(layer.fadeSpeed * dt);
+            if (std::abs(layer.targetWeight - layer.weight) <= step) {
+                layer.weight    = layer.targetWeight;
+                layer.fadeSpeed = 0.0f;
+                fadedOut        = layer.weight <= 0.0f;
+            } else {
+                layer.weight += layer.targetWeight > layer.weight ? step : -step;
+            }
+        }
+        if (layer.replacesBase && layer.weight >= 1.0f) {
+            // The base and every older crossfade below are fully covered, so the layer's clip
+            // takes over the base buffers.
+            animation     = layer.animation;
+            animationTime = layer.time;
+            std::swap(cursors, layer.cursors);
+            for (size_t covered = 0; covered <= i; ++covered) {
+                removeLayer(0);
+            }
+            needsEvaluation = true;
+            poseModified    = true;
+            i = 0;
+        } else if (fadedOut) {
+            removeLayer(i);
+        } else {
+            ++i;
+        }
+    }
+}
+bool Controller::Animator::blendLayers(const uint8_t *mask) {
+    bool sampled = true;
+    for (size_t i = 0; i < layerCount; ++i) {
+        auto &layer = layers[i];
+        if (layer.weight <= 0.0f) {
+            continue;
+        }
+        // Layers blend the clip's whole pose, joint weights pick which joints it covers.
+        const auto &rest = layer.animation->getRestPose(*skeleton);
+        layer.pose.translations = rest.translations;
+        layer.pose.rotations    = rest.rotations;
+        if (mask != nullptr) {
+            // Masked joints blend with themselves, so they keep their last value.
+            for (size_t joint = 0; joint < currentPose.size(); ++joint) {
+                if (mask[joint] == 0) {
+                    layer.pose.translations[joint] = currentPose.translations[joint];
+                    layer.pose.rotations[joint]    = currentPose.rotations[joint];
+                }
+            }
+        }
+        sampled = layer.animation->sample(layer.time, layer.cursors, layer.pose, mask) && sampled;
+        Model::Pose::blend(layer.pose, std::min(layer.weight, 1.0f), layer.jointWeights,
+                           currentPose);
+        poseModified = true;
+    }
+    return sampled;
+}
+void Controller::Animator::setLod(AnimationLod newLod, bool useReducedJoints,
+                                  float reducedJointReach) {
+    if (lod == AnimationLod::CULLED && newLod != AnimationLod::CULLED) {
+        // The pose stopped following the clip while culled.
+        needsEvaluation = true;
+        previousPoseValid = false;
+    }
+    lod = newLod;
+    reducedJoints = useReducedJoints;
+    if (reducedJoints && reducedJointReach != reducedMaskReach && skeleton != nullptr) {
+        reducedJointMask = skeleton->buildReducedJointMask(reducedJointReach);
+        reducedMaskReach = reducedJointReach;
+    }
+}
+void Controller::Animator::setGraph(std::shared_ptr<const CompiledGraph> newGraph) {
+    graph = std::move(newGraph);
+    graphInstance = graph != nullptr ? graph->createInstance() : GraphInstance{};
+    needsEvaluation   = true;
+    previousPoseValid = false;
+    poseModified      = true;
+}
+void Controller::Animator::setGraphParameter(size_t parameter, float value) {
+    if (parameter < graphInstance.parameters.size()) {
+        graphInstance.parameters[parameter] = value;
+    }
 }
 void Controller::Animator::update(double t, double dt) {
-    if (animation == nullptr) {
+    if (graph != nullptr) {
+        graph->advance(graphInstance, dt);
+    } else if (animation == nullptr) {
+        return;
+    } else {
+        increaseAnimationTime(dt);
+    }
+    updateLayers(dt);
+    inertializer.advance(dt);
+    ++ticksSinceEvaluation;
+    timeSinceEvaluation += dt;
+    evaluatedLastUpdate = false;
+    posedLastUpdate     = false;
+    sampleMissed        = false;
+    size_t interval = AnimationLodPolicy::getUpdateInterval(lod);
+    if (interval == 0) {
+        // Culled, only keep time moving so the clip is in phase when it becomes visible.
         return;
     }
-    increaseAnimationTime(dt);
-    auto currentPose = calculateCurrentAnimationPose();
-    glm::mat4 newMat(1.0f);
-    applyPoseToJoints(currentPose, *animatedModel->rootJoint, newMat);
+    sampleMorphWeights();
+    if (poseCache != nullptr && graph == nullptr && layerCount == 0 &&
+        !inertializer.isActive() && !postProcessed) {
+        // Shared lookups are cheap, the quantum takes the place of the update interval.
+        evaluateShared();
+    } else if (needsEvaluation || ticksSinceEvaluation >= interval) {
+        evaluate();
+    } else {
+        extrapolate();
+    }
+}
+void Controller::Animator::evaluate() {
+    sharedPalette = nullptr;
+    previousPose.translations = currentPose.translations;
+    previousPose.rotations    = currentPose.rotations;
+    if (!calculateCurrentAnimationPose()) {
+        // Hold the last pose until the streamed page is resident rather than showing a pose
+        // with some joints at rest.
+        currentPose.translations = previousPose.translations;
+        currentPose.rotations    = previousPose.rotations;
+        poseModified    = true;
+        needsEvaluation = true;
+        sampleMissed    = true;
+        return;
+    }
+    // Looping back to the start or resuming from a stale pose gives no usable velocity.
+    bool continuous = previousPoseValid && animationTime >= lastSampleTime;
+    evaluationSpacing = continuous ? timeSinceEvaluation : 0.0;
+    lastSampleTime = animationTime;
+    ticksSinceEvaluation = 0;
+    timeSinceEvaluation = 0.0;
+    needsEvaluation = false;
+    previousPoseValid = true;
+    evaluatedLastUpdate = true;
+    std::swap(previousPalette, evaluatedPalette);
+    applyPoseToJoints(currentPose);
+    evaluatedPalette = jointTransforms;
+}
+void Controller::Animator::evaluateShared() {
+    PoseCache::Key key = {animatedModel, animation, poseCache->getTick(animationTime)};
+    const auto *previousPalette = sharedPalette;
+    sharedPalette = &poseCache->acquire(key, [this, &key](std::vector<glm::mat4> &palette) {
+        resetToRestPose();
+        // Shared poses always sample every joint so they do not depend on which instance
+        // evaluated them.
+        if (!animation->sample(poseCache->getTickTime(key.tick), cursors, currentPose)) {
+            // Everyone sharing the key holds this instance's last pose for the frame.
+            palette      = jointTransforms;
+            sampleMissed = true;
+            poseModified = true;
+            return;
+        }
+        if (rig != nullptr) {
+            rig->evaluate(currentPose, modelTransforms, palette);
+        } else {
+            skeleton->localToModel(currentPose, modelTransforms);
+            skeleton->buildPalette(modelTransforms, palette);
+        }
+    });
+    if (sharedPalette != previousPalette || !(key == sharedKey)) {
+        sharedKey = key;
+        ++poseVersion;
+    }
+    // Cache hits leave currentPose behind, restoreSharedPose rebuilds it when it is needed.
+    needsEvaluation = true;
+    previousPoseValid = false;
+    evaluatedLastUpdate = true;
+}
+void Controller::Animator::restoreSharedPose() {
+    // Resample the shared tick and the one before it, which gives the velocity the shared
+    // poses were shown with.
+    double time         = poseCache->getTickTime(sharedKey.tick);
+    double previousTime = poseCache->getTickTime(sharedKey.tick - 1);
+    const auto &rest    = animation->getRestPose(*skeleton);
+    previousPose.translations = rest.translations;
+    previousPose.rotations    = rest.rotations;
+    currentPose.translations  = rest.translations;
+    currentPose.rotations     = rest.rotations;
+    poseModified = false;
+    bool hasPrevious = previousTime >= 0.0 &&
+                       animation->sample(previousTime, cursors, previousPose);
+    if (!animation->sample(time, cursors, currentPose)) {
+        return;
+    }
+    if (!hasPrevious) {
+        previousPose.translations = currentPose.translations;
+        previousPose.rotations    = currentPose.rotations;
+    }
+    evaluationSpacing = hasPrevious ? time - previousTime : 0.0;
+    lastSampleTime    = time;
+    previousPoseValid = true;
+}
+void Controller::Animator::extrapolate() {
+    // A post process edits the palette after each evaluation, extrapolating would drop its
+    // edits, so those animators hold their last palette.
+    if (evaluationSpacing <= 0.0 || postProcessed) {
+        return;
+    }
+    sharedPalette = nullptr;
+    // Extrapolating the palette skips sampling, the hierarchy and the bone offsets. Over the
+    // few ticks between evaluations the shear this adds to rotations is not visible.
+    auto progression = static_cast<float>(timeSinceEvaluation / evaluationSpacing);
+    for (size_t i = 0; i < jointTransforms.size(); ++i) {
+        jointTransforms[i] =
+            evaluatedPalette[i] + (evaluatedPalette[i] - previousPalette[i]) * progression;
+    }
+    ++poseVersion;
+}
+void Controller::Animator::sampleMorphWeights() {
+    if (morphWeights.empty()) {
+        return;
+    }
+    // Graphs only blend joints, their weights stay at zero.
+    std::fill(morphWeights.begin(), morphWeights.end(), 0.0f);
+    if (graph != nullptr) {
+        return;
+    }
+    animation->sampleMorphWeights(animationTime, morphWeights);
+    // A layer only blends the weights its clip animates, so a body layer leaves the face alone.
+    for (size_t i = 0; i < layerCount; ++i) {
+        const auto &layer = layers[i];
+        float weight = std::min(layer.weight, 1.0f);
+        if (weight <= 0.0f) {
+            continue;
+        }
+        for (const auto &track : layer.animation->morphTracks) {
+            if (track.target < morphWeights.size()) {
+                float &blended = morphWeights[track.target];
+                blended += (Model::sampleMorphWeight(track, layer.time) - blended) * weight;
+            }
+        }
+    }
+}
+void Controller::Animator::setPhase(size_t bucket, size_t bucketCount) {
+    if (animation == nullptr || bucketCount == 0) {
+        return;
+    }
+    animationTime = animation->getLength() * static_cast<double>(bucket % bucketCount) /
+                    static_cast<double>(bucketCount);
+    needsEvaluation = true;
+    previousPoseValid = false;
 }
 void Controller::Animator::increaseAnimationTime(double time) {
     animationTime += time;
@@ -21,67 +390,84 @@ void Controller::Animator::increaseAnimationTime(double time) {
         animationTime = fmod(animationTime, animation->getLength());
     }
 }
-std::map<std::string, glm::mat4> Controller::Animator::calculateCurrentAnimationPose() {
-    std::vector<Model::KeyFrame> frames = getPreviousAndNextFrames();
-    double progression = calculateProgression(frames[0], frames[1]);
-    return interpolatePoses(frames[0], frames[1], progression);
-}
-void Controller::Animator::applyPoseToJoints(std::map<std::string, glm::mat4>& currentPose,
-                                             Model::Joint& joint, glm::mat4 parentTransform) {
-//    glm::mat4 currentLocalTransform = currentPose.at(joint.name);
-//    glm::mat4 currentTransform = parentTransform * currentLocalTransform;
-//    for (Model::Joint& childJoint : joint.children) {
-//        applyPoseToJoints(currentPose, childJoint, currentTransform);
-//    }
-//    currentTransform = currentTransform * joint.getInverseBindTransform();
-//    joint.setAnimationTransform(currentTransform);
-    glm::mat4 NodeTransformation;
-    if (currentPose.count(joint.name)) {
-        NodeTransformation = currentPose.at(joint.name);
+bool Controller::Animator::calculateCurrentAnimationPose() {
+    const uint8_t *mask = reducedJoints && !reducedJointMask.empty() ? reducedJointMask.data()
+                                                                      : nullptr;
+    bool sampled = true;
+    if (graph != nullptr) {
+        // Graph registers restart from the rest pose, so they always sample every joint.
+        sampled = graph->execute(graphInstance);
+        currentPose.translations = graphInstance.registers[0].translations;
+        currentPose.rotations    = graphInstance.registers[0].rotations;
     } else {
-        NodeTransformation = glm::mat4(1.0f);
-    }
-
-    glm::mat4 GlobalTransformation = parentTransform * NodeTransformation;
-    if (animatedModel->boneMapping.find(joint.name) != animatedModel->boneMapping.end()) {
-        unsigned BoneIndex = animatedModel->boneMapping[joint.name];
-        joint.setAnimationTransform(animatedModel->globalInverseTransform * GlobalTransformation *
-                                                                 animatedModel->boneInfo[BoneIndex].BoneOffset);
+        resetToRestPose(mask);
+        sampled = animation->sample(animationTime, cursors, currentPose, mask);
+        sampled = blendLayers(mask) && sampled;
     }
-    for (Model::Joint& childJoint : joint.children) {
-        applyPoseToJoints(currentPose, childJoint, GlobalTransformation);
+    if (inertializer.isActive()) {
+        inertializer.apply(currentPose, mask);
+        poseModified = true;
     }
-
+    return sampled;
 }
-
-std::vector<Model::KeyFrame> Controller::Animator::getPreviousAndNextFrames() {
-    std::vector<Model::KeyFrame> allFrames = animation->getKeyFrames();
-    Model::KeyFrame previousFrame = allFrames[0];
-    Model::KeyFrame nextFrame = allFrames[0];
-    for (int i = 1; i < allFrames.size(); i++) {
-        nextFrame = allFrames[i];
-        if (nextFrame.getTimeStamp() > animationTime) {
-            break;
+void Controller::Animator::resetToRestPose(const uint8_t *mask) {
+    // Only animated channels are sampled, so anything that wrote over the still joints last
+    // tick has to be undone first.
+    if (!poseModified) {
+        return;
+    }
+    const auto &rest = animation->getRestPose(*skeleton);
+    if (mask == nullptr) {
+        currentPose.translations = rest.translations;
+        currentPose.rotations    = rest.rotations;
+        poseModified = false;
+        return;
+    }
+    // Masked joints hold their last value, they are reset once the mask is lifted.
+    for (size_t joint = 0; joint < currentPose.size(); ++joint) {
+        if (mask[joint] != 0) {
+            currentPose.translations[joint] = rest.translations[joint];
+            currentPose.rotations[joint]    = rest.rotations[joint];
         }
-        previousFrame = allFrames[i];
-    }
-    return std::vector<Model::KeyFrame> { previousFrame, nextFrame };
-}
-double Controller::Animator::calculateProgression(const Model::KeyFrame& previousFrame,
-                                                 const Model::KeyFrame& nextFrame) {
-    double totalTime = nextFrame.getTimeStamp() - previousFrame.getTimeStamp();
-    double currentTime = animationTime - previousFrame.getTimeStamp();
-    return currentTime / totalTime;
-}
-std::map<std::string, glm::mat4> Controller::Animator::interpolatePoses(Model::KeyFrame& previousFrame,
-                                                                        Model::KeyFrame& nextFrame,
-                                                                        double progression) {
-    std::map<std::string, glm::mat4> currentPose = {};
-    for (auto& jointName : previousFrame.getJointKeyFrames()) {
-        Model::JointTransform previousTransform = previousFrame.getJointKeyFrames().at(jointName.first);
-        Model::JointTransform nextTransform = nextFrame.getJointKeyFrames().at(jointName.first);
-        Model::JointTransform currentTransform = Model::JointTransform::interpolate(previousTransform, nextTransform, static_cast<float>(progression));
-        currentPose.emplace(jointName.first, currentTransform.getLocalTransform());
-    }
-    return currentPose;
+    }
+}
+void Controller::Animator::applyPoseToJoints(const Model::Pose& pose) {
+    if (rig != nullptr) {
+        rig->evaluate(pose, modelTransforms, jointTransforms);
+    } else {
+        skeleton->localToModel(pose, modelTransforms);
+        skeleton->buildPalette(modelTransforms, jointTransforms);
+    }
+    posedLastUpdate = true;
+    ++poseVersion;
+}
+void Controller::Animator::refreshPalette() {
+    sharedPalette = nullptr;
+    skeleton->buildPalette(modelTransforms, jointTransforms);
+    ++poseVersion;
+    if (encodedEncoding != Model::PaletteEncoding::MATRIX) {
+        encodePalette(encodedEncoding);
+    }
+}
+void Controller::Animator::encodePalette(Model::PaletteEncoding encoding) {
+    encodedPalette.clear();
+    encodedEncoding = encoding;
+    encodedVersion  = poseVersion;
+    if (encoding != Model::PaletteEncoding::MATRIX && sharedPalette == nullptr) {
+        Model::encodePalette(jointTransforms.data(), jointTransforms.size(), encoding,
+                             encodedPalette);
+    }
+}
+const std::vector<glm::mat4> &Controller::Animator::getJointTransforms() const {
+    return sharedPalette != nullptr ? *sharedPalette : jointTransforms;
+}
+const std::vector<uint32_t> *
+Controller::Animator::getEncodedPalette(Model::PaletteEncoding encoding) const {
+    // A palette that changed since it was converted, or was converted for another stream, is
+    // never handed out.
+    if (encoding == Model::PaletteEncoding::MATRIX || encoding != encodedEncoding ||
+        encodedVersion != poseVersion || sharedPalette != nullptr) {
+        return nullptr;
+    }
+    return &encodedPalette;
 }
@@ -1,28 +1,280 @@
 #pragma once
-#include <string>
-#include <map>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "Controller/AnimationGraph.hpp"
+#include "Controller/AnimationLod.hpp"
+#include "Controller/FixedRig.hpp"
+#include "Controller/Inertializer.hpp"
+#include "Controller/PoseCache.hpp"
 #include "Model/Models/Animation.hpp"
-#include "Model/Models/Joint.hpp"
+#include "Model/Models/PaletteEncoding.hpp"
+#include "Model/Models/Pose.hpp"
+#include "Model/Models/Skeleton.hpp"
 namespace Model {
     class Model;
 
 }
 
 namespace Controller {
+    /**
+     * A clip blended over the animator's base clip. Layers own their cursors and pose buffer so
+     * evaluating them does not allocate.
+     */
+    struct AnimationLayer {
+        Model::Animation *animation = nullptr;
+        double time = 0.0;
+        float weight = 0.0f;
+        /// Weight the layer fades towards.
+        float targetWeight = 0.0f;
+        /// Weight change per second while fading, zero when the layer is not fading.
+        float fadeSpeed = 0.0f;
+        /// Optional weight per joint scaling the layer weight, owned by the caller.
+        const float *jointWeights = nullptr;
+        /// Crossfade layer that becomes the base clip once fully faded in.
+        bool replacesBase = false;
+        std::vector<Model::TrackCursor> cursors = {};
+        Model::Pose pose = {};
+    };
+
+    /**
+     * How transitionTo blends between clips.
+     */
+    enum class TransitionMode {
+        /// Samples both clips while fading, see Animator::crossFade.
+        CROSSFADE,
+        /// Samples only the new clip and decays the difference, see Animator::inertialize.
+        INERTIALIZE
+    };
+
     class Animator {
       public:
         Model::Model *animatedModel = nullptr;
+        /// Skeleton of the animated model, shared with every other instance of it.
+        std::shared_ptr<const Model::Skeleton> skeleton = nullptr;
         Model::Animation *animation = nullptr;
         double animationTime = 0;
+        /// Local pose sampled this tick, reused between updates to avoid allocation. Joints the
+        /// clip holds still keep the value set when the clip was queued.
+        Model::Pose currentPose = {};
+        /// Per-track key cursors into the current animation.
+        std::vector<Model::TrackCursor> cursors = {};
+        /// Model space transform of each joint as of the last evaluation, ticks that extrapolate
+        /// only move jointTransforms.
+        std::vector<glm::mat4> modelTransforms = {};
+        /// Skinning palette, one transform per bone.
+        std::vector<glm::mat4> jointTransforms = {};
+        /// Evaluation specialised for the model's rig, see FixedRig. Null uses the generic
+        /// Skeleton path.
+        std::shared_ptr<const RigEvaluator> rig = nullptr;
+        /// Blend shape weights sampled this tick, one per morph target of the model.
+        std::vector<float> morphWeights = {};
+        /// Level of detail the animator is updated at.
+        AnimationLod lod = AnimationLod::FULL;
+        /// Whether only the joints in reducedJointMask are sampled.
+        bool reducedJoints = false;
+        /// Joints sampled at reduced detail, built from the skeleton's joint reach.
+        std::vector<uint8_t> reducedJointMask = {};
+        /// Whether the last update sampled the clip rather than extrapolating or skipping.
+        bool evaluatedLastUpdate = false;
+        /// Whether the last update rewrote modelTransforms and jointTransforms.
+        bool posedLastUpdate = false;
+        /// Set when the last update needed a page of a streamed clip that was not resident. The
+        /// previous pose was held and the next update samples again.
+        bool sampleMissed = false;
+        /// Bumped every time the palette returned by getJointTransforms changes, by an update,
+        /// a shared pose or a post process, so caches of skinned vertices know when to refresh.
+        uint64_t poseVersion = 0;
+        /// Set while a post process such as IkSystem edits modelTransforms after update. Pose
+        /// sharing is skipped so modelTransforms always belong to this animator.
+        bool postProcessed = false;
+        /// Cache shared with other instances, poses are looked up every tick when set.
+        PoseCache *poseCache = nullptr;
+        /// Graph driving the pose instead of the base clip and layers, shared between instances.
+        std::shared_ptr<const CompiledGraph> graph = nullptr;
+        /// This animator's state in graph.
+        GraphInstance graphInstance = {};
+        /// How transitionTo changes clips.
+        TransitionMode transitionMode = TransitionMode::CROSSFADE;
+        /// Layers that can be active on top of the base clip.
+        static constexpr size_t MAX_LAYERS = 4;
         Animator() = default;
+        /**
+         * Constructs an animator for a model and sizes its pose buffers.
+         * @param model to animate.
+         */
+        explicit Animator(Model::Model *model);
         void queAnimation(Model::Animation* newAnimation);
+        /**
+         * Changes how often and how much of the skeleton is evaluated.
+         * @param newLod level to update at from the next tick.
+         * @param useReducedJoints sample only joints whose reach is at least reducedJointReach.
+         * @param reducedJointReach fraction of the root's reach a joint needs to be sampled.
+         */
+        void setLod(AnimationLod newLod, bool useReducedJoints, float reducedJointReach);
+        /**
+         * Moves the animation to the start of a phase bucket. Instances in the same bucket of
+         * the same clip stay in step and share cached poses, different buckets desynchronise
+         * a crowd.
+         * @param bucket index of the bucket, wrapped to bucketCount.
+         * @param bucketCount number of evenly spaced phases the clip is split into.
+         */
+        void setPhase(size_t bucket, size_t bucketCount);
+
+        /**
+         * Fades from the current clip to a new one. Both clips are sampled until the new clip
+         * is fully faded in, after which it becomes the base clip. Falls back to queAnimation
+         * if there is no clip to fade from or no free layer.
+         * @param newAnimation clip to fade to.
+         * @param duration of the fade in seconds.
+         */
+        void crossFade(Model::Animation *newAnimation, double duration);
+        /**
+         * Switches to a new clip straight away and hides the jump by adding the offset from
+         * the old pose, decayed to zero over the blend time. Only the new clip is sampled, so a
+         * transition costs about the same as plain playback. Layers are dropped.
+         * @param newAnimation clip to switch to.
+         * @param duration longest time the offset takes to decay, in seconds.
+         */
+        void inertialize(Model::Animation *newAnimation, double duration);
+        /**
+         * Changes clip using transitionMode.
+         * @param newAnimation clip to switch to.
+         * @param duration of the transition in seconds.
+         */
+        void transitionTo(Model::Animation *newAnimation, double duration);
+        /**
+         * Adds a clip blended over the base clip and every earlier layer.
+         * @param clip to play on the layer.
+         * @param weight of the layer, 1 fully replaces what is below it.
+         * @param jointWeights optional per joint weights, one per joint, must outlive the layer.
+         * @return index of the layer, or MAX_LAYERS if every layer is in use.
+         */
+        size_t addLayer(Model::Animation *clip, float weight, const float *jointWeights = nullptr);
+        /**
+         * Fades a layer to a new weight.
+         * @param layer index returned by addLayer.
+         * @param weight to fade to.
+         * @param duration of the fade in seconds, zero applies it immediately.
+         */
+        void fadeLayer(size_t layer, float weight, double duration);
+        /**
+         * Removes a layer, layers above it move down one index.
+         * @param layer index returned by addLayer.
+         */
+        void removeLayer(size_t layer);
+        size_t getLayerCount() const;
+        /**
+         * Plays a compiled graph instead of clips, or returns to clip playback.
+         * @param newGraph graph to play, null to stop using a graph.
+         */
+        void setGraph(std::shared_ptr<const CompiledGraph> newGraph);
+        /**
+         * Sets a parameter of the playing graph.
+         * @param parameter index from AnimationGraph::addParameter.
+         * @param value to set.
+         */
+        void setGraphParameter(size_t parameter, float value);
+        const AnimationLayer &getLayer(size_t layer) const;
         void update(double t, double dt);
         void increaseAnimationTime(double time);
-        std::map<std::string, glm::mat4> calculateCurrentAnimationPose();
-        void applyPoseToJoints(std::map<std::string, glm::mat4>& currentPose, Model::Joint& joint, glm::mat4 parentTransform);
-        std::vector<Model::KeyFrame> getPreviousAndNextFrames();
-        double calculateProgression(const Model::KeyFrame& previousFrame, const Model::KeyFrame& nextFrame);
-        std::map<std::string, glm::mat4> interpolatePoses(Model::KeyFrame& previousFrame, Model::KeyFrame& nextFrame, double progression);
+        /**
+         * Samples the base clip and layers, or the graph, into currentPose.
+         * @return false if a clip could not be sampled, see Model::Animation::sample.
+         */
+        bool calculateCurrentAnimationPose();
+        void applyPoseToJoints(const Model::Pose& pose);
+        /**
+         * Rebuilds the skinning palette from modelTransforms after a post process edited them.
+         */
+        void refreshPalette();
+        /**
+         * The skinning palette produced by the last update.
+         * @return one transform per bone.
+         */
+        const std::vector<glm::mat4>& getJointTransforms() const;
+        /**
+         * Converts the palette of the last update to the encoding it is drawn in, so the
+         * conversion runs with the update instead of on upload. AnimationSystem calls it after
+         * every update with its palette encoding, refreshPalette converts again in the same one.
+         * @param encoding of the PaletteStream the palette is drawn from, MATRIX drops the
+         * encoded copy.
+         */
+        void encodePalette(Model::PaletteEncoding encoding);
+        /**
+         * The palette of the last update as converted by encodePalette.
+         * @param encoding of the PaletteStream the palette is added to.
+         * @return getWordsPerBone words per bone, or null if the palette was not converted to
+         * encoding since it last changed or is shared through poseCache, in which case
+         * getJointTransforms is encoded on upload.
+         */
+        const std::vector<uint32_t> *getEncodedPalette(Model::PaletteEncoding encoding) const;
+
+      private:
+        /// Pose sampled by the evaluation before the current one, gives the velocity an
+        /// inertialized transition starts with.
+        Model::Pose previousPose = {};
+        /// First pose of the new clip while an inertialized transition starts.
+        Model::Pose transitionTarget = {};
+        /// Palette of the last evaluation and of the one before it. Ticks that skip evaluation
+        /// extrapolate from them instead of posing the skeleton again.
+        std::vector<glm::mat4> evaluatedPalette = {};
+        std::vector<glm::mat4> previousPalette = {};
+        size_t ticksSinceEvaluation = 0;
+        double timeSinceEvaluation = 0.0;
+        /// Time between the previous and the current sample, 0 if they should not be extrapolated.
+        double evaluationSpacing = 0.0;
+        double lastSampleTime = 0.0;
+        /// Set when the current pose is stale and the next tick has to sample.
+        bool needsEvaluation = true;
+        /// Whether currentPose is the pose last shown and previousPose the one evaluated
+        /// before it, so a transition can start from them.
+        bool previousPoseValid = false;
+        float reducedMaskReach = -1.0f;
+        /// Palette owned by poseCache this frame, used instead of jointTransforms when set.
+        const std::vector<glm::mat4> *sharedPalette = nullptr;
+        /// Key sharedPalette was acquired with.
+        PoseCache::Key sharedKey = {};
+        /// jointTransforms in encodedEncoding as of poseVersion encodedVersion, unused for MATRIX.
+        std::vector<uint32_t> encodedPalette = {};
+        Model::PaletteEncoding encodedEncoding = Model::PaletteEncoding::MATRIX;
+        uint64_t encodedVersion = 0;
+        /// Active layers in blend order, the first layerCount entries are in use.
+        std::array<AnimationLayer, MAX_LAYERS> layers = {};
+        size_t layerCount = 0;
+        /// Offset decay of the running inertialized transition.
+        Inertializer inertializer = {};
+        /// Set when currentPose holds more than the base clip, so still joints need restoring.
+        bool poseModified = false;
+
+        /**
+         * Advances layer times and fades, promotes finished crossfades and drops layers that
+         * faded out.
+         * @param dt the time step.
+         */
+        void updateLayers(double dt);
+        bool blendLayers(const uint8_t *mask);
+        /**
+         * Puts currentPose back to the base clip's rest pose if layers, a graph or a transition
+         * wrote over it.
+         * @param mask optional, joints with a zero entry keep their value.
+         */
+        void resetToRestPose(const uint8_t *mask = nullptr);
+
+        void evaluate();
+        void evaluateShared();
+        /**
+         * Samples currentPose and previousPose at the last shared tick and the one before it,
+         * cache hits do not sample them.
+         */
+        void restoreSharedPose();
+        void extrapolate();
+        /**
+         * Samples morphWeights from the base clip and blends in the weights of each layer.
+         */
+        void sampleMorphWeights();
     };
 }
 
+
@@ -0,0 +1,46 @@
+#include "FixedRig.hpp"
+
+/// Largest distance from the bind translation a channel the rig ignores may move.
+static constexpr float RIG_TRANSLATION_TOLERANCE = 1e-4f;
+
+bool Controller::clipsFitRigChannels(const Model::Skeleton &skeleton,
+                                     const std::vector<Model::Animation> &clips,
+                                     RigChannels channels) {
+    if (channels == RigChannels::ALL) {
+        return true;
+    }
+    auto isBound = [&](size_t joint, const glm::vec3 &translation) {
+        return skeleton.parents[joint] < 0 ||
+               glm::length(translation - skeleton.bindPose.translations[joint]) <=
+                   RIG_TRANSLATION_TOLERANCE;
+    };
+    for (const auto &clip : clips) {
+        for (size_t joint = 0; joint < clip.restPose.size(); ++joint) {
+            if (joint < skeleton.skinnedJointCount &&
+                !isBound(joint, clip.restPose.translations[joint])) {
+                return false;
+            }
+        }
+        if (!clip.getTracks().empty()) {
+            for (const auto &track : clip.getTracks()) {
+                for (const auto &position : track.positions) {
+                    if (!isBound(track.joint, position)) {
+                        return false;
+                    }
+                }
+            }
+        } else if (clip.compressed) {
+            for (const auto &track : clip.compressed->tracks) {
+                if (!track.positions.empty() && skeleton.parents[track.joint] >= 0 &&
+                    (track.positionExtent != glm::vec3(0.0f) ||
+                     !isBound(track.joint, track.positionMin))) {
+                    return false;
+                }
+            }
+        } else if (clip.getTrackCount() > 0) {
+            // Only the resampled frames are left, which this check does not read.
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,168 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include <glm/glm.hpp>
+#include "Model/Models/Animation.hpp"
+#include "Model/Models/PoseKernels.hpp"
+#include "Model/Models/Pose.hpp"
+#include "Model/Models/Skeleton.hpp"
+
+namespace Controller {
+    /// Pose channels a fixed rig reads.
+    enum class RigChannels {
+        /// Translation and rotation of every joint.
+        ALL,
+        /// Rotation of every joint and translation of the roots, every other joint keeps its
+        /// bind translation.
+        ROTATIONS_AND_ROOT
+    };
+
+    /**
+     * Turns a local pose into model transforms and a skinning palette, the work
+     * Skeleton::localToModel and Skeleton::buildPalette do for any skeleton.
+     */
+    class RigEvaluator {
+      public:
+        virtual ~RigEvaluator() = default;
+        /**
+         * @param pose local pose of every joint.
+         * @param modelTransforms model space transform of each joint, posed joints rewritten.
+         * @param palette one transform per bone, resized if required.
+         */
+        virtual void evaluate(const Model::Pose &pose, std::vector<glm::mat4> &modelTransforms,
+                              std::vector<glm::mat4> &palette) const = 0;
+    };
+
+    /**
+     * Checks that every clip of a model leaves the channels a rig does not read at bind pose.
+     * @param skeleton of the model.
+     * @param clips of the model.
+     * @param channels read by the rig.
+     * @return false if a clip moves a channel the rig would ignore, or cannot be checked.
+     */
+    bool clipsFitRigChannels(const Model::Skeleton &skeleton,
+                             const std::vector<Model::Animation> &clips, RigChannels channels);
+
+    /**
+     * Evaluation specialised for one rig layout, for the handful of rigs most characters share.
+     * The layout is a type whose constexpr parents array lists the parent of each posed joint,
+     * -1 for roots, for example:
+     *
+     *     struct BipedLayout {
+     *         static constexpr std::array<int, 3> parents = {-1, 0, 1};
+     *     };
+     *     auto rig = FixedRig<BipedLayout>::create(*model.skeleton, model.animationList);
+     *
+     * The hierarchy walk is unrolled at compile time with every parent index a constant, and
+     * multiplies each joint onto its parent and writes its palette entry in the same pass. The
+     * local transforms are a std::array on the stack and channels the rig does not read come
+     * from constants instead of the pose. The pose, the model transforms and the palette stay
+     * in the animator's buffers, reached through one virtual call per evaluation.
+     *
+     * Models whose skeleton does not match keep using the generic path, see create.
+     */
+    template <typename Layout, RigChannels Channels = RigChannels::ALL>
+    class FixedRig : public RigEvaluator {
+      public:
+        /// Posed joints of the layout.
+        static constexpr size_t JointCount = std::tuple_size<decltype(Layout::parents)>::value;
+
+        /**
+         * Builds the rig for a model.
+         * @param skeleton of the model.
+         * @param clips of the model, checked against Channels.
+         * @return the rig, or null if the skeleton's posed joints do not match the layout or a
+         * clip animates a channel the rig ignores.
+         */
+        static std::shared_ptr<const RigEvaluator>
+        create(const Model::Skeleton &skeleton, const std::vector<Model::Animation> &clips) {
+            if (skeleton.skinnedJointCount != JointCount ||
+                !std::equal(Layout::parents.begin(), Layout::parents.end(),
+                            skeleton.parents.begin()) ||
+                !clipsFitRigChannels(skeleton, clips, Channels)) {
+                return nullptr;
+            }
+            return std::shared_ptr<const RigEvaluator>(new FixedRig(skeleton));
+        }
+
+        void evaluate(const Model::Pose &pose, std::vector<glm::mat4> &modelTransforms,
+                      std::vector<glm::mat4> &palette) const override {
+            modelTransforms.resize(jointTotal);
+            palette.resize(boneCount, glm::mat4(1.0f));
+            std::array<glm::mat4, JointCount> local;
+            if constexpr (Channels == RigChannels::ALL) {
+                Model::Kernels::composeTransforms(pose.translations.data(), pose.rotations.data(),
+                                                  JointCount, local.data());
+            } else {
+                Model::Kernels::composeTransforms(bindTranslations.data(), pose.rotations.data(),
+                                                  JointCount, local.data());
+                for (size_t joint : roots) {
+                    local[joint][3] = glm::vec4(pose.translations[joint], 1.0f);
+                }
+            }
+            evaluateJoints(local, modelTransforms.data(), palette.data(),
+                           std::make_index_sequence<JointCount>{});
+        }
+
+      private:
+        explicit FixedRig(const Model::Skeleton &skeleton)
+            : jointTotal(skeleton.size()), boneCount(skeleton.getBoneCount()),
+              globalInverse(skeleton.globalInverseTransform),
+              globalIsIdentity(skeleton.globalInverseTransform == glm::mat4(1.0f)) {
+            for (size_t joint = 0; joint < JointCount; ++joint) {
+                bones[joint]   = skeleton.boneIndices[joint];
+                offsets[joint] = bones[joint] >= 0
+                                     ? skeleton.boneOffsets[static_cast<size_t>(bones[joint])]
+                                     : glm::mat4(1.0f);
+                bindTranslations[joint] = skeleton.bindPose.translations[joint];
+                if (Layout::parents[joint] < 0) {
+                    roots.push_back(joint);
+                }
+            }
+        }
+
+        template <size_t... Joints>
+        void evaluateJoints(const std::array<glm::mat4, JointCount> &local, glm::mat4 *model,
+                            glm::mat4 *palette, std::index_sequence<Joints...>) const {
+            (evaluateJoint<Joints>(local[Joints], model, palette), ...);
+        }
+
+        template <size_t Joint>
+        void evaluateJoint(const glm::mat4 &local, glm::mat4 *model, glm::mat4 *palette) const {
+            constexpr int parent = Layout::parents[Joint];
+            static_assert(parent < static_cast<int>(Joint), "Parents must come before children");
+            if constexpr (parent < 0) {
+                model[Joint] = local;
+            } else {
+                model[Joint] = Model::Kernels::multiplyAffine(model[parent], local);
+            }
+            if (bones[Joint] < 0) {
+                return;
+            }
+            auto &entry = palette[static_cast<size_t>(bones[Joint])];
+            if (globalIsIdentity) {
+                entry = Model::Kernels::multiplyAffine(model[Joint], offsets[Joint]);
+            } else {
+                entry = Model::Kernels::multiplyAffine(
+                    Model::Kernels::multiplyAffine(globalInverse, model[Joint]), offsets[Joint]);
+            }
+        }
+
+        /// Every joint of the skeleton, posed or not.
+        size_t jointTotal = 0;
+        size_t boneCount = 0;
+        std::array<int, JointCount> bones = {};
+        /// Bone offset of each joint that skins vertices.
+        std::array<glm::mat4, JointCount> offsets = {};
+        std::array<glm::vec3, JointCount> bindTranslations = {};
+        /// Joints without a parent, the only translations ROTATIONS_AND_ROOT reads.
+        std::vector<size_t> roots = {};
+        glm::mat4 globalInverse = glm::mat4(1.0f);
+        /// Skips a multiply per bone for scenes without a root transform.
+        bool globalIsIdentity = true;
+    };
+}
@@ -0,0 +1,277 @@
+#include "IkSolver.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtx/quaternion.hpp>
+#include "Model/Models/SimdLanes.hpp"
+
+/// Problems are padded to a multiple of the widest SIMD block.
+static constexpr size_t BLOCK_WIDTH = Model::Simd::MAX_WIDTH;
+/// Lengths below this are treated as zero.
+static constexpr float IK_EPSILON = 1e-6f;
+/// Fraction of a chain's length a target is held within, a fully straight chain has no
+/// defined bend plane.
+static constexpr float MAX_EXTENSION = 0.9999f;
+
+namespace {
+    using Model::Simd::Single;
+    using Model::Simd::Widest;
+
+    /// A vector per coordinate, one point per lane.
+    template <typename S> struct Points {
+        typename S::Vector x, y, z;
+    };
+
+    template <typename S> Points<S> loadPoints(const std::vector<float> *axes, size_t lane) {
+        return {S::load(&axes[0][lane]), S::load(&axes[1][lane]), S::load(&axes[2][lane])};
+    }
+
+    template <typename S> void storePoints(std::vector<float> *axes, size_t lane,
+                                           const Points<S> &points) {
+        S::store(&axes[0][lane], points.x);
+        S::store(&axes[1][lane], points.y);
+        S::store(&axes[2][lane], points.z);
+    }
+
+    template <typename S> Points<S> add(const Points<S> &a, const Points<S> &b) {
+        return {S::add(a.x, b.x), S::add(a.y, b.y), S::add(a.z, b.z)};
+    }
+
+    template <typename S> Points<S> sub(const Points<S> &a, const Points<S> &b) {
+        return {S::sub(a.x, b.x), S::sub(a.y, b.y), S::sub(a.z, b.z)};
+    }
+
+    template <typename S> Points<S> scale(const Points<S> &a, typename S::Vector s) {
+        return {S::mul(a.x, s), S::mul(a.y, s), S::mul(a.z, s)};
+    }
+
+    template <typename S> typename S::Vector dot(const Points<S> &a, const Points<S> &b) {
+        return S::add(S::add(S::mul(a.x, b.x), S::mul(a.y, b.y)), S::mul(a.z, b.z));
+    }
+
+    template <typename S> typename S::Vector length(const Points<S> &a) {
+        return S::sqrt(dot(a, a));
+    }
+
+    /**
+     * Solves two-bone problems [first, last) with S::WIDTH problems per step.
+     * @return the first problem left unsolved.
+     */
+    template <typename S>
+    size_t solveTwoBone(std::vector<float> *data, size_t first, size_t last) {
+        // Index of the x array of each field, see TwoBoneIkBatch::Field.
+        enum { ROOT = 0, MID = 3, END = 6, TARGET = 9, POLE = 12, SOLVED_MID = 15,
+               SOLVED_END = 18 };
+        auto epsilon = S::set1(IK_EPSILON);
+        auto one     = S::set1(1.0f);
+        for (; first + S::WIDTH <= last; first += S::WIDTH) {
+            auto root   = loadPoints<S>(data + ROOT, first);
+            auto mid    = loadPoints<S>(data + MID, first);
+            auto end    = loadPoints<S>(data + END, first);
+            auto target = loadPoints<S>(data + TARGET, first);
+            auto pole   = loadPoints<S>(data + POLE, first);
+
+            auto upper    = length(sub(mid, root));
+            auto lower    = length(sub(end, mid));
+            auto toTarget = sub(target, root);
+            auto distance = length(toTarget);
+            // Targets out of reach are pulled in, targets too close are pushed out.
+            auto longest  = S::mul(S::add(upper, lower), S::set1(MAX_EXTENSION));
+            auto shortest = S::max(S::sub(upper, lower), S::sub(lower, upper));
+            auto reach    = S::max(S::max(S::min(distance, longest), shortest), epsilon);
+
+            auto direction = scale(toTarget, S::div(one, S::max(distance, epsilon)));
+            auto toPole    = sub(pole, root);
+            auto bend      = sub(toPole, scale(direction, dot(toPole, direction)));
+            bend = scale(bend, S::div(one, S::max(length(bend), epsilon)));
+
+            // Law of cosines for the angle at the root between the target and the upper bone.
+            auto cosine = S::div(S::sub(S::add(S::mul(upper, upper), S::mul(reach, reach)),
+                                        S::mul(lower, lower)),
+                                 S::max(S::mul(S::set1(2.0f), S::mul(upper, reach)), epsilon));
+            cosine    = S::max(S::min(cosine, one), S::set1(-1.0f));
+            auto sine = S::sqrt(S::max(S::sub(one, S::mul(cosine, cosine)), S::set1(0.0f)));
+
+            auto solvedMid = add(root, add(scale(direction, S::mul(upper, cosine)),
+                                           scale(bend, S::mul(upper, sine))));
+            auto solvedEnd = add(root, scale(direction, reach));
+            storePoints<S>(data + SOLVED_MID, first, solvedMid);
+            storePoints<S>(data + SOLVED_END, first, solvedEnd);
+        }
+        return first;
+    }
+
+    /**
+     * Solves FABRIK chains [first, last) with S::WIDTH chains per step.
+     * @return the first chain left unsolved.
+     */
+    template <typename S>
+    size_t solveFabrik(std::vector<std::vector<float>> &positions,
+                       const std::array<std::vector<float>, 3> &targets,
+                       std::vector<std::vector<float>> &lengths, size_t jointCount,
+                       size_t iterations, size_t first, size_t last) {
+        auto epsilon = S::set1(IK_EPSILON);
+        // Moves joint `moved` to lie the bone's length from `fixed` along the line between them.
+        auto place = [&](size_t moved, size_t fixed, size_t bone, size_t lane) {
+            auto from  = loadPoints<S>(&positions[fixed * 3], lane);
+            auto to    = loadPoints<S>(&positions[moved * 3], lane);
+            auto delta = sub(to, from);
+            auto ratio = S::div(S::load(&lengths[bone][lane]), S::max(length(delta), epsilon));
+            storePoints<S>(&positions[moved * 3], lane, add(from, scale(delta, ratio)));
+        };
+        for (; first + S::WIDTH <= last; first += S::WIDTH) {
+            for (size_t joint = 0; joint + 1 < jointCount; ++joint) {
+                auto bone = sub(loadPoints<S>(&positions[(joint + 1) * 3], first),
+                                loadPoints<S>(&positions[joint * 3], first));
+                S::store(&lengths[joint][first], length(bone));
+            }
+            auto root   = loadPoints<S>(&positions[0], first);
+            auto target = loadPoints<S>(targets.data(), first);
+            for (size_t iteration = 0; iteration < iterations; ++iteration) {
+                storePoints<S>(&positions[(jointCount - 1) * 3], first, target);
+                for (size_t joint = jointCount - 1; joint-- > 0;) {
+                    place(joint, joint + 1, joint, first);
+                }
+                storePoints<S>(&positions[0], first, root);
+                for (size_t joint = 1; joint < jointCount; ++joint) {
+                    place(joint, joint - 1, joint - 1, first);
+                }
+            }
+        }
+        return first;
+    }
+}
+
+void Controller::alignChain(const std::vector<size_t> &joints,
+                            const std::vector<std::vector<size_t>> &subtrees,
+                            const glm::vec3 *positions, bool keepEndOrientation,
+                            std::vector<glm::mat4> &modelTransforms) {
+    glm::mat3 endBasis = glm::mat3(modelTransforms[joints.back()]);
+    for (size_t k = 0; k + 1 < joints.size(); ++k) {
+        glm::vec3 joint = modelTransforms[joints[k]][3];
+        glm::vec3 from  = glm::vec3(modelTransforms[joints[k + 1]][3]) - joint;
+        glm::vec3 to    = positions[k + 1] - positions[k];
+        if (glm::length(from) < IK_EPSILON || glm::length(to) < IK_EPSILON) {
+            continue;
+        }
+        glm::quat rotation = glm::rotation(glm::normalize(from), glm::normalize(to));
+        glm::mat4 delta = glm::translate(glm::mat4(1.0f), positions[k]) *
+                          glm::toMat4(rotation) * glm::translate(glm::mat4(1.0f), -joint);
+        for (size_t moved : subtrees[k]) {
+            modelTransforms[moved] = Model::Kernels::multiplyAffine(delta, modelTransforms[moved]);
+        }
+    }
+    if (!keepEndOrientation) {
+        return;
+    }
+    glm::vec3 end = modelTransforms[joints.back()][3];
+    glm::mat3 correction = endBasis * glm::inverse(glm::mat3(modelTransforms[joints.back()]));
+    glm::mat4 delta = glm::translate(glm::mat4(1.0f), end) * glm::mat4(correction) *
+                      glm::translate(glm::mat4(1.0f), -end);
+    for (size_t moved : subtrees.back()) {
+        modelTransforms[moved] = Model::Kernels::multiplyAffine(delta, modelTransforms[moved]);
+    }
+}
+
+void Controller::TwoBoneIkBatch::clear() {
+    count = 0;
+}
+
+size_t Controller::TwoBoneIkBatch::add(const glm::vec3 &root, const glm::vec3 &mid,
+                                       const glm::vec3 &end, const glm::vec3 &target,
+                                       const glm::vec3 &pole) {
+    size_t padded = (count + BLOCK_WIDTH) / BLOCK_WIDTH * BLOCK_WIDTH;
+    if (data[0].size() < padded) {
+        for (auto &axis : data) {
+            axis.resize(padded, 0.0f);
+        }
+    }
+    set(ROOT, count, root);
+    set(MID, count, mid);
+    set(END, count, end);
+    set(TARGET, count, target);
+    set(POLE, count, pole);
+    return count++;
+}
+
+void Controller::TwoBoneIkBatch::solve() {
+    size_t first = solveTwoBone<Widest>(data.data(), 0, count);
+    solveTwoBone<Single>(data.data(), first, count);
+}
+
+size_t Controller::TwoBoneIkBatch::size() const {
+    return count;
+}
+
+glm::vec3 Controller::TwoBoneIkBatch::getMid(size_t problem) const {
+    return get(SOLVED_MID, problem);
+}
+
+glm::vec3 Controller::TwoBoneIkBatch::getEnd(size_t problem) const {
+    return get(SOLVED_END, problem);
+}
+
+glm::vec3 Controller::TwoBoneIkBatch::get(Field field, size_t problem) const {
+    return glm::vec3(data[field * 3][problem], data[field * 3 + 1][problem],
+                     data[field * 3 + 2][problem]);
+}
+
+void Controller::TwoBoneIkBatch::set(Field field, size_t problem, const glm::vec3 &value) {
+    for (int axis = 0; axis < 3; ++axis) {
+        data[field * 3 + static_cast<size_t>(axis)][problem] = value[axis];
+    }
+}
+
+Controller::FabrikBatch::FabrikBatch(size_t newJointCount)
+    : jointCount(std::max<size_t>(newJointCount, 2)) {
+    positions.resize(jointCount * 3);
+    lengths.resize(jointCount - 1);
+}
+
+void Controller::FabrikBatch::clear() {
+    count = 0;
+}
+
+size_t Controller::FabrikBatch::add(const glm::vec3 *chain, const glm::vec3 &target) {
+    size_t padded = (count + BLOCK_WIDTH) / BLOCK_WIDTH * BLOCK_WIDTH;
+    if (targets[0].size() < padded) {
+        for (auto &axis : positions) {
+            axis.resize(padded, 0.0f);
+        }
+        for (auto &axis : targets) {
+            axis.resize(padded, 0.0f);
+        }
+        for (auto &bone : lengths) {
+            bone.resize(padded, 0.0f);
+        }
+    }
+    for (size_t joint = 0; joint < jointCount; ++joint) {
+        for (int axis = 0; axis < 3; ++axis) {
+            positions[joint * 3 + static_cast<size_t>(axis)][count] = chain[joint][axis];
+        }
+    }
+    for (int axis = 0; axis < 3; ++axis) {
+        targets[static_cast<size_t>(axis)][count] = target[axis];
+    }
+    return count++;
+}
+
+void Controller::FabrikBatch::solve(size_t iterations) {
+    size_t first =
+        solveFabrik<Widest>(positions, targets, lengths, jointCount, iterations, 0, count);
+    solveFabrik<Single>(positions, targets, lengths, jointCount, iterations, first, count);
+}
+
+size_t Controller::FabrikBatch::size() const {
+    return count;
+}
+
+size_t Controller::FabrikBatch::getJointCount() const {
+    return jointCount;
+}
+
+glm::vec3 Controller::FabrikBatch::getPosition(size_t chain, size_t joint) const {
+    return glm::vec3(positions[joint * 3][chain], positions[joint * 3 + 1][chain],
+                     positions[joint * 3 + 2][chain]);
+}
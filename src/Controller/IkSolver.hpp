@@ -0,0 +1,98 @@
+#pragma once
+#include <array>
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace Controller {
+    /**
+     * Moves a chain of joints onto new positions by rotating each joint, along with its
+     * subtree, so its child lands on the next position.
+     * @param joints of the chain, each the child of the one before.
+     * @param subtrees the subtree of each chain joint, see Skeleton::collectSubtree.
+     * @param positions model space position of each chain joint.
+     * @param keepEndOrientation restore the last joint's orientation afterwards, as feet need.
+     * @param modelTransforms model space transform of every joint, updated in place.
+     */
+    void alignChain(const std::vector<size_t> &joints,
+                    const std::vector<std::vector<size_t>> &subtrees, const glm::vec3 *positions,
+                    bool keepEndOrientation, std::vector<glm::mat4> &modelTransforms);
+
+    /**
+     * Many independent two-bone problems, such as legs reaching for the ground, solved together.
+     * Problems are stored SoA, one array per coordinate, and solved 4 (SSE) or 8 (AVX2) at a
+     * time with the law of cosines. The bend plane of each problem holds its pole.
+     */
+    class TwoBoneIkBatch {
+      public:
+        void clear();
+        /**
+         * Adds a problem, the bone lengths are taken from the current positions.
+         * @param root joint, stays in place.
+         * @param mid joint, the knee or elbow.
+         * @param end joint, placed on the target if it can be reached.
+         * @param target position for end.
+         * @param pole position the chain bends towards.
+         * @return index of the problem.
+         */
+        size_t add(const glm::vec3 &root, const glm::vec3 &mid, const glm::vec3 &end,
+                   const glm::vec3 &target, const glm::vec3 &pole);
+        /**
+         * Solves every problem added since the last clear.
+         */
+        void solve();
+        size_t size() const;
+        glm::vec3 getMid(size_t problem) const;
+        glm::vec3 getEnd(size_t problem) const;
+
+      private:
+        enum Field { ROOT, MID, END, TARGET, POLE, SOLVED_MID, SOLVED_END, FIELD_COUNT };
+
+        size_t count = 0;
+        /// One array per coordinate of each field, padded to whole SIMD blocks.
+        std::array<std::vector<float>, FIELD_COUNT * 3> data = {};
+
+        glm::vec3 get(Field field, size_t problem) const;
+        void set(Field field, size_t problem, const glm::vec3 &value);
+    };
+
+    /**
+     * Many chains with the same number of joints solved with FABRIK, alternating passes that
+     * drag the chain onto its target and back onto its root. Chains are stored SoA and solved
+     * 4 (SSE) or 8 (AVX2) at a time for a fixed number of iterations, so the cost of a batch
+     * does not depend on how quickly its chains converge.
+     */
+    class FabrikBatch {
+      public:
+        FabrikBatch() = default;
+        /**
+         * @param newJointCount joints in every chain of the batch, at least 2.
+         */
+        explicit FabrikBatch(size_t newJointCount);
+
+        void clear();
+        /**
+         * Adds a chain, the bone lengths are taken from the current positions.
+         * @param positions jointCount positions from the root to the end effector.
+         * @param target position for the end effector.
+         * @return index of the chain.
+         */
+        size_t add(const glm::vec3 *positions, const glm::vec3 &target);
+        /**
+         * Solves every chain added since the last clear.
+         * @param iterations forward and backward passes run on every chain.
+         */
+        void solve(size_t iterations);
+        size_t size() const;
+        size_t getJointCount() const;
+        glm::vec3 getPosition(size_t chain, size_t joint) const;
+
+      private:
+        size_t jointCount = 0;
+        size_t count = 0;
+        /// Array (joint * 3 + axis) holds one coordinate of one joint of every chain.
+        std::vector<std::vector<float>> positions = {};
+        std::array<std::vector<float>, 3> targets = {};
+        /// Array joint holds the length of the bone from joint to joint + 1 of every chain.
+        std::vector<std::vector<float>> lengths = {};
+    };
+}
@@ -0,0 +1,186 @@
+#include "IkSystem.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+size_t Controller::IkSystem::addCharacter(std::shared_ptr<Animator> animator) {
+    animator->postProcessed = true;
+    Character character = {};
+    character.animator  = std::move(animator);
+    characters.push_back(std::move(character));
+    return characters.size() - 1;
+}
+
+void Controller::IkSystem::setWorldTransform(size_t character, const glm::mat4 &model) {
+    characters.at(character).world = model;
+}
+
+void Controller::IkSystem::setPelvis(size_t character, size_t joint) {
+    auto &changed  = characters.at(character);
+    changed.pelvis = joint;
+    changed.pelvisSubtree = joint == IK_NO_JOINT
+                                ? std::vector<size_t>{}
+                                : changed.animator->skeleton->collectSubtree(joint);
+}
+
+void Controller::IkSystem::addLeg(size_t character, size_t hip, size_t knee, size_t foot,
+                                  const glm::vec3 &bendDirection) {
+    Chain leg = makeChain(character, {hip, knee, foot});
+    leg.bendDirection = bendDirection;
+    legs.push_back(std::move(leg));
+}
+
+void Controller::IkSystem::addChain(size_t character, const std::vector<size_t> &joints) {
+    chains.push_back(makeChain(character, joints));
+    chainBatches.emplace(joints.size(), FabrikBatch(joints.size()));
+}
+
+Controller::IkSystem::Chain
+Controller::IkSystem::makeChain(size_t character, const std::vector<size_t> &joints) const {
+    const auto &skeleton = *characters.at(character).animator->skeleton;
+    if (joints.size() < 2) {
+        throw std::runtime_error("IK chain needs at least two joints");
+    }
+    for (size_t i = 0; i < joints.size(); ++i) {
+        // Joints past the skinned range are never posed, see Skeleton::partitionSkinnedJoints.
+        if (joints[i] >= skeleton.skinnedJointCount ||
+            (i > 0 && skeleton.parents[joints[i]] != static_cast<int>(joints[i - 1]))) {
+            throw std::runtime_error("IK chain joints must be posed and children of each other");
+        }
+    }
+    Chain chain     = {};
+    chain.character = character;
+    chain.joints    = joints;
+    for (size_t joint : joints) {
+        chain.subtrees.push_back(skeleton.collectSubtree(joint));
+    }
+    return chain;
+}
+
+void Controller::IkSystem::update(const HeightQuery &groundHeight) {
+    auto start = std::chrono::steady_clock::now();
+    stats = {};
+    legBatch.clear();
+    for (auto &batch : chainBatches) {
+        batch.second.clear();
+    }
+
+    // Skipped or culled animators did not pose this tick, so their transforms already hold
+    // last tick's solution.
+    auto isPosed = [this](size_t character) {
+        return characters[character].animator->posedLastUpdate;
+    };
+    for (size_t i = 0; i < characters.size(); ++i) {
+        auto &character    = characters[i];
+        character.lowering = 0.0f;
+        character.touched  = false;
+        if (isPosed(i)) {
+            character.toWorld =
+                character.world * character.animator->skeleton->globalInverseTransform;
+            character.toModel = glm::inverse(character.toWorld);
+            ++stats.characters;
+        }
+    }
+
+    // The clip's floor is the character's origin, each effector keeps its height above it but
+    // measured from the ground under the effector.
+    auto findTarget = [&](Chain &chain) {
+        auto &character = characters[chain.character];
+        glm::vec4 effector =
+            character.toWorld * character.animator->modelTransforms[chain.joints.back()][3];
+        float offset = groundHeight(effector.x, effector.z) - character.world[3].y;
+        character.lowering = std::min(character.lowering, offset);
+        chain.target =
+            glm::vec3(character.toModel * (effector + glm::vec4(0.0f, offset, 0.0f, 0.0f)));
+    };
+    for (auto &leg : legs) {
+        if (isPosed(leg.character)) {
+            findTarget(leg);
+        }
+    }
+    for (auto &chain : chains) {
+        if (isPosed(chain.character)) {
+            findTarget(chain);
+        }
+    }
+
+    // A foot can only reach below the floor the clip was authored on if the hips drop too.
+    for (size_t i = 0; i < characters.size(); ++i) {
+        auto &character = characters[i];
+        if (!isPosed(i) || character.pelvis == IK_NO_JOINT || character.lowering >= 0.0f) {
+            continue;
+        }
+        glm::vec4 drop = character.toModel * glm::vec4(0.0f, character.lowering, 0.0f, 0.0f);
+        auto &modelTransforms = character.animator->modelTransforms;
+        for (size_t joint : character.pelvisSubtree) {
+            modelTransforms[joint][3] += drop;
+        }
+        character.touched = true;
+    }
+
+    auto position = [this](const Chain &chain, size_t joint) {
+        return glm::vec3(characters[chain.character].animator->modelTransforms[joint][3]);
+    };
+    for (auto &leg : legs) {
+        if (isPosed(leg.character)) {
+            glm::vec3 knee = position(leg, leg.joints[1]);
+            leg.problem = legBatch.add(position(leg, leg.joints[0]), knee,
+                                       position(leg, leg.joints[2]), leg.target,
+                                       knee + leg.bendDirection);
+        }
+    }
+    for (auto &chain : chains) {
+        if (isPosed(chain.character)) {
+            scratch.clear();
+            for (size_t joint : chain.joints) {
+                scratch.push_back(position(chain, joint));
+            }
+            chain.problem = chainBatches[chain.joints.size()].add(scratch.data(), chain.target);
+        }
+    }
+
+    auto solveStart = std::chrono::steady_clock::now();
+    legBatch.solve();
+    for (auto &batch : chainBatches) {
+        batch.second.solve(fabrikIterations);
+    }
+    stats.solveTime = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                                    solveStart).count();
+
+    for (const auto &leg : legs) {
+        if (isPosed(leg.character)) {
+            glm::vec3 solved[3] = {position(leg, leg.joints[0]), legBatch.getMid(leg.problem),
+                                   legBatch.getEnd(leg.problem)};
+            // The effector, a foot for instance, keeps the orientation its clip gave it.
+            alignChain(leg.joints, leg.subtrees, solved, true,
+                       characters[leg.character].animator->modelTransforms);
+            characters[leg.character].touched = true;
+            ++stats.twoBoneChains;
+        }
+    }
+    for (const auto &chain : chains) {
+        if (isPosed(chain.character)) {
+            const auto &batch = chainBatches[chain.joints.size()];
+            scratch.clear();
+            for (size_t joint = 0; joint < chain.joints.size(); ++joint) {
+                scratch.push_back(batch.getPosition(chain.problem, joint));
+            }
+            auto &modelTransforms = characters[chain.character].animator->modelTransforms;
+            alignChain(chain.joints, chain.subtrees, scratch.data(), true, modelTransforms);
+            characters[chain.character].touched = true;
+            ++stats.fabrikChains;
+        }
+    }
+    for (auto &character : characters) {
+        if (character.touched) {
+            character.animator->refreshPalette();
+        }
+    }
+    stats.updateTime =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+const Controller::IkStats &Controller::IkSystem::getStats() const {
+    return stats;
+}
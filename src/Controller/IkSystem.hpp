@@ -0,0 +1,123 @@
+#pragma once
+#include <functional>
+#include <map>
+#include <memory>
+#include <vector>
+#include <glm/glm.hpp>
+#include "Controller/Animator.hpp"
+#include "Controller/IkSolver.hpp"
+
+namespace Controller {
+    /// Marks a character without a pelvis joint.
+    constexpr size_t IK_NO_JOINT = ~static_cast<size_t>(0);
+
+    /// Work done by the last IkSystem update.
+    struct IkStats {
+        size_t characters = 0;
+        size_t twoBoneChains = 0;
+        size_t fabrikChains = 0;
+        /// Seconds spent in the batched solvers.
+        double solveTime = 0.0;
+        /// Seconds spent in the whole update, including reading and writing joints.
+        double updateTime = 0.0;
+    };
+
+    /**
+     * Plants the feet of many characters on uneven ground after their animators have run.
+     * Every chain's end effector keeps the height above the ground its clip gives it, measured
+     * against the ground under the effector rather than the flat floor the clip was authored
+     * on. Legs are solved analytically, longer chains with FABRIK, and every chain of every
+     * character goes through one batch per solver so the solvers run SIMD across characters.
+     * Results are written into each animator's model transforms and palette.
+     */
+    class IkSystem {
+      public:
+        /// Height of the ground at a world space x and z.
+        using HeightQuery = std::function<float(float x, float z)>;
+
+        /**
+         * Registers a character, its animator stops sharing poses, see Animator::postProcessed.
+         * @param animator of the character.
+         * @return index of the character.
+         */
+        size_t addCharacter(std::shared_ptr<Animator> animator);
+        /**
+         * Sets the matrix the character is drawn with, world space is y up.
+         * @param character index from addCharacter.
+         * @param model transform from the model's space to world space.
+         */
+        void setWorldTransform(size_t character, const glm::mat4 &model);
+        /**
+         * Sets a joint lowered with its descendants when a foot has to reach below the floor
+         * the clip was authored on.
+         * @param character index from addCharacter.
+         * @param joint usually the hips, or IK_NO_JOINT.
+         */
+        void setPelvis(size_t character, size_t joint);
+        /**
+         * Adds a leg solved with the two-bone solver.
+         * @param character index from addCharacter.
+         * @param hip root joint of the leg.
+         * @param knee middle joint of the leg.
+         * @param foot end effector.
+         * @param bendDirection model space direction added to the knee to pick the bend plane,
+         * keeps fully straight legs bending the right way.
+         */
+        void addLeg(size_t character, size_t hip, size_t knee, size_t foot,
+                    const glm::vec3 &bendDirection);
+        /**
+         * Adds a chain solved with FABRIK.
+         * @param character index from addCharacter.
+         * @param joints from the root to the end effector, each the child of the one before.
+         */
+        void addChain(size_t character, const std::vector<size_t> &joints);
+
+        /**
+         * Solves every chain of every character whose animator posed this tick.
+         * @param groundHeight ground height under a world space position.
+         */
+        void update(const HeightQuery &groundHeight);
+
+        /// Forward and backward passes run on every FABRIK chain.
+        size_t fabrikIterations = 8;
+
+        const IkStats &getStats() const;
+
+      private:
+        /// A chain of joints and everything each of them moves.
+        struct Chain {
+            size_t character = 0;
+            std::vector<size_t> joints = {};
+            /// Joints in the subtree of each chain joint, itself included.
+            std::vector<std::vector<size_t>> subtrees = {};
+            glm::vec3 bendDirection = glm::vec3(0.0f);
+            /// Index of the chain in its batch this tick.
+            size_t problem = 0;
+            glm::vec3 target = glm::vec3(0.0f);
+        };
+        struct Character {
+            std::shared_ptr<Animator> animator = nullptr;
+            glm::mat4 world = glm::mat4(1.0f);
+            size_t pelvis = IK_NO_JOINT;
+            std::vector<size_t> pelvisSubtree = {};
+            /// Model transforms to world space this tick, and back.
+            glm::mat4 toWorld = glm::mat4(1.0f);
+            glm::mat4 toModel = glm::mat4(1.0f);
+            /// Furthest any effector has to reach below the clip's floor this tick.
+            float lowering = 0.0f;
+            bool touched = false;
+        };
+
+        std::vector<Character> characters = {};
+        std::vector<Chain> legs = {};
+        std::vector<Chain> chains = {};
+        TwoBoneIkBatch legBatch = {};
+        /// One batch per chain length.
+        std::map<size_t, FabrikBatch> chainBatches = {};
+        IkStats stats = {};
+        /// Positions of a chain being added to a batch.
+        std::vector<glm::vec3> scratch = {};
+
+        Chain makeChain(size_t character, const std::vector<size_t> &joints) const;
+    };
+}
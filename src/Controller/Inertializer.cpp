@@ -0,0 +1,112 @@
+#include "Inertializer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <glm/gtx/quaternion.hpp>
+
+/// Offsets below this are treated as zero.
+static constexpr float OFFSET_EPSILON = 1e-6f;
+
+/**
+ * Rotation taking b to a as a scaled axis, picking the short way round.
+ */
+static glm::vec3 rotationOffset(const glm::quat &a, const glm::quat &b) {
+    glm::quat offset = a * glm::inverse(b);
+    if (offset.w < 0.0f) {
+        offset = -offset;
+    }
+    glm::vec3 axis(offset.x, offset.y, offset.z);
+    float sinHalf = glm::length(axis);
+    if (sinHalf < OFFSET_EPSILON) {
+        return glm::vec3(0.0f);
+    }
+    return axis * (2.0f * std::atan2(sinHalf, offset.w) / sinHalf);
+}
+
+void Controller::DecayCurve::fit(float offset, float velocity, float blendTime) {
+    x0 = offset;
+    // Never let the offset grow, a velocity away from zero is dropped.
+    v0 = std::min(velocity, 0.0f);
+    duration = blendTime;
+    if (v0 < 0.0f) {
+        // Keep the curve from overshooting zero when the offset is already closing quickly.
+        duration = std::min(duration, -5.0f * x0 / v0);
+    }
+    if (duration <= OFFSET_EPSILON || x0 <= OFFSET_EPSILON) {
+        a = b = c = d = v0 = x0 = 0.0f;
+        duration = 0.0f;
+        return;
+    }
+    float t1 = duration;
+    float t2 = t1 * t1;
+    float acceleration = (-8.0f * v0 * t1 - 20.0f * x0) / t2;
+    a = -(acceleration * t2 + 6.0f * v0 * t1 + 12.0f * x0) / (2.0f * t2 * t2 * t1);
+    b = (3.0f * acceleration * t2 + 16.0f * v0 * t1 + 30.0f * x0) / (2.0f * t2 * t2);
+    c = -(3.0f * acceleration * t2 + 12.0f * v0 * t1 + 20.0f * x0) / (2.0f * t2 * t1);
+    d = acceleration * 0.5f;
+}
+
+float Controller::DecayCurve::evaluate(float time) const {
+    if (time >= duration) {
+        return 0.0f;
+    }
+    float t = time;
+    return ((((a * t + b) * t + c) * t + d) * t + v0) * t + x0;
+}
+
+void Controller::Inertializer::resize(size_t jointCount) {
+    translationAxes.resize(jointCount);
+    translationCurves.resize(jointCount);
+    rotationAxes.resize(jointCount);
+    rotationCurves.resize(jointCount);
+}
+
+void Controller::Inertializer::begin(const Model::Pose &source, const Model::Pose &previousSource,
+                                     double step, const Model::Pose &target, double blendTime) {
+    resize(target.size());
+    elapsed  = 0.0f;
+    duration = static_cast<float>(blendTime);
+    float inverseStep = step > 0.0 ? static_cast<float>(1.0 / step) : 0.0f;
+    for (size_t i = 0; i < target.size(); ++i) {
+        glm::vec3 offset = source.translations[i] - target.translations[i];
+        float length = glm::length(offset);
+        glm::vec3 axis = length > OFFSET_EPSILON ? offset / length : glm::vec3(0.0f);
+        // Velocity of the offset along its own direction, from the last step of the old clip.
+        float previous = glm::dot(previousSource.translations[i] - target.translations[i], axis);
+        translationAxes[i] = axis;
+        translationCurves[i].fit(length, (length - previous) * inverseStep, duration);
+
+        glm::vec3 rotation = rotationOffset(source.rotations[i], target.rotations[i]);
+        float angle = glm::length(rotation);
+        glm::vec3 rotationAxis = angle > OFFSET_EPSILON ? rotation / angle : glm::vec3(0.0f);
+        float previousAngle = glm::dot(
+            rotationOffset(previousSource.rotations[i], target.rotations[i]), rotationAxis);
+        rotationAxes[i] = rotationAxis;
+        rotationCurves[i].fit(angle, (angle - previousAngle) * inverseStep, duration);
+    }
+}
+
+void Controller::Inertializer::advance(double dt) {
+    elapsed += static_cast<float>(dt);
+}
+
+void Controller::Inertializer::apply(Model::Pose &pose, const uint8_t *jointMask) const {
+    if (!isActive()) {
+        return;
+    }
+    size_t count = std::min(pose.size(), translationCurves.size());
+    for (size_t i = 0; i < count; ++i) {
+        if (jointMask != nullptr && jointMask[i] == 0) {
+            continue;
+        }
+        pose.translations[i] += translationAxes[i] * translationCurves[i].evaluate(elapsed);
+        float angle = rotationCurves[i].evaluate(elapsed);
+        if (angle > 0.0f) {
+            pose.rotations[i] = glm::angleAxis(angle, rotationAxes[i]) * pose.rotations[i];
+        }
+    }
+}
+
+bool Controller::Inertializer::isActive() const {
+    return elapsed < duration;
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "Model/Models/Pose.hpp"
+
+namespace Controller {
+    /**
+     * Quintic that takes an offset and its velocity smoothly to zero, with zero velocity and
+     * acceleration at the end of the blend.
+     */
+    struct DecayCurve {
+        float a = 0.0f, b = 0.0f, c = 0.0f, d = 0.0f, v0 = 0.0f, x0 = 0.0f;
+        /// Time at which the curve reaches zero, may be shorter than the blend time.
+        float duration = 0.0f;
+
+        /**
+         * Fits the curve.
+         * @param offset at the start of the blend, not negative.
+         * @param velocity of the offset at the start of the blend.
+         * @param blendTime longest time the offset may take to reach zero.
+         */
+        void fit(float offset, float velocity, float blendTime);
+        /**
+         * Evaluates the remaining offset.
+         * @param time since the start of the blend.
+         * @return the offset, zero once the curve has finished.
+         */
+        float evaluate(float time) const;
+    };
+
+    /**
+     * Transitions between clips by sampling only the new clip and adding the difference to the
+     * old pose, decayed over the blend time. Each joint's translation and rotation offset keeps
+     * its direction and only its magnitude decays, see DecayCurve.
+     */
+    class Inertializer {
+      public:
+        /**
+         * Sizes the per joint buffers.
+         * @param jointCount number of joints in the skeleton.
+         */
+        void resize(size_t jointCount);
+        /**
+         * Starts a transition.
+         * @param source last pose of the old clip.
+         * @param previousSource pose of the old clip one step before source.
+         * @param step time between previousSource and source, zero if the velocity is unknown.
+         * @param target first pose of the new clip.
+         * @param blendTime longest time the transition lasts.
+         */
+        void begin(const Model::Pose &source, const Model::Pose &previousSource, double step,
+                   const Model::Pose &target, double blendTime);
+        /**
+         * Advances the transition.
+         * @param dt the time step.
+         */
+        void advance(double dt);
+        /**
+         * Adds the remaining offset to a pose of the new clip.
+         * @param pose sampled from the new clip.
+         * @param jointMask optional, joints with a zero entry were not sampled and are skipped.
+         */
+        void apply(Model::Pose &pose, const uint8_t *jointMask = nullptr) const;
+        bool isActive() const;
+
+      private:
+        std::vector<glm::vec3> translationAxes = {};
+        std::vector<DecayCurve> translationCurves = {};
+        std::vector<glm::vec3> rotationAxes = {};
+        std::vector<DecayCurve> rotationCurves = {};
+        float elapsed = 0.0f;
+        float duration = 0.0f;
+    };
+}
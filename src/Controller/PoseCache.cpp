@@ -0,0 +1,81 @@
+#include "PoseCache.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+bool Controller::PoseCache::Key::operator==(const Key &other) const {
+    return model == other.model && animation == other.animation && tick == other.tick;
+}
+
+size_t Controller::PoseCache::KeyHash::operator()(const Key &key) const {
+    size_t hash = std::hash<const void *>()(key.model);
+    hash ^= std::hash<const void *>()(key.animation) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    return hash ^ (std::hash<int64_t>()(key.tick) + 0x9e3779b9 + (hash << 6) + (hash >> 2));
+}
+
+Controller::PoseCache::PoseCache(double newQuantum) {
+    setQuantum(newQuantum);
+    quantum = pendingQuantum;
+}
+
+void Controller::PoseCache::beginFrame() {
+    quantum = pendingQuantum;
+    lookup.clear();
+    for (size_t i = 0; i < usedEntries; ++i) {
+        entries[i]->ready = false;
+    }
+    usedEntries = 0;
+    hits   = 0;
+    misses = 0;
+}
+
+const std::vector<glm::mat4> &Controller::PoseCache::acquire(const Key &key,
+                                                             const Evaluator &evaluate) {
+    std::unique_lock<std::mutex> lock(mutex);
+    auto found = lookup.find(key);
+    if (found != lookup.end()) {
+        ++hits;
+        Entry *entry = found->second;
+        evaluated.wait(lock, [entry] { return entry->ready; });
+        return entry->palette;
+    }
+    ++misses;
+    if (usedEntries == entries.size()) {
+        entries.push_back(std::make_unique<Entry>());
+    }
+    Entry *entry = entries[usedEntries++].get();
+    lookup.emplace(key, entry);
+    lock.unlock();
+
+    evaluate(entry->palette);
+
+    lock.lock();
+    entry->ready = true;
+    lock.unlock();
+    evaluated.notify_all();
+    return entry->palette;
+}
+
+int64_t Controller::PoseCache::getTick(double time) const {
+    return static_cast<int64_t>(std::floor(time / quantum));
+}
+
+double Controller::PoseCache::getTickTime(int64_t tick) const {
+    return static_cast<double>(tick) * quantum;
+}
+
+void Controller::PoseCache::setQuantum(double newQuantum) {
+    pendingQuantum = std::max(newQuantum, 1e-6);
+}
+
+double Controller::PoseCache::getQuantum() const {
+    return quantum;
+}
+
+size_t Controller::PoseCache::getHits() const {
+    return hits;
+}
+
+size_t Controller::PoseCache::getMisses() const {
+    return misses;
+}
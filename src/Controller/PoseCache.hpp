@@ -0,0 +1,106 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace Model {
+    class Model;
+    class Animation;
+}
+
+namespace Controller {
+    /**
+     * Per-frame cache of skinning palettes shared by instances that play the same clip of the
+     * same model at the same quantized time. The first instance to ask for a pose evaluates it,
+     * every later instance in the frame reuses the palette instead of sampling again.
+     * Safe to use from the AnimationSystem worker threads.
+     */
+    class PoseCache {
+      public:
+        /**
+         * Identifies one evaluated pose.
+         */
+        struct Key {
+            const Model::Model *model = nullptr;
+            const Model::Animation *animation = nullptr;
+            /// Animation time divided by the quantum.
+            int64_t tick = 0;
+            bool operator==(const Key &other) const;
+        };
+        /// Fills a palette for a key that missed.
+        using Evaluator = std::function<void(std::vector<glm::mat4> &palette)>;
+
+        PoseCache() = default;
+        /**
+         * Constructs an empty cache.
+         * @param newQuantum animation time step poses are snapped to, in seconds.
+         */
+        explicit PoseCache(double newQuantum);
+        PoseCache(const PoseCache &) = delete;
+        PoseCache &operator=(const PoseCache &) = delete;
+
+        /**
+         * Invalidates every palette handed out last frame and resets the frame counters.
+         * Must not be called while an update is running.
+         */
+        void beginFrame();
+        /**
+         * Finds the palette for a key, evaluating it on a miss. Threads asking for a key that is
+         * being evaluated wait for it.
+         * @param key of the pose.
+         * @param evaluate called once per key per frame to fill the palette.
+         * @return the palette, valid until the next beginFrame.
+         */
+        const std::vector<glm::mat4> &acquire(const Key &key, const Evaluator &evaluate);
+
+        /**
+         * Quantizes an animation time.
+         * @param time in seconds.
+         * @return the tick that time falls into.
+         */
+        int64_t getTick(double time) const;
+        /**
+         * Time at the start of a tick, the time cached poses are sampled at.
+         * @param tick from getTick.
+         * @return the time in seconds.
+         */
+        double getTickTime(int64_t tick) const;
+        /**
+         * Changes the quantum, takes effect from the next beginFrame.
+         * @param newQuantum time step in seconds.
+         */
+        void setQuantum(double newQuantum);
+        double getQuantum() const;
+
+        /// Lookups this frame that reused a pose.
+        size_t getHits() const;
+        /// Lookups this frame that had to evaluate a pose.
+        size_t getMisses() const;
+
+      private:
+        struct KeyHash {
+            size_t operator()(const Key &key) const;
+        };
+        struct Entry {
+            std::vector<glm::mat4> palette = {};
+            bool ready = false;
+        };
+
+        double quantum = 1.0 / 60.0;
+        double pendingQuantum = 1.0 / 60.0;
+        std::mutex mutex = {};
+        std::condition_variable evaluated = {};
+        std::unordered_map<Key, Entry *, KeyHash> lookup = {};
+        /// Entries are reused across frames so palettes keep their allocation.
+        std::vector<std::unique_ptr<Entry>> entries = {};
+        size_t usedEntries = 0;
+        std::atomic<size_t> hits = 0;
+        std::atomic<size_t> misses = 0;
+    };
+}
@@ -0,0 +1,350 @@
+#include "SecondaryMotion.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+#include "Controller/IkSolver.hpp"
+#include "Model/Models/SimdLanes.hpp"
+
+/// Chains are padded to a multiple of the widest SIMD block.
+static constexpr size_t BLOCK_WIDTH = Model::Simd::MAX_WIDTH;
+/// Lengths below this are treated as zero.
+static constexpr float SECONDARY_EPSILON = 1e-6f;
+
+namespace {
+    using Model::Simd::Single;
+    using Model::Simd::Widest;
+
+    /// Raw views of the grid handed to the kernels, see SecondaryMotion::Field.
+    struct Grid {
+        float *x, *y, *z, *previousX, *previousY, *previousZ;
+        const float *targetX, *targetY, *targetZ, *restLength;
+        const float *damping, *stiffness, *gravityX, *gravityY, *gravityZ;
+        const float *sphereX, *sphereY, *sphereZ, *sphereRadius;
+        size_t columns, sphereSlots;
+    };
+
+    /**
+     * Verlet step of chains [first, last) of one level with S::WIDTH chains per step. Velocity
+     * is the distance moved last step, damped, plus gravity, and the result is pulled towards
+     * the animated position.
+     * @return the first chain left unstepped.
+     */
+    template <typename S>
+    size_t integrate(const Grid &grid, size_t level, float stepSquared, size_t first,
+                     size_t last) {
+        auto one    = S::set1(1.0f);
+        auto square = S::set1(stepSquared);
+        size_t row  = level * grid.columns;
+        for (; first + S::WIDTH <= last; first += S::WIDTH) {
+            size_t i       = row + first;
+            auto keep      = S::sub(one, S::load(grid.damping + first));
+            auto stiffness = S::load(grid.stiffness + first);
+            float *positions[3]   = {grid.x, grid.y, grid.z};
+            float *previous[3]    = {grid.previousX, grid.previousY, grid.previousZ};
+            const float *targets[3] = {grid.targetX, grid.targetY, grid.targetZ};
+            const float *gravity[3] = {grid.gravityX, grid.gravityY, grid.gravityZ};
+            for (size_t axis = 0; axis < 3; ++axis) {
+                auto position = S::load(positions[axis] + i);
+                auto velocity = S::mul(S::sub(position, S::load(previous[axis] + i)), keep);
+                S::store(previous[axis] + i, position);
+                position = S::add(S::add(position, velocity),
+                                  S::mul(S::load(gravity[axis] + first), square));
+                position = S::add(position, S::mul(S::sub(S::load(targets[axis] + i), position),
+                                                   stiffness));
+                S::store(positions[axis] + i, position);
+            }
+        }
+        return first;
+    }
+
+    /**
+     * Puts chains [first, last) of one level back at their bone length from the level above,
+     * then pushes them out of their spheres, S::WIDTH chains per step.
+     * @return the first chain left unconstrained.
+     */
+    template <typename S>
+    size_t constrain(const Grid &grid, size_t level, size_t first, size_t last) {
+        auto epsilon = S::set1(SECONDARY_EPSILON);
+        auto zero    = S::set1(0.0f);
+        size_t row   = level * grid.columns;
+        for (; first + S::WIDTH <= last; first += S::WIDTH) {
+            size_t i      = row + first;
+            size_t parent = i - grid.columns;
+            auto x = S::load(grid.x + i);
+            auto y = S::load(grid.y + i);
+            auto z = S::load(grid.z + i);
+            auto parentX = S::load(grid.x + parent);
+            auto parentY = S::load(grid.y + parent);
+            auto parentZ = S::load(grid.z + parent);
+            auto dx = S::sub(x, parentX);
+            auto dy = S::sub(y, parentY);
+            auto dz = S::sub(z, parentZ);
+            auto distance =
+                S::sqrt(S::add(S::add(S::mul(dx, dx), S::mul(dy, dy)), S::mul(dz, dz)));
+            auto ratio = S::div(S::load(grid.restLength + i), S::max(distance, epsilon));
+            x = S::add(parentX, S::mul(dx, ratio));
+            y = S::add(parentY, S::mul(dy, ratio));
+            z = S::add(parentZ, S::mul(dz, ratio));
+
+            // Unused slots have a zero radius and never push.
+            for (size_t slot = 0; slot < grid.sphereSlots; ++slot) {
+                size_t sphere = slot * grid.columns + first;
+                auto sx = S::sub(x, S::load(grid.sphereX + sphere));
+                auto sy = S::sub(y, S::load(grid.sphereY + sphere));
+                auto sz = S::sub(z, S::load(grid.sphereZ + sphere));
+                auto length =
+                    S::sqrt(S::add(S::add(S::mul(sx, sx), S::mul(sy, sy)), S::mul(sz, sz)));
+                auto push = S::div(S::max(S::sub(S::load(grid.sphereRadius + sphere), length),
+                                          zero),
+                                   S::max(length, epsilon));
+                x = S::add(x, S::mul(sx, push));
+                y = S::add(y, S::mul(sy, push));
+                z = S::add(z, S::mul(sz, push));
+            }
+            S::store(grid.x + i, x);
+            S::store(grid.y + i, y);
+            S::store(grid.z + i, z);
+        }
+        return first;
+    }
+}
+
+size_t Controller::SecondaryMotion::addCharacter(std::shared_ptr<Animator> animator) {
+    animator->postProcessed = true;
+    Character character = {};
+    character.animator  = std::move(animator);
+    characters.push_back(std::move(character));
+    return characters.size() - 1;
+}
+
+void Controller::SecondaryMotion::setWorldTransform(size_t character, const glm::mat4 &model) {
+    characters.at(character).world = model;
+}
+
+size_t Controller::SecondaryMotion::addChain(size_t character, const std::vector<size_t> &joints,
+                                             const SecondaryChainSettings &settings) {
+    const auto &skeleton = *characters.at(character).animator->skeleton;
+    if (joints.size() < 2) {
+        throw std::runtime_error("Secondary motion chain needs at least two joints");
+    }
+    for (size_t i = 0; i < joints.size(); ++i) {
+        // Joints past the skinned range are never posed, see Skeleton::partitionSkinnedJoints.
+        if (joints[i] >= skeleton.skinnedJointCount ||
+            (i > 0 && skeleton.parents[joints[i]] != static_cast<int>(joints[i - 1]))) {
+            throw std::runtime_error(
+                "Secondary motion chain joints must be posed and children of each other");
+        }
+    }
+    Chain chain     = {};
+    chain.character = character;
+    chain.joints    = joints;
+    chain.settings  = settings;
+    for (size_t joint : joints) {
+        chain.subtrees.push_back(skeleton.collectSubtree(joint));
+    }
+    chains.push_back(std::move(chain));
+    layout();
+    return chains.size() - 1;
+}
+
+void Controller::SecondaryMotion::addCollider(size_t character, size_t joint,
+                                              const glm::vec3 &offset, float radius) {
+    auto &changed = characters.at(character);
+    if (joint >= changed.animator->skeleton->skinnedJointCount) {
+        throw std::runtime_error("Secondary motion collider must follow a posed joint");
+    }
+    changed.colliders.push_back({joint, offset, radius});
+    layout();
+}
+
+void Controller::SecondaryMotion::reset(size_t character) {
+    for (auto &chain : chains) {
+        if (chain.character == character) {
+            chain.started = false;
+        }
+    }
+}
+
+void Controller::SecondaryMotion::layout() {
+    columns = (chains.size() + BLOCK_WIDTH - 1) / BLOCK_WIDTH * BLOCK_WIDTH;
+    levels  = 0;
+    for (const auto &chain : chains) {
+        levels = std::max(levels, chain.joints.size());
+    }
+    sphereSlots = 0;
+    for (const auto &character : characters) {
+        sphereSlots = std::max(sphereSlots, character.colliders.size());
+    }
+    // Rows move when the grid is resized, so every chain starts over from its animated pose.
+    for (auto &field : particles) {
+        field.assign(levels * columns, 0.0f);
+    }
+    for (auto &field : columnData) {
+        field.assign(columns, 0.0f);
+    }
+    for (auto &field : spheres) {
+        field.assign(sphereSlots * columns, 0.0f);
+    }
+    for (size_t i = 0; i < chains.size(); ++i) {
+        const auto &settings = chains[i].settings;
+        columnData[DAMPING][i]   = settings.damping;
+        columnData[STIFFNESS][i] = settings.stiffness;
+        columnData[GRAVITY_X][i] = settings.gravity.x;
+        columnData[GRAVITY_Y][i] = settings.gravity.y;
+        columnData[GRAVITY_Z][i] = settings.gravity.z;
+        chains[i].started = false;
+    }
+}
+
+float &Controller::SecondaryMotion::at(Field field, size_t level, size_t chain) {
+    return particles[field][level * columns + chain];
+}
+
+void Controller::SecondaryMotion::update(double dt) {
+    auto start = std::chrono::steady_clock::now();
+    stats = {};
+    accumulator += dt;
+    size_t substeps = static_cast<size_t>(accumulator / stepTime);
+    if (substeps > maxSubsteps) {
+        substeps    = maxSubsteps;
+        accumulator = 0.0;
+    } else {
+        accumulator -= static_cast<double>(substeps) * stepTime;
+    }
+
+    for (auto &character : characters) {
+        if (character.animator->posedLastUpdate) {
+            character.toWorld =
+                character.world * character.animator->skeleton->globalInverseTransform;
+        }
+    }
+
+    // Animators that did not pose this tick keep last tick's targets and colliders, their
+    // chains carry on swinging towards them.
+    for (size_t i = 0; i < chains.size(); ++i) {
+        auto &chain           = chains[i];
+        const auto &character = characters[chain.character];
+        if (!character.animator->posedLastUpdate) {
+            continue;
+        }
+        const auto &modelTransforms = character.animator->modelTransforms;
+        glm::vec3 parent = glm::vec3(0.0f);
+        for (size_t level = 0; level < chain.joints.size(); ++level) {
+            glm::vec3 animated = character.toWorld * modelTransforms[chain.joints[level]][3];
+            at(TARGET_X, level, i) = animated.x;
+            at(TARGET_Y, level, i) = animated.y;
+            at(TARGET_Z, level, i) = animated.z;
+            // Bone lengths follow the clip, so scaled joints stretch their chain.
+            at(REST_LENGTH, level, i) = level == 0 ? 0.0f : glm::length(animated - parent);
+            parent = animated;
+            if (!chain.started) {
+                at(X, level, i) = at(PREVIOUS_X, level, i) = animated.x;
+                at(Y, level, i) = at(PREVIOUS_Y, level, i) = animated.y;
+                at(Z, level, i) = at(PREVIOUS_Z, level, i) = animated.z;
+            }
+        }
+        // Levels past the end of a short chain collapse onto its last joint.
+        for (size_t level = chain.joints.size(); level < levels; ++level) {
+            at(REST_LENGTH, level, i) = 0.0f;
+        }
+        chain.started = true;
+        for (size_t slot = 0; slot < sphereSlots; ++slot) {
+            size_t sphere = slot * columns + i;
+            if (slot >= character.colliders.size()) {
+                spheres[SPHERE_RADIUS][sphere] = 0.0f;
+                continue;
+            }
+            const auto &collider = character.colliders[slot];
+            glm::vec4 centre = character.toWorld * modelTransforms[collider.joint] *
+                               glm::vec4(collider.offset, 1.0f);
+            spheres[SPHERE_X][sphere]      = centre.x;
+            spheres[SPHERE_Y][sphere]      = centre.y;
+            spheres[SPHERE_Z][sphere]      = centre.z;
+            spheres[SPHERE_RADIUS][sphere] = collider.radius;
+        }
+    }
+
+    // Anchors slide from where they were to where the clip put them across the substeps.
+    for (size_t chain = 0; chain < columns; ++chain) {
+        columnData[ANCHOR_X][chain] = particles[X][chain];
+        columnData[ANCHOR_Y][chain] = particles[Y][chain];
+        columnData[ANCHOR_Z][chain] = particles[Z][chain];
+    }
+    auto stepSeconds = static_cast<float>(stepTime);
+    for (size_t substep = 1; substep <= substeps; ++substep) {
+        step(static_cast<float>(substep) / static_cast<float>(substeps), stepSeconds);
+    }
+
+    for (auto &character : characters) {
+        if (character.animator->posedLastUpdate) {
+            character.toModel = glm::inverse(character.toWorld);
+        }
+    }
+    for (size_t i = 0; i < chains.size(); ++i) {
+        const auto &chain = chains[i];
+        auto &character   = characters[chain.character];
+        if (!character.animator->posedLastUpdate) {
+            continue;
+        }
+        auto &modelTransforms = character.animator->modelTransforms;
+        scratch.clear();
+        // The root is animated, it stays exactly where the clip put it.
+        scratch.push_back(modelTransforms[chain.joints[0]][3]);
+        for (size_t level = 1; level < chain.joints.size(); ++level) {
+            glm::vec4 simulated(at(X, level, i), at(Y, level, i), at(Z, level, i), 1.0f);
+            scratch.push_back(character.toModel * simulated);
+        }
+        alignChain(chain.joints, chain.subtrees, scratch.data(), false, modelTransforms);
+        character.touched = true;
+        ++stats.chains;
+    }
+    for (auto &character : characters) {
+        if (character.touched) {
+            character.animator->refreshPalette();
+            character.touched = false;
+        }
+    }
+    stats.particles  = levels * columns;
+    stats.substeps   = substeps;
+    stats.updateTime =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void Controller::SecondaryMotion::step(float progression, float stepSeconds) {
+    if (levels == 0) {
+        return;
+    }
+    for (size_t chain = 0; chain < columns; ++chain) {
+        for (size_t axis = 0; axis < 3; ++axis) {
+            float from = columnData[ANCHOR_X + axis][chain];
+            float to   = particles[TARGET_X + axis][chain];
+            particles[X + axis][chain] = particles[PREVIOUS_X + axis][chain] =
+                from + (to - from) * progression;
+        }
+    }
+    Grid grid = {particles[X].data(), particles[Y].data(), particles[Z].data(),
+                 particles[PREVIOUS_X].data(), particles[PREVIOUS_Y].data(),
+                 particles[PREVIOUS_Z].data(), particles[TARGET_X].data(),
+                 particles[TARGET_Y].data(), particles[TARGET_Z].data(),
+                 particles[REST_LENGTH].data(), columnData[DAMPING].data(),
+                 columnData[STIFFNESS].data(), columnData[GRAVITY_X].data(),
+                 columnData[GRAVITY_Y].data(), columnData[GRAVITY_Z].data(),
+                 spheres[SPHERE_X].data(), spheres[SPHERE_Y].data(), spheres[SPHERE_Z].data(),
+                 spheres[SPHERE_RADIUS].data(), columns, sphereSlots};
+    float stepSquared = stepSeconds * stepSeconds;
+    for (size_t level = 1; level < levels; ++level) {
+        size_t first = integrate<Widest>(grid, level, stepSquared, 0, columns);
+        integrate<Single>(grid, level, stepSquared, first, columns);
+    }
+    // Each level is settled against the settled level above it, follow the leader style.
+    for (size_t level = 1; level < levels; ++level) {
+        size_t first = constrain<Widest>(grid, level, 0, columns);
+        constrain<Single>(grid, level, first, columns);
+    }
+}
+
+const Controller::SecondaryMotionStats &Controller::SecondaryMotion::getStats() const {
+    return stats;
+}
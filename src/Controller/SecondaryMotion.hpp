@@ -0,0 +1,151 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include <glm/glm.hpp>
+#include "Controller/Animator.hpp"
+
+namespace Controller {
+    /// How one simulated chain responds to motion.
+    struct SecondaryChainSettings {
+        /// Fraction of velocity lost every step, 0 keeps swinging, 1 stops dead.
+        float damping = 0.1f;
+        /// Fraction of the way back to the animated pose every step.
+        float stiffness = 0.05f;
+        /// World space acceleration in units per second squared.
+        glm::vec3 gravity = glm::vec3(0.0f, -9.81f, 0.0f);
+    };
+
+    /// Work done by the last SecondaryMotion update.
+    struct SecondaryMotionStats {
+        size_t chains = 0;
+        /// Particles stepped, padding included.
+        size_t particles = 0;
+        size_t substeps = 0;
+        /// Seconds spent in the whole update.
+        double updateTime = 0.0;
+    };
+
+    /**
+     * Tails, hair and cloth strips that swing with the motion of the character instead of
+     * following keys. Each chain's first joint follows its clip, every joint below it is a
+     * particle moved by Verlet integration, pulled back towards its animated position, kept at
+     * its bone length from its parent and pushed out of collision spheres.
+     *
+     * Particles of every chain of every character live in one grid stored SoA, level by level:
+     * particle (level, chain) sits at level * columns + chain, so a particle's parent is
+     * exactly one row earlier. Integration and constraints run row by row, 4 (SSE) or 8 (AVX2)
+     * chains at a time whichever character they belong to. Simulation runs in world space at a
+     * fixed step, with at most maxSubsteps steps per update.
+     */
+    class SecondaryMotion {
+      public:
+        /**
+         * Registers a character, its animator stops sharing poses, see Animator::postProcessed.
+         * @param animator of the character.
+         * @return index of the character.
+         */
+        size_t addCharacter(std::shared_ptr<Animator> animator);
+        /**
+         * Sets the matrix the character is drawn with.
+         * @param character index from addCharacter.
+         * @param model transform from the model's space to world space.
+         */
+        void setWorldTransform(size_t character, const glm::mat4 &model);
+        /**
+         * Simulates a chain of joints.
+         * @param character index from addCharacter.
+         * @param joints from the animated root down, see Skeleton::collectChain.
+         * @param settings of the chain.
+         * @return index of the chain.
+         */
+        size_t addChain(size_t character, const std::vector<size_t> &joints,
+                        const SecondaryChainSettings &settings = {});
+        /**
+         * Adds a sphere every chain of the character is kept out of.
+         * @param character index from addCharacter.
+         * @param joint the sphere moves with.
+         * @param offset of the centre in the joint's space.
+         * @param radius in world units.
+         */
+        void addCollider(size_t character, size_t joint, const glm::vec3 &offset, float radius);
+        /**
+         * Restarts every chain of a character from its animated pose, after a teleport for
+         * example.
+         * @param character index from addCharacter.
+         */
+        void reset(size_t character);
+
+        /**
+         * Steps every chain and writes the result into the animators' palettes. Runs after
+         * the animators have been updated.
+         * @param dt the time step.
+         */
+        void update(double dt);
+
+        /// Length of one simulation step in seconds.
+        double stepTime = 1.0 / 120.0;
+        /// Steps allowed per update, time beyond them is dropped rather than caught up.
+        size_t maxSubsteps = 4;
+
+        const SecondaryMotionStats &getStats() const;
+
+      private:
+        struct Chain {
+            size_t character = 0;
+            std::vector<size_t> joints = {};
+            std::vector<std::vector<size_t>> subtrees = {};
+            SecondaryChainSettings settings = {};
+            /// Whether the particles hold a simulated state to continue from.
+            bool started = false;
+        };
+        struct Collider {
+            size_t joint = 0;
+            glm::vec3 offset = glm::vec3(0.0f);
+            float radius = 0.0f;
+        };
+        struct Character {
+            std::shared_ptr<Animator> animator = nullptr;
+            glm::mat4 world = glm::mat4(1.0f);
+            std::vector<Collider> colliders = {};
+            /// Model transforms to world space this tick, and back.
+            glm::mat4 toWorld = glm::mat4(1.0f);
+            glm::mat4 toModel = glm::mat4(1.0f);
+            bool touched = false;
+        };
+        enum Field { X, Y, Z, PREVIOUS_X, PREVIOUS_Y, PREVIOUS_Z, TARGET_X, TARGET_Y, TARGET_Z,
+                     REST_LENGTH, FIELD_COUNT };
+        enum ColumnField { DAMPING, STIFFNESS, GRAVITY_X, GRAVITY_Y, GRAVITY_Z, ANCHOR_X,
+                           ANCHOR_Y, ANCHOR_Z, COLUMN_FIELD_COUNT };
+        enum SphereField { SPHERE_X, SPHERE_Y, SPHERE_Z, SPHERE_RADIUS, SPHERE_FIELD_COUNT };
+
+        std::vector<Character> characters = {};
+        std::vector<Chain> chains = {};
+        /// Chains per level, padded to whole SIMD blocks.
+        size_t columns = 0;
+        /// Joints in the longest chain.
+        size_t levels = 0;
+        /// Most colliders of any character.
+        size_t sphereSlots = 0;
+        /// Per particle state, one array per field of levels * columns entries.
+        std::vector<float> particles[FIELD_COUNT];
+        /// Per chain settings and the anchor position at the start of the update.
+        std::vector<float> columnData[COLUMN_FIELD_COUNT];
+        /// Colliders of each chain's character, sphereSlots * columns entries per field.
+        std::vector<float> spheres[SPHERE_FIELD_COUNT];
+        double accumulator = 0.0;
+        SecondaryMotionStats stats = {};
+        /// Positions of a chain being written back.
+        std::vector<glm::vec3> scratch = {};
+
+        /// Sizes the grid for the registered chains.
+        void layout();
+        float &at(Field field, size_t level, size_t chain);
+        /**
+         * Advances every chain by one fixed step.
+         * @param progression how far the anchors are from where they started this update to
+         * where the clip put them, 0 to 1.
+         * @param stepSeconds length of the step.
+         */
+        void step(float progression, float stepSeconds);
+    };
+}
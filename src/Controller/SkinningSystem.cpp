@@ -0,0 +1,162 @@
+#include "SkinningSystem.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include "Model/Models/Model.hpp"
+
+Controller::SkinningSystem::SkinningSystem() : SkinningSystem(0) {}
+
+Controller::SkinningSystem::SkinningSystem(size_t threadCount) {
+    if (threadCount == 0) {
+        threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    // The thread calling update works through jobs as well.
+    for (size_t i = 1; i < threadCount; ++i) {
+        workers.emplace_back(&SkinningSystem::workerLoop, this);
+    }
+}
+
+Controller::SkinningSystem::~SkinningSystem() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto &worker : workers) {
+        worker.join();
+    }
+}
+
+size_t Controller::SkinningSystem::add(std::shared_ptr<const Animator> animator) {
+    const Model::Model *model = animator->animatedModel;
+    if (model == nullptr) {
+        throw std::runtime_error("Skinned instance has no model");
+    }
+    auto &modelSources = sources[model];
+    if (modelSources == nullptr) {
+        auto converted = std::make_shared<std::vector<Model::SkinningSource>>();
+        for (const auto &mesh : model->meshes) {
+            converted->push_back(Model::SkinningSource::fromVertices(mesh.vertices));
+        }
+        modelSources = std::move(converted);
+    }
+    Instance instance = {};
+    instance.animator = std::move(animator);
+    instance.sources  = modelSources;
+    instance.vertices.resize(modelSources->size());
+    for (size_t mesh = 0; mesh < modelSources->size(); ++mesh) {
+        instance.vertices[mesh].allocate((*modelSources)[mesh]);
+    }
+    instances.push_back(std::move(instance));
+    return instances.size() - 1;
+}
+
+void Controller::SkinningSystem::update() {
+    auto start = std::chrono::steady_clock::now();
+    stats = {};
+    jobs.clear();
+    scheduled.clear();
+    for (size_t i = 0; i < instances.size(); ++i) {
+        const auto &instance = instances[i];
+        if (instance.skinned && instance.poseVersion == instance.animator->poseVersion) {
+            ++stats.unchangedInstances;
+            continue;
+        }
+        size_t palette = instance.animator->getJointTransforms().size();
+        for (size_t mesh = 0; mesh < instance.sources->size(); ++mesh) {
+            const auto &source = (*instance.sources)[mesh];
+            // Checked here, a throw on a worker thread would end the program.
+            if (source.maxBone >= static_cast<int32_t>(palette)) {
+                throw std::runtime_error("Skinned instance has not been posed");
+            }
+            size_t padded = source.getPaddedCount();
+            for (size_t first = 0; first < padded; first += JOB_VERTICES) {
+                jobs.push_back({i, mesh, first, std::min(padded, first + JOB_VERTICES)});
+            }
+            ++stats.meshes;
+            stats.vertices += source.vertexCount;
+        }
+        scheduled.push_back(i);
+    }
+    stats.instances = instances.size();
+    if (!jobs.empty()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            nextJob = 0;
+            remainingJobs = jobs.size();
+            finishedWorkers = 0;
+            ++generation;
+        }
+        wake.notify_all();
+        runJobs();
+        std::unique_lock<std::mutex> lock(mutex);
+        // Every worker has to be done with this generation, one waking late would otherwise
+        // read the jobs of the next update while they are being built.
+        finished.wait(lock, [this] {
+            return remainingJobs == 0 && finishedWorkers == workers.size();
+        });
+    }
+    for (size_t i : scheduled) {
+        instances[i].poseVersion = instances[i].animator->poseVersion;
+        instances[i].skinned     = true;
+    }
+    stats.skinTime =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    stats.verticesPerSecond =
+        stats.skinTime > 0.0 ? static_cast<double>(stats.vertices) / stats.skinTime : 0.0;
+}
+
+const std::vector<Model::SkinnedVertices> &
+Controller::SkinningSystem::getVertices(size_t instance) const {
+    return instances.at(instance).vertices;
+}
+
+uint64_t Controller::SkinningSystem::getPoseVersion(size_t instance) const {
+    const auto &entry = instances.at(instance);
+    return entry.skinned ? entry.poseVersion : 0;
+}
+
+size_t Controller::SkinningSystem::getThreadCount() const {
+    return workers.size() + 1;
+}
+
+const Controller::SkinningStats &Controller::SkinningSystem::getStats() const {
+    return stats;
+}
+
+void Controller::SkinningSystem::workerLoop() {
+    size_t seenGeneration = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || generation != seenGeneration; });
+            if (stopping) {
+                return;
+            }
+            seenGeneration = generation;
+        }
+        runJobs();
+        std::lock_guard<std::mutex> lock(mutex);
+        ++finishedWorkers;
+        finished.notify_all();
+    }
+}
+
+void Controller::SkinningSystem::runJobs() {
+    while (true) {
+        size_t index = nextJob.fetch_add(1);
+        if (index >= jobs.size()) {
+            return;
+        }
+        const auto &job = jobs[index];
+        auto &instance = instances[job.instance];
+        Model::skinVertices((*instance.sources)[job.mesh],
+                            instance.animator->getJointTransforms(), job.first, job.last,
+                            instance.vertices[job.mesh]);
+        if (remainingJobs.fetch_sub(1) == 1) {
+            std::lock_guard<std::mutex> lock(mutex);
+            finished.notify_all();
+        }
+    }
+}
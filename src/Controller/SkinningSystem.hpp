@@ -0,0 +1,132 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "Controller/Animator.hpp"
+#include "Model/Models/CpuSkinning.hpp"
+
+namespace Controller {
+    /// Work done by the last SkinningSystem update.
+    struct SkinningStats {
+        size_t instances = 0;
+        /// Instances whose animator had not produced a new pose, their buffers were kept.
+        size_t unchangedInstances = 0;
+        size_t meshes = 0;
+        /// Vertices skinned, padding excluded.
+        size_t vertices = 0;
+        /// Seconds spent in the whole update.
+        double skinTime = 0.0;
+        /// Vertices skinned per second of skinTime.
+        double verticesPerSecond = 0.0;
+    };
+
+    /**
+     * Skins animated instances on the CPU, for headless servers and tools that need posed
+     * vertices without a GPU, see Model::skinVertices. Meshes are split into jobs of at most
+     * JOB_VERTICES vertices and worked through by a pool of threads like AnimationSystem's, so
+     * one large mesh keeps every thread busy as well as many small ones. Each job writes its
+     * own range of one instance's buffers, so the result does not depend on the thread count.
+     *
+     * Vertices are skinned from the bind pose mesh, blend shapes are not applied.
+     */
+    class SkinningSystem {
+      public:
+        /// Vertices skinned per job.
+        static constexpr size_t JOB_VERTICES = 4096;
+
+        /**
+         * Starts one thread per hardware thread.
+         */
+        SkinningSystem();
+        /**
+         * Starts the worker threads.
+         * @param threadCount total threads used by an update including the caller, 0 picks one
+         * per hardware thread.
+         */
+        explicit SkinningSystem(size_t threadCount);
+        /**
+         * Stops and joins the worker threads.
+         */
+        ~SkinningSystem();
+        SkinningSystem(const SkinningSystem &) = delete;
+        SkinningSystem &operator=(const SkinningSystem &) = delete;
+
+        /**
+         * Registers an instance, it is skinned by every following call to update. The meshes of
+         * a model are converted once and shared by every instance of it.
+         * @param animator of the instance, its model's meshes are skinned with its palette.
+         * @return index of the instance.
+         */
+        size_t add(std::shared_ptr<const Animator> animator);
+        /**
+         * Skins every registered instance with the palette of its last animator update and
+         * returns once all of them are done. Instances whose Animator::poseVersion is the one
+         * they were last skinned with are skipped. Runs after the animators have been updated.
+         */
+        void update();
+        /**
+         * Skinned meshes of an instance from the last update.
+         * @param instance index from add.
+         * @return one buffer per mesh of the model.
+         */
+        const std::vector<Model::SkinnedVertices> &getVertices(size_t instance) const;
+        /**
+         * Pose the buffers of an instance were skinned with, compare against a copy to tell
+         * whether they changed.
+         * @param instance index from add.
+         * @return the animator's poseVersion at the last skinning, 0 if never skinned.
+         */
+        uint64_t getPoseVersion(size_t instance) const;
+
+        size_t getThreadCount() const;
+        const SkinningStats &getStats() const;
+
+      private:
+        struct Instance {
+            std::shared_ptr<const Animator> animator = nullptr;
+            /// Bind pose of each mesh of the model, shared with other instances of it.
+            std::shared_ptr<const std::vector<Model::SkinningSource>> sources = nullptr;
+            std::vector<Model::SkinnedVertices> vertices = {};
+            /// Animator::poseVersion the vertices were skinned with.
+            uint64_t poseVersion = 0;
+            bool skinned = false;
+        };
+        /// A range of one mesh of one instance.
+        struct Job {
+            size_t instance = 0;
+            size_t mesh = 0;
+            size_t first = 0;
+            size_t last = 0;
+        };
+
+        std::vector<Instance> instances = {};
+        /// Converted meshes of each model an instance was added for.
+        std::unordered_map<const Model::Model *,
+                           std::shared_ptr<const std::vector<Model::SkinningSource>>>
+            sources = {};
+        std::vector<Job> jobs = {};
+        /// Instances with jobs this update.
+        std::vector<size_t> scheduled = {};
+        std::vector<std::thread> workers = {};
+        SkinningStats stats = {};
+
+        std::mutex mutex = {};
+        std::condition_variable wake = {};
+        std::condition_variable finished = {};
+        /// Bumped once per update so sleeping workers know there is new work.
+        size_t generation = 0;
+        bool stopping = false;
+        /// Workers done with the current generation.
+        size_t finishedWorkers = 0;
+
+        std::atomic<size_t> nextJob = 0;
+        std::atomic<size_t> remainingJobs = 0;
+
+        void workerLoop();
+        void runJobs();
+    };
+}
@@ -1,5 +1,6 @@
 #include "Scene.hpp"
 #include "Controller/Engine/Engine.hpp"
+#include "Model/Models/ModelManager.hpp"
 
 using Controller::Input::BLUE_InputAction;
 using Controller::Input::BLUE_InputType;
@@ -28,7 +29,23 @@ void Scene::Draw() {
         glm::radians(camera.Zoom),
         static_cast<double>(width) / static_cast<double>(height), 0.1, 100000.0);
     glm::mat4 view = camera.GetViewMatrix();
-    mModel.Draw(projection, view);
+    // Every live palette goes up in one upload, each draw only selects its base.
+    paletteStream.clear(animationSystem.getPaletteEncoding());
+    if (mModel.usesSkinCache() && skinRegistered) {
+        // Only uploads when the animator posed since the last upload.
+        mModel.skinCache.upload(ModelManager::GetModel(mModel.modelID),
+                                skinningSystem.getVertices(skinnedInstance),
+                                skinningSystem.getPoseVersion(skinnedInstance));
+    }
+    if (!mModel.isBaked()) {
+        const auto *encoded = mModel.anim->getEncodedPalette(paletteStream.getEncoding());
+        mModel.paletteBase = encoded != nullptr
+                                 ? paletteStream.addEncoded(*encoded)
+                                 : paletteStream.add(mModel.anim->getJointTransforms());
+    }
+    View::OpenGL::SetupPaletteBuffer(paletteBuffer, paletteTexture, paletteStream.getWords(),
+                                     paletteStream.getEncoding());
+    mModel.Draw(projection, view, sceneTime, paletteTexture, paletteStream.getEncoding());
     //terrain.draw(projection, view);
     glfwSwapBuffers(engine.window);
 }
@@ -45,10 +62,49 @@ void Scene::Update(double t, double dt) {
     if (moveRight) {
         camera.ProcessKeyboard(Camera_Movement::RIGHT, dt);
     }
-    mModel.Update(t, dt);
+    sceneTime = t;
+    // Baked instances are posed by the vertex shader, their animator is not sampled at all.
+    bool animated = !mModel.isBaked();
+    if (animated != animatorRegistered) {
+        if (animated) {
+            animationSystem.add(mModel.anim);
+        } else {
+            animationSystem.remove(mModel.anim);
+        }
+        animatorRegistered = animated;
+    }
+    if (animated) {
+        updateAnimationLod();
+    }
+    animationSystem.update(t, dt);
+    if (mModel.usesSkinCache()) {
+        if (!skinRegistered) {
+            skinnedInstance = skinningSystem.add(mModel.anim);
+            skinRegistered  = true;
+        }
+        skinningSystem.update();
+    }
     //mModel.position.y = terrain.getBLHeight(mModel.position.x, mModel.position.z);
 }
 
+void Scene::updateAnimationLod() {
+    int width = 0, height = 0;
+    auto &engine = BlueEngine::Engine::get();
+    glfwGetWindowSize(engine.window, &width, &height);
+    if (width == 0 || height == 0) {
+        return;
+    }
+    auto fovY = static_cast<float>(glm::radians(camera.Zoom));
+    glm::mat4 projection = glm::perspective(
+        fovY, static_cast<float>(width) / static_cast<float>(height), 0.1f, 100000.0f);
+    glm::mat4 view = camera.GetViewMatrix();
+    float radius = mModel.getBoundingRadius();
+    float size = Controller::AnimationLodPolicy::screenSize(mModel.position, radius, view, fovY);
+    bool visible =
+        Controller::AnimationLodPolicy::isVisible(mModel.position, radius, projection * view);
+    animationSystem.applyLod(*mModel.anim, size, visible);
+}
+
 void Scene::handleInputData(Controller::Input::InputData inputData) {
     auto &engine      = BlueEngine::Engine::get();
     auto handledMouse = false;
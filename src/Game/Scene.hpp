@@ -1,6 +1,9 @@
 #pragma once
 #include <vector>
+#include "Controller/AnimationSystem.hpp"
 #include "Controller/InputManager.hpp"
+#include "Controller/SkinningSystem.hpp"
+#include "Model/Models/PaletteStream.hpp"
 #include "View/EulerCamera.hpp"
 #include "View/Renderer/Shader.hpp"
 #include "Model/MovingModel.hpp"
@@ -14,8 +17,26 @@ class Scene {
     void Update(double t, double dt);
     void handleInputData(Controller::Input::InputData inputData);
   private:
+    /**
+     * Picks the animation level of detail of each instance from the camera.
+     */
+    void updateAnimationLod();
+    /// Total time passed to the last update.
+    double sceneTime = 0.0;
     bool moveForward = false, moveBackward = false, moveLeft = false, moveRight = false;
     Model::MovingModel mModel = {};
+    Controller::AnimationSystem animationSystem = {};
+    /// Whether mModel's animator is in animationSystem, it is left out while the model is baked.
+    bool animatorRegistered = false;
+    /// Palettes of every animated instance drawn this frame, uploaded once before drawing.
+    Model::PaletteStream paletteStream = {};
+    unsigned int paletteBuffer = 0;
+    unsigned int paletteTexture = 0;
+    /// Skins instances drawn from a skin cache, see MovingModel::skinOnce.
+    Controller::SkinningSystem skinningSystem = {};
+    /// Index of mModel in skinningSystem, valid once skinRegistered is set.
+    size_t skinnedInstance = 0;
+    bool skinRegistered = false;
     View::Camera camera = {};
 };
 
@@ -1,11 +1,142 @@
 #include "Animation.hpp"
-Model::Animation::Animation(double time, const std::vector<KeyFrame>& newFrames) {
+
+#include <utility>
+
+/// Keys closer than this are treated as equal when looking for still joints.
+static constexpr float STATIC_EPSILON = 1e-5f;
+
+/**
+ * Whether every key of a channel holds the same value.
+ */
+template<typename Value, typename Distance>
+static bool isConstant(const std::vector<Value> &keys, Distance distance) {
+    for (size_t i = 1; i < keys.size(); ++i) {
+        if (distance(keys.front(), keys[i]) > STATIC_EPSILON) {
+            return false;
+        }
+    }
+    return true;
+}
+
+Model::Animation::Animation(double time, std::vector<JointTrack> newTracks) {
     this->length = time;
-    this->keyFrames = newFrames;
+    this->tracks = std::move(newTracks);
 }
 double Model::Animation::getLength() const {
     return length;
 }
-std::vector<Model::KeyFrame> Model::Animation::getKeyFrames() {
-    return keyFrames;
+const std::vector<Model::JointTrack> &Model::Animation::getTracks() const {
+    return tracks;
+}
+size_t Model::Animation::getTrackCount() const {
+    return compressed ? compressed->tracks.size() : tracks.size();
+}
+size_t Model::Animation::getKeyCount() const {
+    size_t count = 0;
+    for (const auto &track : tracks) {
+        count += track.positions.size() + track.rotations.size();
+    }
+    return count;
+}
+size_t Model::Animation::getMemoryUsage() const {
+    size_t bytes = tracks.size() * sizeof(JointTrack);
+    for (const auto &track : tracks) {
+        bytes += track.positionTimes.size() * sizeof(double) +
+                 track.positions.size() * sizeof(glm::vec3) +
+                 track.rotationTimes.size() * sizeof(double) +
+                 track.rotations.size() * sizeof(glm::quat);
+    }
+    for (const auto &track : morphTracks) {
+        bytes += sizeof(MorphTrack) + track.times.size() * sizeof(double) +
+                 track.weights.size() * sizeof(float);
+    }
+    return bytes;
+}
+void Model::Animation::compress(bool discardSource) {
+    compressed = CompressedAnimation(length, tracks);
+    if (discardSource) {
+        tracks.clear();
+        tracks.shrink_to_fit();
+    }
+}
+void Model::Animation::resample(size_t jointCount, double rate, size_t framesPerPage) {
+    resampled = ResampledAnimation(*this, jointCount, rate, framesPerPage);
+}
+size_t Model::Animation::eliminateStaticJoints(const Skeleton &skeleton) {
+    restPose = skeleton.bindPose;
+    auto translationDistance = [](const glm::vec3 &a, const glm::vec3 &b) {
+        return glm::length(a - b);
+    };
+    auto rotationDistance = [](const glm::quat &a, const glm::quat &b) {
+        return 1.0f - std::abs(glm::dot(a, b));
+    };
+    size_t removed = 0;
+    std::vector<JointTrack> animated = {};
+    for (auto &track : tracks) {
+        if (track.joint >= skeleton.skinnedJointCount) {
+            ++removed;
+            continue;
+        }
+        bool constantPosition = isConstant(track.positions, translationDistance);
+        bool constantRotation = isConstant(track.rotations, rotationDistance);
+        if (constantPosition && !track.positions.empty()) {
+            restPose.translations[track.joint] = track.positions.front();
+            track.positionTimes.clear();
+            track.positions.clear();
+        }
+        if (constantRotation && !track.rotations.empty()) {
+            restPose.rotations[track.joint] = track.rotations.front();
+            track.rotationTimes.clear();
+            track.rotations.clear();
+        }
+        if (track.positions.empty() && track.rotations.empty()) {
+            ++removed;
+            continue;
+        }
+        animated.push_back(std::move(track));
+    }
+    tracks = std::move(animated);
+    return removed;
+}
+const Model::Pose &Model::Animation::getRestPose(const Skeleton &skeleton) const {
+    return restPose.size() == skeleton.size() ? restPose : skeleton.bindPose;
+}
+bool Model::Animation::sample(double time, std::vector<TrackCursor> &cursors, Pose &pose,
+                              const uint8_t *jointMask) const {
+    if (resampled && resampled->sample(time, pose, jointMask)) {
+        return true;
+    }
+    if (compressed) {
+        compressed->sample(time, cursors, pose, jointMask);
+    } else if (resampled && tracks.empty()) {
+        // Streamed from disk with nothing to fall back to.
+        return false;
+    } else {
+        sampleSource(time, cursors, pose, jointMask);
+    }
+    return true;
+}
+void Model::Animation::sampleSource(double time, std::vector<TrackCursor> &cursors, Pose &pose,
+                                    const uint8_t *jointMask) const {
+    cursors.resize(tracks.size());
+    for (size_t i = 0; i < tracks.size(); ++i) {
+        const auto &track = tracks[i];
+        if (jointMask != nullptr && jointMask[track.joint] == 0) {
+            continue;
+        }
+        // Channels emptied by static joint elimination keep the rest pose.
+        if (!track.positions.empty()) {
+            pose.translations[track.joint] = samplePosition(track, cursors[i].position, time);
+        }
+        if (!track.rotations.empty()) {
+            pose.rotations[track.joint] = sampleRotation(track, cursors[i].rotation, time);
+        }
+    }
+}
+void Model::Animation::sampleMorphWeights(double time, std::vector<float> &weights) const {
+    for (const auto &track : morphTracks) {
+        if (track.target < weights.size()) {
+            weights[track.target] = sampleMorphWeight(track, time);
+        }
+    }
 }
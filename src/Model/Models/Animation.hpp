@@ -1,15 +1,99 @@
 #pragma once
-#include "Model/Models/KeyFrame.hpp"
+#include "Model/Models/AnimationTrack.hpp"
+#include "Model/Models/CompressedAnimation.hpp"
+#include "Model/Models/Pose.hpp"
+#include "Model/Models/ResampledAnimation.hpp"
+#include "Model/Models/Skeleton.hpp"
+#include <optional>
 #include <vector>
 
 namespace Model {
     class Animation {
       public:
+        /// Length of the clip in seconds.
         double length = 0;
-        std::vector<KeyFrame> keyFrames = {};
-        Animation(double time, const std::vector<KeyFrame>& newFrames);
+        /// One track per animated joint, empty if discarded after compression.
+        std::vector<JointTrack> tracks = {};
+        /// Blend shape weight tracks, kept at full precision by every representation.
+        std::vector<MorphTrack> morphTracks = {};
+        /// Quantized copy of the tracks, sampled instead of the tracks when present.
+        std::optional<CompressedAnimation> compressed = std::nullopt;
+        /// Fixed rate copy of the clip, sampled instead of any other representation when present.
+        std::optional<ResampledAnimation> resampled = std::nullopt;
+        /// Local pose of every joint the clip does not animate, empty until static joints are
+        /// eliminated.
+        Pose restPose = {};
+        Animation(double time, std::vector<JointTrack> newTracks);
         double getLength() const;
-        std::vector<KeyFrame> getKeyFrames();
+        const std::vector<JointTrack>& getTracks() const;
+        /**
+         * Number of tracks the active representation samples, used to size cursors.
+         * @return track count.
+         */
+        size_t getTrackCount() const;
+        /**
+         * Counts the position and rotation keys stored in the clip.
+         * @return total number of keys.
+         */
+        size_t getKeyCount() const;
+        /**
+         * Approximate heap size of the full precision tracks.
+         * @return size in bytes.
+         */
+        size_t getMemoryUsage() const;
+        /**
+         * Builds the compressed representation of the clip.
+         * @param discardSource releases the full precision tracks when true.
+         */
+        void compress(bool discardSource);
+        /**
+         * Builds the fixed rate representation of the clip.
+         * @param jointCount number of joints in the skeleton.
+         * @param rate sample rate in Hz.
+         * @param framesPerPage frames per streaming page.
+         */
+        void resample(size_t jointCount, double rate, size_t framesPerPage);
+        /**
+         * Moves tracks that hold a joint still into restPose and drops tracks of joints that do
+         * not affect the skin, so sampling only touches animated channels. Run before the clip
+         * is compressed or resampled.
+         * @param skeleton the clip animates, already partitioned.
+         * @return the number of tracks removed.
+         */
+        size_t eliminateStaticJoints(const Skeleton& skeleton);
+        /**
+         * Pose to start sampling from, joints without a track keep it.
+         * @param skeleton the clip animates.
+         * @return restPose, or the bind pose if static joints were never eliminated.
+         */
+        const Pose& getRestPose(const Skeleton& skeleton) const;
+        /**
+         * Samples the clip into a pose. Joints without a track are left untouched, start from
+         * getRestPose to hold them at rest. A resampled clip whose page covering time is not
+         * resident falls back to the compressed or source tracks when they are still held.
+         * @param time in seconds.
+         * @param cursors one cursor per track, updated in place.
+         * @param pose to write the sampled joints into.
+         * @param jointMask optional, joints with a zero entry are skipped.
+         * @return false if nothing could be sampled, pose is left untouched.
+         */
+        bool sample(double time, std::vector<TrackCursor>& cursors, Pose& pose,
+                    const uint8_t* jointMask = nullptr) const;
+        /**
+         * Samples the full precision tracks, ignoring any compressed representation.
+         * @param time in seconds.
+         * @param cursors one cursor per track, updated in place.
+         * @param pose to write the sampled joints into.
+         * @param jointMask optional, joints with a zero entry are skipped.
+         */
+        void sampleSource(double time, std::vector<TrackCursor>& cursors, Pose& pose,
+                          const uint8_t* jointMask = nullptr) const;
+        /**
+         * Samples the blend shape weights the clip animates, other weights are left untouched.
+         * @param time in seconds.
+         * @param weights one per morph target of the model.
+         */
+        void sampleMorphWeights(double time, std::vector<float>& weights) const;
     };
 }
 
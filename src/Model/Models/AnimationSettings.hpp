@@ -0,0 +1,37 @@
+#pragma once
+#include <cstddef>
+
+namespace Model {
+    /**
+     * Options applied to every clip when a model is imported.
+     */
+    struct AnimationSettings {
+        /// Drop keys that interpolation reproduces within the tolerances below.
+        bool reduceKeys = false;
+        /// Largest drift of any end effector, in model units, the removed keys of every joint
+        /// above it may cause together.
+        float positionTolerance = 0.001f;
+        /// Largest rotation error, in radians, a removed key may cause.
+        float angleTolerance = 0.0017f;
+        /// Move tracks that hold a joint still into each clip's rest pose, see
+        /// Animation::eliminateStaticJoints.
+        bool eliminateStaticJoints = true;
+        /// Quantize clips after import, see CompressedAnimation.
+        bool compressClips = false;
+        /// Release the full precision tracks once a clip has been compressed.
+        bool discardSourceTracks = true;
+        /// Rate in Hz the compression error is measured at.
+        double errorSampleRate = 60.0;
+        /// Rate in Hz clips are resampled at for constant time playback, zero disables resampling.
+        double resampleRate = 0.0;
+        /// Frames in each streaming page of a resampled clip.
+        size_t framesPerPage = 64;
+        /// Rate in Hz every clip is baked into a GPU palette stream at, zero disables baking.
+        float bakeRate = 0.0f;
+        /// Upload meshes in the 32 byte PackedVertex layout rather than Vertex, see
+        /// VertexPacking. Meshes that do not fit it keep the Vertex layout.
+        bool packVertices = false;
+        /// Print a summary of Model::importStats once the model is loaded.
+        bool printImportStats = false;
+    };
+}
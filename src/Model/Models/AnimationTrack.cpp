@@ -0,0 +1,29 @@
+#include "AnimationTrack.hpp"
+
+glm::vec3 Model::samplePosition(const Model::JointTrack &track, size_t &cursor, double time) {
+    if (track.positions.size() < 2) {
+        return track.positions.empty() ? glm::vec3(0.0f) : track.positions.front();
+    }
+    cursor = findKey(track.positionTimes, cursor, time);
+    float progression = segmentProgression(track.positionTimes, cursor, time);
+    return glm::mix(track.positions[cursor], track.positions[cursor + 1], progression);
+}
+
+glm::quat Model::sampleRotation(const Model::JointTrack &track, size_t &cursor, double time) {
+    if (track.rotations.size() < 2) {
+        return track.rotations.empty() ? glm::quat(1.0f, 0.0f, 0.0f, 0.0f) : track.rotations.front();
+    }
+    cursor = findKey(track.rotationTimes, cursor, time);
+    float progression = segmentProgression(track.rotationTimes, cursor, time);
+    return glm::slerp(track.rotations[cursor], track.rotations[cursor + 1], progression);
+}
+
+float Model::sampleMorphWeight(const Model::MorphTrack &track, double time) {
+    if (track.weights.size() < 2) {
+        return track.weights.empty() ? 0.0f : track.weights.front();
+    }
+    // Few weight tracks are played at once, a binary search per sample is cheap enough.
+    size_t key = findKey(track.times, 0, time);
+    float progression = segmentProgression(track.times, key, time);
+    return glm::mix(track.weights[key], track.weights[key + 1], progression);
+}
@@ -0,0 +1,111 @@
+#pragma once
+#include <algorithm>
+#include <vector>
+#include <glm/vec3.hpp>
+#include <glm/gtx/quaternion.hpp>
+
+namespace Model {
+    /**
+     * Key frames of a single joint channel. Position and rotation keys keep their own sorted
+     * timestamps (in seconds) so channels are never forced onto shared times.
+     */
+    struct JointTrack {
+        /// Index of the animated joint in the model's pose arrays.
+        size_t joint = 0;
+        std::vector<double> positionTimes = {};
+        std::vector<glm::vec3> positions = {};
+        std::vector<double> rotationTimes = {};
+        std::vector<glm::quat> rotations = {};
+    };
+
+    /// Key frames of one blend shape weight, in seconds.
+    struct MorphTrack {
+        /// Index of the target in the model's morph weights, see Model::morphTargetNames.
+        size_t target = 0;
+        std::vector<double> times = {};
+        std::vector<float> weights = {};
+    };
+
+    /**
+     * Last key used by a track, owned by whoever plays the clip. Playback rarely moves more
+     * than one key per tick, so the cursor is checked before falling back to a binary search.
+     */
+    struct TrackCursor {
+        size_t position = 0;
+        size_t rotation = 0;
+    };
+
+    /**
+     * Finds the key that starts the segment containing time.
+     * @param times sorted key times, in any unit matching time.
+     * @param cursor key found on the previous lookup.
+     * @param time to look up.
+     * @return index i such that times[i] <= time < times[i + 1], clamped to the key range.
+     */
+    template<typename Time>
+    size_t findKey(const std::vector<Time>& times, size_t cursor, double time) {
+        const size_t count = times.size();
+        if (count < 2 || time <= times.front()) {
+            return 0;
+        }
+        if (time >= times[count - 2]) {
+            return count - 2;
+        }
+        // Temporal coherence: the key used last tick or the one after it almost always matches.
+        if (cursor + 1 < count && times[cursor] <= time) {
+            if (time < times[cursor + 1]) {
+                return cursor;
+            }
+            if (cursor + 2 < count && time < times[cursor + 2]) {
+                return cursor + 1;
+            }
+        }
+        // Seek or loop, fall back to a binary search.
+        auto next = std::upper_bound(times.begin(), times.end(), time,
+                                     [](double value, Time key) { return value < key; });
+        return static_cast<size_t>(next - times.begin()) - 1;
+    }
+
+    /**
+     * Progression through the segment starting at key.
+     * @param times sorted key times, in any unit matching time.
+     * @param key segment start returned by findKey.
+     * @param time to look up.
+     * @return progression clamped to [0, 1].
+     */
+    template<typename Time>
+    float segmentProgression(const std::vector<Time>& times, size_t key, double time) {
+        double totalTime = static_cast<double>(times[key + 1]) - static_cast<double>(times[key]);
+        if (totalTime <= 0.0) {
+            return 0.0f;
+        }
+        double progression = (time - static_cast<double>(times[key])) / totalTime;
+        return static_cast<float>(std::clamp(progression, 0.0, 1.0));
+    }
+
+    /**
+     * Samples the position channel of a track.
+     * @param track to sample.
+     * @param cursor position cursor, updated in place.
+     * @param time in seconds.
+     * @return the interpolated position.
+     */
+    glm::vec3 samplePosition(const JointTrack& track, size_t& cursor, double time);
+
+    /**
+     * Samples the rotation channel of a track.
+     * @param track to sample.
+     * @param cursor rotation cursor, updated in place.
+     * @param time in seconds.
+     * @return the interpolated rotation.
+     */
+    glm::quat sampleRotation(const JointTrack& track, size_t& cursor, double time);
+
+    /**
+     * Samples a blend shape weight track.
+     * @param track to sample.
+     * @param time in seconds.
+     * @return the interpolated weight.
+     */
+    float sampleMorphWeight(const MorphTrack& track, double time);
+}
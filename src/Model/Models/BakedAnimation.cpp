@@ -0,0 +1,93 @@
+#include "BakedAnimation.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+Model::BakedAnimation::BakedAnimation(const Skeleton &skeleton,
+                                      const std::vector<Animation> &animations, float newRate) {
+    boneCount = skeleton.getBoneCount();
+    Pose pose = {};
+    std::vector<TrackCursor> cursors = {};
+    std::vector<glm::mat4> modelTransforms(skeleton.size());
+    std::vector<glm::mat4> palette(boneCount);
+    size_t frame = 0;
+    for (const auto &animation : animations) {
+        BakedClip clip = {};
+        clip.firstFrame = frame;
+        clip.rate       = newRate;
+        clip.length     = static_cast<float>(animation.getLength());
+        clip.frameCount = static_cast<size_t>(std::ceil(clip.length * clip.rate)) + 1;
+        rows.resize(rows.size() + clip.frameCount * boneCount * ROWS_PER_BONE);
+
+        pose = animation.getRestPose(skeleton);
+        cursors.assign(animation.getTrackCount(), {});
+        for (size_t i = 0; i < clip.frameCount; ++i, ++frame) {
+            double time = std::min(static_cast<double>(i) / clip.rate, animation.getLength());
+            if (!animation.sample(time, cursors, pose)) {
+                throw std::runtime_error("Clip to bake has pages that are not resident");
+            }
+            skeleton.localToModel(pose, modelTransforms);
+            skeleton.buildPalette(modelTransforms, palette);
+            glm::vec4 *out = &rows[frame * boneCount * ROWS_PER_BONE];
+            for (const auto &transform : palette) {
+                glm::mat4 transposed = glm::transpose(transform);
+                for (size_t row = 0; row < ROWS_PER_BONE; ++row) {
+                    *out++ = transposed[static_cast<int>(row)];
+                }
+            }
+        }
+        clips.push_back(clip);
+    }
+}
+
+size_t Model::BakedAnimation::getBoneCount() const {
+    return boneCount;
+}
+
+size_t Model::BakedAnimation::getClipCount() const {
+    return clips.size();
+}
+
+const Model::BakedClip &Model::BakedAnimation::getClip(size_t clip) const {
+    return clips.at(clip);
+}
+
+const std::vector<glm::vec4> &Model::BakedAnimation::getRows() const {
+    return rows;
+}
+
+glm::mat4 Model::BakedAnimation::getBoneTransform(size_t clip, size_t frame, size_t bone) const {
+    const glm::vec4 *row =
+        &rows[((clips.at(clip).firstFrame + frame) * boneCount + bone) * ROWS_PER_BONE];
+    return glm::transpose(glm::mat4(row[0], row[1], row[2], glm::vec4(0.0f, 0.0f, 0.0f, 1.0f)));
+}
+
+void Model::BakedAnimation::samplePalette(size_t clip, double time,
+                                          std::vector<glm::mat4> &palette) const {
+    const auto &baked = clips.at(clip);
+    palette.resize(boneCount);
+    double wrapped = baked.length > 0.0f ? std::fmod(time, static_cast<double>(baked.length)) : 0.0;
+    if (wrapped < 0.0) {
+        wrapped += baked.length;
+    }
+    double position = wrapped * baked.rate;
+    size_t first    = std::min(static_cast<size_t>(position), baked.frameCount - 1);
+    size_t second   = std::min(first + 1, baked.frameCount - 1);
+    // The closing frame sits at the clip length, so the last segment can be shorter than a
+    // frame and its progression is scaled by its actual duration.
+    double segment   = std::min(1.0, static_cast<double>(baked.length) * baked.rate -
+                                         static_cast<double>(first));
+    auto progression = segment > 0.0
+                           ? static_cast<float>((position - static_cast<double>(first)) / segment)
+                           : 0.0f;
+    for (size_t bone = 0; bone < boneCount; ++bone) {
+        palette[bone] = getBoneTransform(clip, first, bone) * (1.0f - progression) +
+                        getBoneTransform(clip, second, bone) * progression;
+    }
+}
+
+size_t Model::BakedAnimation::getMemoryUsage() const {
+    return sizeof(*this) + clips.capacity() * sizeof(BakedClip) +
+           rows.capacity() * sizeof(glm::vec4);
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "Model/Models/Animation.hpp"
+#include "Model/Models/Skeleton.hpp"
+
+namespace Model {
+    /// Location of one clip inside a BakedAnimation.
+    struct BakedClip {
+        /// Index of the clip's first frame in the palette stream.
+        size_t firstFrame = 0;
+        /// Frames baked for the clip, including a closing frame at its full length.
+        size_t frameCount = 0;
+        /// Frames per second.
+        float rate = 30.0f;
+        /// Length of the clip in seconds.
+        float length = 0.0f;
+    };
+
+    /// Everything a background instance needs to be drawn from a baked palette stream.
+    struct BakedInstance {
+        uint16_t clip = 0;
+        /// Added to the scene time so instances playing the same clip are out of step.
+        float timeOffset = 0.0f;
+    };
+
+    /**
+     * Skinning palettes of every clip of a model, sampled at a fixed rate. Each bone of each
+     * frame is stored as the three rows of its affine transform, so frame f of the stream
+     * holds rows [(f * boneCount + bone) * 3, +3). The stream is uploaded once to a buffer
+     * texture and the vertex shader fetches the frames it needs, so instances cost no CPU
+     * animation work at all.
+     */
+    class BakedAnimation {
+      public:
+        /// vec4 rows stored per bone per frame.
+        static constexpr size_t ROWS_PER_BONE = 3;
+
+        BakedAnimation() = default;
+        /**
+         * Bakes clips on the CPU, no graphics context is required.
+         * @param skeleton the clips animate.
+         * @param animations clips to bake, sampled through their best available representation.
+         * @param newRate frames per second.
+         */
+        BakedAnimation(const Skeleton& skeleton, const std::vector<Animation>& animations,
+                       float newRate);
+
+        size_t getBoneCount() const;
+        size_t getClipCount() const;
+        const BakedClip& getClip(size_t clip) const;
+        /**
+         * The packed palette stream.
+         * @return ROWS_PER_BONE rows per bone per frame.
+         */
+        const std::vector<glm::vec4>& getRows() const;
+        /**
+         * Unpacks one baked bone transform.
+         * @param clip index of the clip.
+         * @param frame within the clip.
+         * @param bone index of the bone.
+         * @return the palette transform.
+         */
+        glm::mat4 getBoneTransform(size_t clip, size_t frame, size_t bone) const;
+        /**
+         * Reconstructs the palette at a time the way the vertex shader does, blending the two
+         * frames around it by where time falls between their times.
+         * @param clip index of the clip.
+         * @param time in seconds, wrapped to the clip length.
+         * @param palette receives one transform per bone.
+         */
+        void samplePalette(size_t clip, double time, std::vector<glm::mat4>& palette) const;
+        size_t getMemoryUsage() const;
+
+      private:
+        size_t boneCount = 0;
+        std::vector<BakedClip> clips = {};
+        std::vector<glm::vec4> rows = {};
+    };
+}
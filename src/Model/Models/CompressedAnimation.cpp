@@ -0,0 +1,168 @@
+#include "CompressedAnimation.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    constexpr float QUANTIZE_16     = 65535.0f;
+    constexpr float QUANTIZE_15     = 32767.0f;
+    constexpr float SMALLEST_THREE  = 0.70710678118f; // 1 / sqrt(2), bound of the three smallest components.
+
+    inline uint16_t quantizeUnit(float value, float scale) {
+        return static_cast<uint16_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * scale));
+    }
+
+    inline uint16_t quantizeTime(double time, double length) {
+        if (length <= 0.0) {
+            return 0;
+        }
+        return quantizeUnit(static_cast<float>(time / length), QUANTIZE_16);
+    }
+
+    inline Model::PackedVec3 packPosition(const glm::vec3 &position, const glm::vec3 &min,
+                                          const glm::vec3 &extent) {
+        Model::PackedVec3 packed = {};
+        for (int i = 0; i < 3; ++i) {
+            float unit = extent[i] > 0.0f ? (position[i] - min[i]) / extent[i] : 0.0f;
+            packed.data[i] = quantizeUnit(unit, QUANTIZE_16);
+        }
+        return packed;
+    }
+
+    inline glm::vec3 unpackPosition(const Model::PackedVec3 &packed, const glm::vec3 &min,
+                                    const glm::vec3 &extent) {
+        return min + extent * glm::vec3(packed.data[0], packed.data[1], packed.data[2]) / QUANTIZE_16;
+    }
+}
+
+Model::PackedQuat Model::CompressedAnimation::packRotation(const glm::quat &rotation) {
+    glm::quat q = glm::normalize(rotation);
+    float components[4] = {q.x, q.y, q.z, q.w};
+    int largest = 0;
+    for (int i = 1; i < 4; ++i) {
+        if (std::abs(components[i]) > std::abs(components[largest])) {
+            largest = i;
+        }
+    }
+    // q and -q are the same rotation, keep the dropped component positive.
+    float sign = components[largest] < 0.0f ? -1.0f : 1.0f;
+    uint64_t bits = static_cast<uint64_t>(largest) << 45u;
+    int shift = 30;
+    for (int i = 0; i < 4; ++i) {
+        if (i == largest) {
+            continue;
+        }
+        float unit = (components[i] * sign / SMALLEST_THREE + 1.0f) * 0.5f;
+        bits |= static_cast<uint64_t>(quantizeUnit(unit, QUANTIZE_15)) << static_cast<unsigned>(shift);
+        shift -= 15;
+    }
+    PackedQuat packed = {};
+    packed.data[0] = static_cast<uint16_t>(bits & 0xFFFFu);
+    packed.data[1] = static_cast<uint16_t>((bits >> 16u) & 0xFFFFu);
+    packed.data[2] = static_cast<uint16_t>((bits >> 32u) & 0xFFFFu);
+    return packed;
+}
+
+glm::quat Model::CompressedAnimation::unpackRotation(const Model::PackedQuat &packed) {
+    uint64_t bits = static_cast<uint64_t>(packed.data[0]) |
+                    (static_cast<uint64_t>(packed.data[1]) << 16u) |
+                    (static_cast<uint64_t>(packed.data[2]) << 32u);
+    auto largest = static_cast<int>((bits >> 45u) & 0x3u);
+    float components[4] = {};
+    float sum = 0.0f;
+    int shift = 30;
+    for (int i = 0; i < 4; ++i) {
+        if (i == largest) {
+            continue;
+        }
+        float unit = static_cast<float>((bits >> static_cast<unsigned>(shift)) & 0x7FFFu) / QUANTIZE_15;
+        components[i] = (unit * 2.0f - 1.0f) * SMALLEST_THREE;
+        sum += components[i] * components[i];
+        shift -= 15;
+    }
+    components[largest] = std::sqrt(std::max(0.0f, 1.0f - sum));
+    return glm::normalize(glm::quat(components[3], components[0], components[1], components[2]));
+}
+
+Model::CompressedAnimation::CompressedAnimation(double length,
+                                               const std::vector<JointTrack> &sourceTracks) {
+    this->length = length;
+    tracks.reserve(sourceTracks.size());
+    for (const auto &source : sourceTracks) {
+        CompressedTrack track = {};
+        track.joint = source.joint;
+        if (!source.positions.empty()) {
+            glm::vec3 min = source.positions.front();
+            glm::vec3 max = min;
+            for (const auto &position : source.positions) {
+                min = glm::min(min, position);
+                max = glm::max(max, position);
+            }
+            track.positionMin    = min;
+            track.positionExtent = max - min;
+        }
+        track.positionTimes.reserve(source.positionTimes.size());
+        track.positions.reserve(source.positions.size());
+        for (size_t i = 0; i < source.positions.size(); ++i) {
+            track.positionTimes.push_back(quantizeTime(source.positionTimes[i], length));
+            track.positions.push_back(
+                packPosition(source.positions[i], track.positionMin, track.positionExtent));
+        }
+        track.rotationTimes.reserve(source.rotationTimes.size());
+        track.rotations.reserve(source.rotations.size());
+        for (size_t i = 0; i < source.rotations.size(); ++i) {
+            track.rotationTimes.push_back(quantizeTime(source.rotationTimes[i], length));
+            track.rotations.push_back(packRotation(source.rotations[i]));
+        }
+        tracks.push_back(std::move(track));
+    }
+}
+
+void Model::CompressedAnimation::sample(double time, std::vector<TrackCursor> &cursors,
+                                        Pose &pose, const uint8_t *jointMask) const {
+    cursors.resize(tracks.size());
+    double scaledTime = length > 0.0 ? time / length * QUANTIZE_16 : 0.0;
+    for (size_t i = 0; i < tracks.size(); ++i) {
+        const auto &track = tracks[i];
+        auto &cursor      = cursors[i];
+        if (jointMask != nullptr && jointMask[track.joint] == 0) {
+            continue;
+        }
+        if (track.positions.size() < 2) {
+            if (!track.positions.empty()) {
+                pose.translations[track.joint] = unpackPosition(
+                    track.positions.front(), track.positionMin, track.positionExtent);
+            }
+        } else {
+            cursor.position  = findKey(track.positionTimes, cursor.position, scaledTime);
+            float progression = segmentProgression(track.positionTimes, cursor.position, scaledTime);
+            glm::vec3 first  = unpackPosition(track.positions[cursor.position], track.positionMin,
+                                              track.positionExtent);
+            glm::vec3 second = unpackPosition(track.positions[cursor.position + 1],
+                                              track.positionMin, track.positionExtent);
+            pose.translations[track.joint] = glm::mix(first, second, progression);
+        }
+        if (track.rotations.size() < 2) {
+            if (!track.rotations.empty()) {
+                pose.rotations[track.joint] = unpackRotation(track.rotations.front());
+            }
+        } else {
+            cursor.rotation   = findKey(track.rotationTimes, cursor.rotation, scaledTime);
+            float progression = segmentProgression(track.rotationTimes, cursor.rotation, scaledTime);
+            pose.rotations[track.joint] =
+                glm::slerp(unpackRotation(track.rotations[cursor.rotation]),
+                           unpackRotation(track.rotations[cursor.rotation + 1]), progression);
+        }
+    }
+}
+
+size_t Model::CompressedAnimation::getMemoryUsage() const {
+    size_t bytes = tracks.size() * sizeof(CompressedTrack);
+    for (const auto &track : tracks) {
+        bytes += track.positionTimes.size() * sizeof(uint16_t) +
+                 track.positions.size() * sizeof(PackedVec3) +
+                 track.rotationTimes.size() * sizeof(uint16_t) +
+                 track.rotations.size() * sizeof(PackedQuat);
+    }
+    return bytes;
+}
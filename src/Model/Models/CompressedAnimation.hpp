@@ -0,0 +1,82 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <glm/vec3.hpp>
+#include <glm/gtx/quaternion.hpp>
+#include "Model/Models/AnimationTrack.hpp"
+#include "Model/Models/Pose.hpp"
+
+namespace Model {
+    /// Rotation stored as smallest-three, 2 bits for the dropped component and 15 bits for each other.
+    struct PackedQuat {
+        uint16_t data[3] = {};
+    };
+
+    /// Translation quantized to 16 bits per component against the range of its track.
+    struct PackedVec3 {
+        uint16_t data[3] = {};
+    };
+
+    /**
+     * A quantized joint track. Key times are stored as 16 bit fractions of the clip length.
+     */
+    struct CompressedTrack {
+        size_t joint = 0;
+        /// Smallest translation in the track.
+        glm::vec3 positionMin = {};
+        /// Size of the translation range, zero on constant axes.
+        glm::vec3 positionExtent = {};
+        std::vector<uint16_t> positionTimes = {};
+        std::vector<PackedVec3> positions = {};
+        std::vector<uint16_t> rotationTimes = {};
+        std::vector<PackedQuat> rotations = {};
+    };
+
+    /**
+     * Accuracy and size of a compressed clip compared to its source tracks.
+     */
+    struct CompressionReport {
+        size_t sourceBytes = 0;
+        size_t compressedBytes = 0;
+        /// Largest model space position error of each joint, indexed by joint index.
+        std::vector<float> jointError = {};
+        float maxError = 0.0f;
+    };
+
+    /**
+     * Compressed form of an Animation, decompressed on the fly while sampling.
+     */
+    class CompressedAnimation {
+      public:
+        /// Length of the clip in seconds.
+        double length = 0;
+        std::vector<CompressedTrack> tracks = {};
+
+        CompressedAnimation() = default;
+        /**
+         * Quantizes a set of tracks.
+         * @param length of the clip in seconds.
+         * @param sourceTracks full precision tracks to compress.
+         */
+        CompressedAnimation(double length, const std::vector<JointTrack>& sourceTracks);
+
+        /**
+         * Samples every track into a pose. Joints without a track are left untouched.
+         * @param time in seconds.
+         * @param cursors one cursor per track, updated in place.
+         * @param pose to write the sampled joints into.
+         * @param jointMask optional, joints with a zero entry are skipped.
+         */
+        void sample(double time, std::vector<TrackCursor>& cursors, Pose& pose,
+                    const uint8_t* jointMask = nullptr) const;
+
+        /**
+         * Approximate heap size of the key data.
+         * @return size in bytes.
+         */
+        size_t getMemoryUsage() const;
+
+        static PackedQuat packRotation(const glm::quat& rotation);
+        static glm::quat unpackRotation(const PackedQuat& packed);
+    };
+}
@@ -0,0 +1,134 @@
+#include "CpuSkinning.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include "Model/Models/SimdLanes.hpp"
+
+namespace {
+    /**
+     * Skins whole steps of S::WIDTH vertices.
+     * @param source bind pose of the mesh.
+     * @param palette first float of the palette.
+     * @param first vertex to skin.
+     * @param last vertex after the range.
+     * @param out skinned vertices.
+     * @return the first vertex not skinned, less than S::WIDTH before last.
+     */
+    template <typename S>
+    size_t skinKernel(const Model::SkinningSource &source, const float *palette, size_t first,
+                      size_t last, Model::SkinnedVertices &out) {
+        using Vector = typename S::Vector;
+        size_t vertex = first;
+        for (; vertex + S::WIDTH <= last; vertex += S::WIDTH) {
+            // Blended matrix, column by column, the bottom row of an affine matrix is constant.
+            Vector blended[12];
+            for (auto &entry : blended) {
+                entry = S::set1(0.0f);
+            }
+            for (size_t influence = 0; influence < NUM_BONES_PER_VEREX; ++influence) {
+                Vector weight = S::load(source.weights[influence].data() + vertex);
+                const int32_t *bones = source.boneOffsets[influence].data() + vertex;
+                for (size_t column = 0; column < 4; ++column) {
+                    for (size_t row = 0; row < 3; ++row) {
+                        Vector entry = S::gather(palette + column * 4 + row, bones);
+                        blended[column * 3 + row] =
+                            S::add(blended[column * 3 + row], S::mul(weight, entry));
+                    }
+                }
+            }
+            Vector x = S::load(source.positionX.data() + vertex);
+            Vector y = S::load(source.positionY.data() + vertex);
+            Vector z = S::load(source.positionZ.data() + vertex);
+            Vector nx = S::load(source.normalX.data() + vertex);
+            Vector ny = S::load(source.normalY.data() + vertex);
+            Vector nz = S::load(source.normalZ.data() + vertex);
+            Vector position[3];
+            Vector normal[3];
+            for (size_t row = 0; row < 3; ++row) {
+                position[row] = S::add(S::add(S::mul(blended[row], x), S::mul(blended[3 + row], y)),
+                                       S::add(S::mul(blended[6 + row], z), blended[9 + row]));
+                normal[row] = S::add(S::add(S::mul(blended[row], nx), S::mul(blended[3 + row], ny)),
+                                     S::mul(blended[6 + row], nz));
+            }
+            // Scaled bones stretch normals, a missing normal stays zero.
+            Vector length = S::sqrt(S::add(
+                S::add(S::mul(normal[0], normal[0]), S::mul(normal[1], normal[1])),
+                S::mul(normal[2], normal[2])));
+            length = S::max(length, S::set1(1e-20f));
+            S::store(out.positionX.data() + vertex, position[0]);
+            S::store(out.positionY.data() + vertex, position[1]);
+            S::store(out.positionZ.data() + vertex, position[2]);
+            S::store(out.normalX.data() + vertex, S::div(normal[0], length));
+            S::store(out.normalY.data() + vertex, S::div(normal[1], length));
+            S::store(out.normalZ.data() + vertex, S::div(normal[2], length));
+        }
+        return vertex;
+    }
+
+    /**
+     * Throws if a palette is too short for a mesh, the kernels read it unchecked.
+     * @param source bind pose of the mesh.
+     * @param palette one transform per bone.
+     */
+    void checkPalette(const Model::SkinningSource &source, const std::vector<glm::mat4> &palette) {
+        if (source.maxBone >= static_cast<int32_t>(palette.size())) {
+            throw std::runtime_error("Skinning palette has fewer bones than the mesh refers to");
+        }
+    }
+}
+
+Model::SkinningSource Model::SkinningSource::fromVertices(const std::vector<Vertex> &vertices) {
+    SkinningSource source = {};
+    source.vertexCount = vertices.size();
+    size_t padded = source.getPaddedCount();
+    for (auto *channel : {&source.positionX, &source.positionY, &source.positionZ,
+                          &source.normalX, &source.normalY, &source.normalZ}) {
+        channel->assign(padded, 0.0f);
+    }
+    for (size_t influence = 0; influence < NUM_BONES_PER_VEREX; ++influence) {
+        source.boneOffsets[influence].assign(padded, 0);
+        source.weights[influence].assign(padded, 0.0f);
+    }
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        const auto &vertex = vertices[i];
+        source.positionX[i] = vertex.Position.x;
+        source.positionY[i] = vertex.Position.y;
+        source.positionZ[i] = vertex.Position.z;
+        source.normalX[i]   = vertex.Normal.x;
+        source.normalY[i]   = vertex.Normal.y;
+        source.normalZ[i]   = vertex.Normal.z;
+        for (size_t influence = 0; influence < NUM_BONES_PER_VEREX; ++influence) {
+            int bone = vertex.BoneIDs[static_cast<glm::length_t>(influence)];
+            if (bone < 0) {
+                throw std::runtime_error("Vertex refers to a negative bone index");
+            }
+            source.boneOffsets[influence][i] = bone * 16;
+            source.weights[influence][i] = vertex.BoneWeight[static_cast<glm::length_t>(influence)];
+            source.maxBone = std::max(source.maxBone, bone);
+        }
+    }
+    return source;
+}
+
+size_t Model::SkinningSource::getPaddedCount() const {
+    return (vertexCount + Simd::MAX_WIDTH - 1) / Simd::MAX_WIDTH * Simd::MAX_WIDTH;
+}
+
+void Model::SkinnedVertices::allocate(const SkinningSource &source) {
+    size_t padded = source.getPaddedCount();
+    for (auto *channel : {&positionX, &positionY, &positionZ, &normalX, &normalY, &normalZ}) {
+        channel->resize(padded);
+    }
+}
+
+void Model::skinVertices(const SkinningSource &source, const std::vector<glm::mat4> &palette,
+                         size_t first, size_t last, SkinnedVertices &out) {
+    checkPalette(source, palette);
+    last = std::min(last, source.getPaddedCount());
+    if (first >= last) {
+        return;
+    }
+    const float *entries = &palette.front()[0][0];
+    size_t next = skinKernel<Simd::Widest>(source, entries, first, last, out);
+    skinKernel<Simd::Single>(source, entries, next, last, out);
+}
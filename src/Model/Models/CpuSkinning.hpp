@@ -0,0 +1,69 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "Model/Models/DataTypes.hpp"
+
+namespace Model {
+    /**
+     * Bind pose of one mesh laid out for CPU skinning: positions, normals and the bone
+     * influences of every vertex stored SoA, padded to a multiple of Simd::MAX_WIDTH with
+     * vertices of zero weight.
+     */
+    struct SkinningSource {
+        /// Vertices of the mesh, without padding.
+        size_t vertexCount = 0;
+        std::vector<float> positionX = {};
+        std::vector<float> positionY = {};
+        std::vector<float> positionZ = {};
+        std::vector<float> normalX = {};
+        std::vector<float> normalY = {};
+        std::vector<float> normalZ = {};
+        /// Float offset of each influence's bone matrix in the palette, bone index * 16.
+        std::array<std::vector<int32_t>, NUM_BONES_PER_VEREX> boneOffsets = {};
+        std::array<std::vector<float>, NUM_BONES_PER_VEREX> weights = {};
+        /// Highest bone index any vertex refers to, -1 for a mesh without bones.
+        int32_t maxBone = -1;
+
+        /**
+         * Copies the parts of a mesh's vertices skinning reads.
+         * @param vertices of the mesh, see Mesh::vertices.
+         * @return the source.
+         */
+        static SkinningSource fromVertices(const std::vector<Vertex> &vertices);
+        /// Vertices including padding.
+        size_t getPaddedCount() const;
+    };
+
+    /// Skinned positions and unit normals of one mesh, SoA, padded like its SkinningSource.
+    struct SkinnedVertices {
+        std::vector<float> positionX = {};
+        std::vector<float> positionY = {};
+        std::vector<float> positionZ = {};
+        std::vector<float> normalX = {};
+        std::vector<float> normalY = {};
+        std::vector<float> normalZ = {};
+
+        /**
+         * Sizes the buffer for a source, keeping its memory when it already fits.
+         * @param source to be skinned into the buffer.
+         */
+        void allocate(const SkinningSource &source);
+    };
+
+    /**
+     * Linear blend skinning on the CPU, the same transform the vertex shader applies, for
+     * bounds, picking and anything else that needs posed vertices without a GPU. Each vertex
+     * blends the matrices of its 4 influences and transforms its position and normal, 4 (SSE)
+     * or 8 (AVX2) vertices at a time with the matrix entries gathered across lanes, then one at a
+     * time for the rest of the range. CpuSkinningTest checks it against glm, vertex by vertex.
+     * @param source bind pose of the mesh.
+     * @param palette one transform per bone, see Animator::getJointTransforms.
+     * @param first vertex to skin, a multiple of Simd::MAX_WIDTH.
+     * @param last vertex after the range, clamped to the padded count.
+     * @param out skinned vertices, allocated for source beforehand.
+     */
+    void skinVertices(const SkinningSource &source, const std::vector<glm::mat4> &palette,
+                      size_t first, size_t last, SkinnedVertices &out);
+}
@@ -1,4 +1,5 @@
 #pragma once
+#include <cstdint>
 #include <string>
 #include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
@@ -17,12 +18,31 @@ struct Vertex {
     glm::vec3 Position = {};
     glm::vec3 Bitangent = {};
     glm::vec3 Tangent = {};
-    glm::vec2 Normal = {};
+    glm::vec3 Normal = {};
     glm::vec2 TexCoords = {};
     glm::ivec4 BoneIDs = {};
     glm::vec4 BoneWeight = {};
 };
 
+/**
+ * Vertex layout for skinned meshes uploaded with AnimationSettings::packVertices, 32 bytes
+ * against the 88 of Vertex. Built by Model::packVertex, vertshader.vs rebuilds the inputs.
+ */
+struct PackedVertex {
+    glm::vec3 Position = {};
+    /// Octahedral normal, two snorm16.
+    int16_t Normal[2] = {};
+    /// Octahedral tangent as two 15 bit unorms (bits 0-14 and 15-29), bit 31 set when the
+    /// bitangent is -cross(normal, tangent).
+    uint32_t Tangent = 0;
+    /// Half floats.
+    uint16_t TexCoords[2] = {};
+    uint8_t BoneIDs[4] = {};
+    /// unorm8, rounded so the 4 weights of a skinned vertex still sum to 1.
+    uint8_t BoneWeight[4] = {};
+};
+static_assert(sizeof(PackedVertex) == 32, "PackedVertex must stay tightly packed");
+
 struct BoneInfo
 {
     glm::mat4 BoneOffset = glm::mat4(1.0f);
@@ -0,0 +1,91 @@
+#include "KeyReduction.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    inline float rotationError(const glm::quat &first, const glm::quat &second) {
+        glm::quat difference = glm::conjugate(first) * second;
+        float sine           = glm::length(glm::vec3(difference.x, difference.y, difference.z));
+        return 2.0f * std::atan2(sine, std::abs(difference.w));
+    }
+
+    inline float progression(const std::vector<double> &times, size_t first, size_t last, size_t key) {
+        double totalTime = times[last] - times[first];
+        if (totalTime <= 0.0) {
+            return 0.0f;
+        }
+        return static_cast<float>((times[key] - times[first]) / totalTime);
+    }
+
+    /**
+     * Greedily extends each segment while every skipped key stays within tolerance.
+     * @return the indices of the keys to keep.
+     */
+    template<typename Value, typename Interpolate, typename Error>
+    std::vector<size_t> fitKeys(const std::vector<double> &times, const std::vector<Value> &values,
+                                Interpolate interpolate, Error withinTolerance) {
+        std::vector<size_t> kept = {};
+        const size_t count = values.size();
+        if (count == 0) {
+            return kept;
+        }
+        kept.push_back(0);
+        // A channel that never leaves its first value only needs one key.
+        bool constant = true;
+        for (size_t i = 1; i < count && constant; ++i) {
+            constant = withinTolerance(values[0], values[i]);
+        }
+        if (constant) {
+            return kept;
+        }
+        size_t anchor = 0;
+        for (size_t end = anchor + 2; end < count; ++end) {
+            bool fits = true;
+            for (size_t key = anchor + 1; key < end && fits; ++key) {
+                auto value = interpolate(values[anchor], values[end], progression(times, anchor, end, key));
+                fits       = withinTolerance(value, values[key]);
+            }
+            if (!fits) {
+                anchor = end - 1;
+                kept.push_back(anchor);
+            }
+        }
+        kept.push_back(count - 1);
+        return kept;
+    }
+
+    template<typename Value>
+    void keepKeys(std::vector<double> &times, std::vector<Value> &values, const std::vector<size_t> &kept) {
+        for (size_t i = 0; i < kept.size(); ++i) {
+            times[i]  = times[kept[i]];
+            values[i] = values[kept[i]];
+        }
+        times.resize(kept.size());
+        values.resize(kept.size());
+        times.shrink_to_fit();
+        values.shrink_to_fit();
+    }
+}
+
+void Model::reduceKeys(JointTrack &track, float positionTolerance, float angleTolerance, float reach,
+                       size_t chainLength) {
+    // Each channel of each joint on the chain gets an equal share of the end effector drift.
+    positionTolerance /= 2.0f * static_cast<float>(std::max<size_t>(chainLength, 1));
+    auto positionKeys = fitKeys(
+        track.positionTimes, track.positions,
+        [](const glm::vec3 &a, const glm::vec3 &b, float t) { return glm::mix(a, b, t); },
+        [positionTolerance](const glm::vec3 &a, const glm::vec3 &b) {
+            return glm::distance(a, b) <= positionTolerance;
+        });
+    keepKeys(track.positionTimes, track.positions, positionKeys);
+
+    auto rotationKeys = fitKeys(
+        track.rotationTimes, track.rotations,
+        [](const glm::quat &a, const glm::quat &b, float t) { return glm::slerp(a, b, t); },
+        [positionTolerance, angleTolerance, reach](const glm::quat &a, const glm::quat &b) {
+            float error = rotationError(a, b);
+            return error <= angleTolerance && error * reach <= positionTolerance;
+        });
+    keepKeys(track.rotationTimes, track.rotations, rotationKeys);
+}
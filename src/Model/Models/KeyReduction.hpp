@@ -0,0 +1,23 @@
+#pragma once
+#include "Model/Models/AnimationTrack.hpp"
+
+namespace Model {
+    /**
+     * Removes keys that linear interpolation between their neighbours already reproduces.
+     *
+     * A rotation error of theta at a joint moves its furthest end effector by at most
+     * reach * theta and a translation error moves it by the same distance. The drift of an end
+     * effector is the sum of these over every joint above it, so positionTolerance is split
+     * evenly across the longest chain through the joint, and between its translation and
+     * rotation keys, which bounds the drift of every end effector in the bind pose by it.
+     * Rotation keys must also satisfy the angular tolerance on their own.
+     * @param track to reduce in place.
+     * @param positionTolerance largest allowed end effector drift in model units.
+     * @param angleTolerance largest allowed rotation error in radians.
+     * @param reach distance in the bind pose from the joint to its furthest end effector.
+     * @param chainLength joints on the longest chain through the joint, see
+     * Skeleton::calculateChainLengths.
+     */
+    void reduceKeys(JointTrack& track, float positionTolerance, float angleTolerance, float reach,
+                    size_t chainLength);
+}
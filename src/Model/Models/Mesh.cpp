@@ -1,9 +1,11 @@
 #include "Mesh.hpp"
 
+#include <algorithm>
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <utility>
+#include "Model/Models/VertexPacking.hpp"
 #include "View/Renderer/OpenGL.hpp"
 
 
@@ -15,11 +17,77 @@ Mesh::Mesh(std::vector<Vertex> newVertices, std::vector<unsigned int> newIndices
 }
 
 void Mesh::Draw(Shader& shader) {
+    shader.setBool("packedVertices", packed);
     View::OpenGL::DrawModel(shader, VAO, textures, indices);
 }
 
-void Mesh::SendMeshToGPU() {
-    View::OpenGL::SetupMesh(VAO, VBO, EBO, this->vertices, this->indices);
+void Mesh::DrawSkinned(Shader& shader, unsigned int skinnedVAO) {
+    View::OpenGL::DrawModel(shader, skinnedVAO, textures, indices);
+}
+
+void Mesh::SetupSkinnedCache(unsigned int &skinnedVAO, unsigned int &skinnedVBO,
+                             size_t paddedCount) const {
+    View::OpenGL::SetupSkinnedMesh(skinnedVAO, skinnedVBO, VBO, EBO, paddedCount, packed);
+}
+
+void Mesh::SendMeshToGPU(bool pack) {
+    packed = pack && Model::canPackVertices(vertices);
+    if (packed) {
+        std::vector<PackedVertex> packedVertices = {};
+        Model::packVertices(vertices, packedVertices);
+        View::OpenGL::SetupPackedMesh(VAO, VBO, EBO, packedVertices, indices);
+    } else {
+        View::OpenGL::SetupMesh(VAO, VBO, EBO, this->vertices, this->indices);
+    }
+}
+
+bool Mesh::isPacked() const {
+    return packed;
+}
+
+size_t Mesh::getVertexMemory() const {
+    return vertices.size() * (packed ? sizeof(PackedVertex) : sizeof(Vertex));
+}
+
+void Mesh::ApplyMorphTargets(const std::vector<float>& weights) {
+    const auto &affected = morphTargets.getVertices();
+    if (affected.empty() || weights.size() < firstMorphTarget + morphTargets.getTargetCount()) {
+        return;
+    }
+    // Animators hold weights still for many frames, unchanged weights leave the buffer as is.
+    const float *meshWeights = weights.data() + firstMorphTarget;
+    if (uploadedWeights.empty()) {
+        uploadedWeights.assign(morphTargets.getTargetCount(), 0.0f);
+    }
+    if (std::equal(uploadedWeights.begin(), uploadedWeights.end(), meshWeights)) {
+        return;
+    }
+    morphTargets.apply(meshWeights, morphBuffer);
+    // Only the range spanning the moved vertices is uploaded, vertices inside it that no
+    // target moves keep their bind pose copy.
+    size_t first = affected.front();
+    if (morphedVertices.empty()) {
+        morphedVertices.assign(vertices.begin() + static_cast<std::ptrdiff_t>(first),
+                               vertices.begin() + static_cast<std::ptrdiff_t>(affected.back()) + 1);
+    }
+    bool normals = !morphBuffer.normalX.empty();
+    for (size_t i = 0; i < affected.size(); ++i) {
+        auto &vertex    = morphedVertices[affected[i] - first];
+        vertex.Position = glm::vec3(morphBuffer.x[i], morphBuffer.y[i], morphBuffer.z[i]);
+        if (normals) {
+            glm::vec3 normal(morphBuffer.normalX[i], morphBuffer.normalY[i],
+                             morphBuffer.normalZ[i]);
+            float length = glm::length(normal);
+            vertex.Normal = length > 0.0f ? normal / length : vertices[affected[i]].Normal;
+        }
+    }
+    if (packed) {
+        Model::packVertices(morphedVertices, packedMorphed);
+        View::OpenGL::UpdateMeshVertices(VBO, first, packedMorphed);
+    } else {
+        View::OpenGL::UpdateMeshVertices(VBO, first, morphedVertices);
+    }
+    uploadedWeights.assign(meshWeights, meshWeights + uploadedWeights.size());
 }
 
 void Mesh::AddBoneData(unsigned VectorID, unsigned BoneID, float Weight) {
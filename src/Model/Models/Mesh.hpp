@@ -7,6 +7,7 @@
 #include <glm/vec3.hpp>
 
 #include "Model/Models/DataTypes.hpp"
+#include "Model/Models/MorphTargets.hpp"
 #include "View/Renderer/Shader.hpp"
 #include "View/Renderer/DrawStruct.hpp"
 
@@ -20,6 +21,10 @@ class Mesh {
     std::vector<TextureB> textures = {};
     /// Index buffer location.
     unsigned int VAO = {};
+    /// Blend shapes of the mesh, empty if it has none.
+    Model::MorphTargets morphTargets = {};
+    /// Index of the mesh's first target in the model's morph weights.
+    size_t firstMorphTarget = 0;
     /**
      * Constructs a mesh object.
      * @param newVertices vertices used in the mesh.
@@ -35,13 +40,62 @@ class Mesh {
      */
     void Draw(Shader& shader);
 
+    /**
+     * Draws the mesh from a cache of its skinned vertices instead of its bind pose.
+     * @param shader used to draw the cache, see skinnedvertshader.vs.
+     * @param skinnedVAO vertex array from SetupSkinnedCache.
+     */
+    void DrawSkinned(Shader& shader, unsigned int skinnedVAO);
+    /**
+     * Creates the buffers of a cache of this mesh's skinned vertices, sharing its texture
+     * coordinates and indices, see View::SkinCache.
+     * @param skinnedVAO receives the vertex array.
+     * @param skinnedVBO receives the skinned vertex buffer.
+     * @param paddedCount vertices in each channel of the skinned vertices.
+     */
+    void SetupSkinnedCache(unsigned int &skinnedVAO, unsigned int &skinnedVBO,
+                           size_t paddedCount) const;
+
     void AddBoneData(unsigned int VectorID, unsigned int BoneID, float Weight);
 
-    void SendMeshToGPU();
+    /**
+     * Uploads the mesh.
+     * @param pack upload it as PackedVertex if every vertex fits, see canPackVertices.
+     */
+    void SendMeshToGPU(bool pack = false);
+    /**
+     * Whether the mesh was uploaded as PackedVertex.
+     * @return true if packed.
+     */
+    bool isPacked() const;
+    /**
+     * Size of the mesh's vertex buffer.
+     * @return size in bytes.
+     */
+    size_t getVertexMemory() const;
+
+    /**
+     * Blends the mesh's targets and uploads the vertices they move. Nothing is blended or
+     * uploaded while the mesh's weights match the ones last uploaded, the bind pose mesh
+     * counting as all zero.
+     * @param weights every morph weight of the model, see Animator::morphWeights.
+     */
+    void ApplyMorphTargets(const std::vector<float>& weights);
 
   private:
     /// Buffer ID's.
     unsigned int VBO = 0, EBO = 0;
+    /// Blended positions and normals of the vertices the targets change.
+    Model::MorphBuffer morphBuffer = {};
+    /// Vertices from the first to the last one a target moves, uploaded after blending.
+    std::vector<Vertex> morphedVertices = {};
+    /// Weights of the mesh's targets the vertex buffer was last blended with, all zero while
+    /// it holds the bind pose mesh.
+    std::vector<float> uploadedWeights = {};
+    /// Whether the vertex buffer holds PackedVertex.
+    bool packed = false;
+    /// morphedVertices packed for upload when the mesh is packed.
+    std::vector<PackedVertex> packedMorphed = {};
 
 
 };
@@ -1,6 +1,8 @@
 #include "Model.hpp"
 
+#include <algorithm>
 #include <iostream>
+#include "Model/Models/KeyReduction.hpp"
 #include "View/Renderer/OpenGL.hpp"
 #include "Controller/Engine/Engine.hpp"
 
@@ -9,11 +11,13 @@ static inline glm::vec2 vec2_cast(const aiVector3D &v) { return glm::vec2(v.x, v
 static inline glm::quat quat_cast(const aiQuaternion &q) { return glm::quat(q.w, q.x, q.y, q.z); }
 static inline glm::mat4 mat4_cast(const aiMatrix4x4 &m) { return glm::transpose(glm::make_mat4(&m.a1)); }
 
-Model::Model::Model(char *path, bool gamma = false) : gammaCorrection(gamma) {
+Model::Model::Model(char *path, bool gamma = false, const AnimationSettings &settings)
+    : gammaCorrection(gamma), animationSettings(settings) {
     loadModel(path);
 }
 
-Model::Model::Model(const string& path, bool gamma = false) : gammaCorrection(gamma) {
+Model::Model::Model(const string& path, bool gamma = false, const AnimationSettings &settings)
+    : gammaCorrection(gamma), animationSettings(settings) {
     loadModel(path);
 }
 
@@ -23,6 +27,15 @@ void Model::Model::Draw(Shader& shader) {
     }
 }
 
+void Model::Model::applyMorphWeights(const std::vector<float> &weights) {
+    if (morphTargetNames.empty()) {
+        return;
+    }
+    for (auto &mesh : meshes) {
+        mesh.ApplyMorphTargets(weights);
+    }
+}
+
 void Model::Model::loadModel(string const &path) {
     // read file via ASSIMP
     Assimp::Importer importer;
@@ -42,14 +55,37 @@ void Model::Model::loadModel(string const &path) {
     globalInverseTransform = glm::inverse(mat4_cast(scene->mRootNode->mTransformation));
     // process ASSIMP's root node recursively
     processNode(scene->mRootNode, scene);
+    LoadSkeleton();
     LoadAnimation(scene);
-    glm::mat4 temp(1.0f);
-    rootJoint->calcInverseBindTransform(temp);
     for (auto &mesh : meshes) {
-        mesh.SendMeshToGPU();
+        mesh.SendMeshToGPU(animationSettings.packVertices);
+        importStats.vertexBytes += mesh.vertices.size() * sizeof(Vertex);
+        importStats.uploadedVertexBytes += mesh.getVertexMemory();
+    }
+    if (animationSettings.bakeRate > 0.0f && !animationList.empty()) {
+        bakeAnimations(animationSettings.bakeRate);
+        uploadBakedAnimations();
+    }
+    if (animationSettings.printImportStats) {
+        PrintImportStats();
+    }
+}
+
+void Model::Model::bakeAnimations(float rate) {
+    bakedAnimation = std::make_shared<const BakedAnimation>(*skeleton, animationList, rate);
+}
+
+void Model::Model::uploadBakedAnimations() {
+    if (bakedAnimation != nullptr) {
+        View::OpenGL::SetupPaletteBuffer(bakedPaletteBuffer, bakedPaletteTexture,
+                                         bakedAnimation->getRows());
     }
 }
 
+void Model::Model::buildMotionDatabase(const MotionFeatureSettings &settings) {
+    motionDatabase = std::make_shared<const MotionDatabase>(*skeleton, animationList, settings);
+}
+
 void Model::Model::processNode(aiNode *node, const aiScene *scene) {
     // process each mesh located at the current node
     for (unsigned int i = 0; i < node->mNumMeshes; i++) {
@@ -57,6 +93,9 @@ void Model::Model::processNode(aiNode *node, const aiScene *scene) {
         // the scene contains all the data, node is just to keep stuff organized (like relations between nodes).
         aiMesh *mesh = scene->mMeshes[node->mMeshes[i]];
         meshes.push_back(processMesh(mesh, scene));
+        if (meshes.back().morphTargets.getTargetCount() > 0) {
+            morphMeshes[node->mName.C_Str()].push_back(meshes.size() - 1);
+        }
         LoadBones(i, mesh);
         LoadJoints(mesh, scene);
     }
@@ -86,6 +125,7 @@ Mesh Model::Model::processMesh(aiMesh *mesh, const aiScene *scene) {
             vector.y        = mesh->mVertices[i].y;
             vector.z        = mesh->mVertices[i].z;
             vertex.Position = vector;
+            boundingRadius  = std::max(boundingRadius, glm::length(vector));
         }
         // normals
         if (mesh->HasNormals()) {
@@ -151,8 +191,49 @@ Mesh Model::Model::processMesh(aiMesh *mesh, const aiScene *scene) {
         loadMaterialTextures(material, aiTextureType_AMBIENT, "texture_height");
     textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
 
+    // blend shapes, stored sparse as most of them move a small part of the mesh
+    std::vector<glm::vec3> basePositions = {};
+    std::vector<glm::vec3> baseNormals = {};
+    std::vector<std::vector<glm::vec3>> targetPositions = {};
+    std::vector<std::vector<glm::vec3>> targetNormals = {};
+    std::vector<std::string> targetNames = {};
+    for (unsigned int i = 0; i < mesh->mNumAnimMeshes; ++i) {
+        const aiAnimMesh *target = mesh->mAnimMeshes[i];
+        auto &positions = targetPositions.emplace_back();
+        auto &normals   = targetNormals.emplace_back();
+        // Targets that only change normals or colours keep the base positions.
+        for (unsigned int j = 0; j < mesh->mNumVertices; ++j) {
+            positions.push_back(target->HasPositions() && j < target->mNumVertices
+                                    ? vec3_cast(target->mVertices[j])
+                                    : vertices[j].Position);
+        }
+        // Targets without normals keep the base normals and store no normal deltas.
+        if (target->HasNormals() && mesh->HasNormals()) {
+            for (unsigned int j = 0; j < mesh->mNumVertices; ++j) {
+                normals.push_back(j < target->mNumVertices ? vec3_cast(target->mNormals[j])
+                                                           : vertices[j].Normal);
+            }
+        }
+        targetNames.emplace_back(target->mName.C_Str());
+    }
+    for (const auto &vertex : vertices) {
+        basePositions.push_back(vertex.Position);
+        if (mesh->HasNormals()) {
+            baseNormals.push_back(vertex.Normal);
+        }
+    }
+
     // return a mesh object created from the extracted mesh data
-    return Mesh(vertices, indices, textures);
+    Mesh result(vertices, indices, textures);
+    if (!targetPositions.empty()) {
+        result.morphTargets     = MorphTargets(basePositions, baseNormals, targetPositions,
+                                               targetNormals, targetNames);
+        result.firstMorphTarget = morphTargetNames.size();
+        morphTargetNames.insert(morphTargetNames.end(), targetNames.begin(), targetNames.end());
+        importStats.morphedVertices += result.morphTargets.getVertices().size();
+        importStats.morphBytes += result.morphTargets.getMemoryUsage();
+    }
+    return result;
 }
 
 std::vector<TextureB> Model::Model::loadMaterialTextures(aiMaterial *mat, aiTextureType type,
@@ -212,59 +293,240 @@ void Model::Model::LoadBones(unsigned MeshIndex, const aiMesh* pMesh)
 
 void Model::Model::LoadJoints(aiMesh *mesh, const aiScene *scene) {
     if (mesh->HasBones()) {
-        auto rootBone = scene->mRootNode->FindNode(mesh->mBones[0]->mName);
-        rootJoint = std::make_shared<Joint>(RecurseJoints(rootBone, scene));
+        skeletonRoot = scene->mRootNode->FindNode(mesh->mBones[0]->mName);
     }
 }
 
-Model::Joint Model::Model::RecurseJoints(aiNode* parent, const aiScene *scene) {
-    auto index = boneMapping[parent->mName.C_Str()];
-    auto parentJoint = Joint(index, parent->mName.C_Str(), mat4_cast(parent->mTransformation));
-    for (size_t i = 0; i < parent->mNumChildren; ++i) {
-        parentJoint.children.push_back(RecurseJoints(parent->mChildren[i], scene));
+void Model::Model::LoadSkeleton() {
+    auto newSkeleton = std::make_shared<Skeleton>();
+    if (skeletonRoot != nullptr) {
+        RecurseJoints(skeletonRoot, -1, *newSkeleton);
     }
-    return parentJoint;
+    newSkeleton->partitionSkinnedJoints();
+    newSkeleton->calcInverseBindTransforms();
+    newSkeleton->globalInverseTransform = globalInverseTransform;
+    for (const auto &bone : boneInfo) {
+        newSkeleton->boneOffsets.push_back(bone.BoneOffset);
+    }
+    skeleton = newSkeleton;
+    skeletonRoot = nullptr;
 }
 
-static inline void InsertKeyFrame(std::vector<Model::KeyFrame>& keyFrames, Model::JointTransform j, const std::string& name, double time) {
-    for (auto &k : keyFrames) {
-        if (k.timeStamp == time) {
-            k.pose.emplace(name, j);
-            return;
-        }
+void Model::Model::RecurseJoints(aiNode *node, int parent, Skeleton &newSkeleton) {
+    const std::string name = node->mName.C_Str();
+    auto bone = boneMapping.find(name);
+    auto boneIndex = bone != boneMapping.end() ? static_cast<int>(bone->second) : -1;
+    auto index = newSkeleton.addJoint(name, parent, boneIndex, mat4_cast(node->mTransformation));
+    for (size_t i = 0; i < node->mNumChildren; ++i) {
+        RecurseJoints(node->mChildren[i], static_cast<int>(index), newSkeleton);
     }
-    Model::KeyFrame key(time);
-    key.pose.emplace(name, j);
-    keyFrames.push_back(key);
 }
 
 void Model::Model::LoadAnimation(const aiScene *scene) {
     if (scene->HasAnimations()) {
+        std::vector<float> jointReach    = skeleton->calculateJointReach();
+        std::vector<size_t> chainLengths = skeleton->calculateChainLengths();
         for (size_t x = 0; x < scene->mNumAnimations; ++x) {
             auto anim = scene->mAnimations[x];
-            std::vector<KeyFrame> keyFrames = {};
+            // Assimp leaves ticks per second at zero when the file does not specify it.
+            double ticksPerSecond = anim->mTicksPerSecond != 0.0 ? anim->mTicksPerSecond : 25.0;
+            std::vector<JointTrack> tracks = {};
             for (size_t i = 0; i < anim->mNumChannels; ++i) {
-                assert(anim->mChannels[i]->mNumPositionKeys == anim->mChannels[i]->mNumRotationKeys);
-                for (size_t ii = 0; ii < anim->mChannels[i]->mNumPositionKeys; ++ii) {
-                    auto j = JointTransform(vec3_cast(anim->mChannels[i]->mPositionKeys[ii].mValue), quat_cast(anim->mChannels[i]->mRotationKeys[ii].mValue));
-                    InsertKeyFrame(keyFrames, j, anim->mChannels[i]->mNodeName.C_Str(), anim->mChannels[i]->mPositionKeys[ii].mTime);
+                auto channel = anim->mChannels[i];
+                // Channels for nodes outside of the skeleton are never applied.
+                auto jointIndex = skeleton->findJoint(channel->mNodeName.C_Str());
+                if (jointIndex < 0) {
+                    continue;
                 }
+                JointTrack track = {};
+                track.joint = static_cast<size_t>(jointIndex);
+                track.positionTimes.reserve(channel->mNumPositionKeys);
+                track.positions.reserve(channel->mNumPositionKeys);
+                for (size_t ii = 0; ii < channel->mNumPositionKeys; ++ii) {
+                    track.positionTimes.push_back(channel->mPositionKeys[ii].mTime / ticksPerSecond);
+                    track.positions.push_back(vec3_cast(channel->mPositionKeys[ii].mValue));
+                }
+                track.rotationTimes.reserve(channel->mNumRotationKeys);
+                track.rotations.reserve(channel->mNumRotationKeys);
+                for (size_t ii = 0; ii < channel->mNumRotationKeys; ++ii) {
+                    track.rotationTimes.push_back(channel->mRotationKeys[ii].mTime / ticksPerSecond);
+                    track.rotations.push_back(quat_cast(channel->mRotationKeys[ii].mValue));
+                }
+                tracks.push_back(std::move(track));
+            }
+            auto &animation = animationList.emplace_back(anim->mDuration / ticksPerSecond, std::move(tracks));
+            auto &stats = importStats.clips.emplace_back();
+            stats.keysBefore = stats.keysAfter = animation.getKeyCount();
+            for (size_t i = 0; i < anim->mNumMorphMeshChannels; ++i) {
+                LoadMorphTracks(anim->mMorphMeshChannels[i], ticksPerSecond,
+                                animation.morphTracks);
+            }
+            if (animationSettings.reduceKeys) {
+                ReduceAnimation(animation, jointReach, chainLengths);
+            }
+            if (animationSettings.eliminateStaticJoints) {
+                animation.eliminateStaticJoints(*skeleton);
+            }
+            stats.keysAfter = animation.getKeyCount();
+            if (animationSettings.compressClips) {
+                CompressAnimation(animation, stats);
+            }
+            if (animationSettings.resampleRate > 0.0) {
+                animation.resample(skeleton->size(), animationSettings.resampleRate,
+                                   animationSettings.framesPerPage);
+                stats.resampledBytes = animation.resampled->getMemoryUsage();
             }
-            animationList.emplace_back(anim->mDuration * anim->mTicksPerSecond, keyFrames);
         }
     }
+    ClassifyJoints();
 }
 
-std::vector<glm::mat4> Model::Model::getJointTransforms() {
-    std::vector<glm::mat4> jointMatrices = {};
-    jointMatrices.resize(50);
-    addJointsToArray(*rootJoint, jointMatrices);
-    return jointMatrices;
+void Model::Model::LoadMorphTracks(const aiMeshMorphAnim *channel, double ticksPerSecond,
+                                   std::vector<MorphTrack> &tracks) const {
+    std::string name = channel->mName.C_Str();
+    auto found = morphMeshes.find(name);
+    if (found == morphMeshes.end()) {
+        // Some exporters suffix the node name, for example "Head*0".
+        found = morphMeshes.find(name.substr(0, name.find('*')));
+    }
+    if (found == morphMeshes.end()) {
+        return;
+    }
+    // Keys list only the targets they set, every other target is at zero on that key.
+    std::map<unsigned int, MorphTrack> channelTracks = {};
+    for (unsigned int k = 0; k < channel->mNumKeys; ++k) {
+        const auto &key = channel->mKeys[k];
+        for (unsigned int v = 0; v < key.mNumValuesAndWeights; ++v) {
+            channelTracks[key.mValues[v]];
+        }
+    }
+    for (auto &entry : channelTracks) {
+        auto &track = entry.second;
+        for (unsigned int k = 0; k < channel->mNumKeys; ++k) {
+            const auto &key = channel->mKeys[k];
+            float weight = 0.0f;
+            for (unsigned int v = 0; v < key.mNumValuesAndWeights; ++v) {
+                if (key.mValues[v] == entry.first) {
+                    weight = static_cast<float>(key.mWeights[v]);
+                }
+            }
+            track.times.push_back(key.mTime / ticksPerSecond);
+            track.weights.push_back(weight);
+        }
+    }
+    // Meshes split by material share the node's targets, each gets its own copy of the track.
+    for (size_t index : found->second) {
+        const auto &mesh = meshes[index];
+        for (const auto &entry : channelTracks) {
+            if (entry.first < mesh.morphTargets.getTargetCount()) {
+                MorphTrack track = entry.second;
+                track.target     = mesh.firstMorphTarget + entry.first;
+                tracks.push_back(std::move(track));
+            }
+        }
+    }
+}
+
+void Model::Model::ClassifyJoints() {
+    jointUsage.assign(skeleton->size(), JointUsage::CONSTANT);
+    std::fill(jointUsage.begin() + static_cast<std::ptrdiff_t>(skeleton->skinnedJointCount),
+              jointUsage.end(), JointUsage::UNUSED);
+    // A track on an unused joint moves nothing that is drawn, the joint stays UNUSED.
+    auto markAnimated = [this](size_t joint) {
+        if (joint < skeleton->skinnedJointCount) {
+            jointUsage[joint] = JointUsage::ANIMATED;
+        }
+    };
+    for (const auto &animation : animationList) {
+        if (animation.compressed) {
+            for (const auto &track : animation.compressed->tracks) {
+                markAnimated(track.joint);
+            }
+        } else {
+            for (const auto &track : animation.getTracks()) {
+                markAnimated(track.joint);
+            }
+        }
+    }
 }
 
-void Model::Model::addJointsToArray(Joint& headJoint, std::vector<glm::mat4>& jointMatrices) {
-    jointMatrices[headJoint.index] = headJoint.getAnimatedTransform();
-    for (Joint& childJoint : headJoint.children) {
-        addJointsToArray(childJoint, jointMatrices);
+Model::CompressionReport Model::Model::measureCompressionError(const Animation &animation) const {
+    CompressionReport report = {};
+    if (!animation.compressed || animation.getTracks().empty()) {
+        return report;
     }
-}
\ No newline at end of file
+    report.sourceBytes     = animation.getMemoryUsage();
+    report.compressedBytes = animation.compressed->getMemoryUsage();
+    report.jointError.assign(skeleton->size(), 0.0f);
+
+    // Joints without a track are held at the clip's rest pose during playback, an identity
+    // pose would measure the hierarchy without their bind offsets.
+    Pose sourcePose     = animation.getRestPose(*skeleton);
+    Pose compressedPose = sourcePose;
+    std::vector<TrackCursor> sourceCursors = {};
+    std::vector<TrackCursor> compressedCursors = {};
+    std::vector<glm::mat4> sourceTransforms = {};
+    std::vector<glm::mat4> compressedTransforms = {};
+    auto samples = static_cast<size_t>(std::ceil(animation.getLength() * animationSettings.errorSampleRate));
+    for (size_t i = 0; i <= samples; ++i) {
+        double time = samples > 0 ? animation.getLength() * static_cast<double>(i) / static_cast<double>(samples) : 0.0;
+        animation.sampleSource(time, sourceCursors, sourcePose);
+        animation.compressed->sample(time, compressedCursors, compressedPose);
+        skeleton->localToModel(sourcePose, sourceTransforms);
+        skeleton->localToModel(compressedPose, compressedTransforms);
+        for (size_t joint = 0; joint < skeleton->size(); ++joint) {
+            float error = glm::distance(glm::vec3(sourceTransforms[joint][3]),
+                                        glm::vec3(compressedTransforms[joint][3]));
+            report.jointError[joint] = std::max(report.jointError[joint], error);
+            report.maxError          = std::max(report.maxError, error);
+        }
+    }
+    return report;
+}
+
+void Model::Model::CompressAnimation(Animation &animation, ClipImportStats &stats) {
+    animation.compress(false);
+    stats.compression = measureCompressionError(animation);
+    if (animationSettings.discardSourceTracks) {
+        animation.tracks.clear();
+        animation.tracks.shrink_to_fit();
+    }
+}
+
+void Model::Model::ReduceAnimation(Animation &animation, const std::vector<float> &jointReach,
+                                   const std::vector<size_t> &chainLengths) {
+    for (auto &track : animation.tracks) {
+        reduceKeys(track, animationSettings.positionTolerance, animationSettings.angleTolerance,
+                   jointReach[track.joint], chainLengths[track.joint]);
+    }
+}
+
+void Model::Model::PrintImportStats() const {
+    for (size_t i = 0; i < importStats.clips.size(); ++i) {
+        const auto &clip = importStats.clips[i];
+        std::cout << "Animation " << i << ": " << clip.keysBefore << " -> " << clip.keysAfter
+                  << " keys";
+        if (clip.compression.compressedBytes > 0) {
+            std::cout << ", compressed " << clip.compression.sourceBytes << " -> "
+                      << clip.compression.compressedBytes << " bytes, max joint error "
+                      << clip.compression.maxError;
+        }
+        if (clip.resampledBytes > 0) {
+            std::cout << ", resampled " << clip.resampledBytes << " bytes";
+        }
+        std::cout << "\n";
+    }
+    auto count = [this](JointUsage usage) {
+        return std::count(jointUsage.begin(), jointUsage.end(), usage);
+    };
+    std::cout << "Skeleton " << skeleton->size() << " joints, " << count(JointUsage::ANIMATED)
+              << " animated, " << count(JointUsage::CONSTANT) << " constant, "
+              << count(JointUsage::UNUSED) << " unused\n";
+    std::cout << "Vertices " << importStats.uploadedVertexBytes << " of "
+              << importStats.vertexBytes << " bytes uploaded, " << importStats.morphedVertices
+              << " morphed in " << importStats.morphBytes << " bytes\n";
+    if (bakedAnimation != nullptr) {
+        std::cout << "Baked at " << animationSettings.bakeRate << " Hz, "
+                  << bakedAnimation->getMemoryUsage() << " bytes\n";
+    }
+}
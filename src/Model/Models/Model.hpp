@@ -1,7 +1,8 @@
 #pragma once
+#include <map>
+#include <memory>
 #include <string>
 #include <vector>
-#include <map>
 #include <assimp/Importer.hpp>
 #include <assimp/postprocess.h>
 #include <assimp/scene.h>
@@ -10,9 +11,41 @@
 
 #include "Mesh.hpp"
 #include "View/Renderer/Shader.hpp"
-#include "Model/Models/Joint.hpp"
+#include "Model/Models/Skeleton.hpp"
 #include "Model/Models/Animation.hpp"
+#include "Model/Models/AnimationSettings.hpp"
+#include "Model/Models/BakedAnimation.hpp"
+#include "Model/Models/MotionDatabase.hpp"
 namespace Model {
+    /**
+     * What import did to one clip.
+     */
+    struct ClipImportStats {
+        /// Keys as imported and after key reduction and static joint elimination.
+        size_t keysBefore = 0;
+        size_t keysAfter = 0;
+        /// Accuracy of the compressed clip, empty if the clip was not compressed.
+        CompressionReport compression = {};
+        /// Size of the resampled clip, zero if the clip was not resampled.
+        size_t resampledBytes = 0;
+    };
+
+    /**
+     * Statistics gathered while a model was imported.
+     */
+    struct ImportStats {
+        /// Vertex memory of every mesh in the Vertex layout.
+        size_t vertexBytes = 0;
+        /// Vertex memory uploaded, smaller than vertexBytes when meshes were packed.
+        size_t uploadedVertexBytes = 0;
+        /// Vertices moved by at least one blend shape, across every mesh.
+        size_t morphedVertices = 0;
+        /// Memory of every mesh's blend shape deltas.
+        size_t morphBytes = 0;
+        /// One entry per clip of animationList.
+        std::vector<ClipImportStats> clips = {};
+    };
+
     class Model {
       public:
         /// Textures IDs that have been loaded.
@@ -27,29 +60,77 @@ namespace Model {
         std::map<std::string, unsigned int> boneMapping = {};
         glm::mat4 globalInverseTransform = {};
         int numBones = 0;
-        std::shared_ptr<Joint> rootJoint = nullptr;
+        /// Flattened joint hierarchy, shared read-only with every animator playing this model.
+        std::shared_ptr<const Skeleton> skeleton = std::make_shared<const Skeleton>();
         std::vector<Animation> animationList = {};
+        /// Usage of each joint across every clip, filled in once the animations are loaded.
+        std::vector<JointUsage> jointUsage = {};
+        /// Distance from the model origin to its furthest vertex in bind pose, used for culling.
+        float boundingRadius = 0.0f;
+        /// Palette stream of every clip for GPU playback, null until the clips are baked.
+        std::shared_ptr<const BakedAnimation> bakedAnimation = nullptr;
+        /// Buffer holding the baked palette stream.
+        unsigned int bakedPaletteBuffer = 0;
+        /// Buffer texture the vertex shader reads the baked palette stream through.
+        unsigned int bakedPaletteTexture = 0;
+        /// Features of every clip for motion matching, null until built.
+        std::shared_ptr<const MotionDatabase> motionDatabase = nullptr;
+        /// Name of every blend shape, indexes Animator::morphWeights. Each mesh owns a range.
+        std::vector<std::string> morphTargetNames = {};
+        /// Options used when the animations were imported.
+        AnimationSettings animationSettings = {};
+        /// Sizes and errors measured while loading, printed only if
+        /// AnimationSettings::printImportStats is set.
+        ImportStats importStats = {};
 
         /**
          * Constructor for the model.
          * @param path path to the model
          * @param gamma correction if required.
+         * @param settings applied to the imported animations.
          */
-        Model(char *path, bool gamma);
+        Model(char *path, bool gamma, const AnimationSettings& settings = {});
         /**
          * Constructor for the model.
          * @param path path to the model
          * @param gamma correction if required.
+         * @param settings applied to the imported animations.
          */
-        Model(const std::string& path, bool gamma);
+        Model(const std::string& path, bool gamma, const AnimationSettings& settings = {});
 
         /**
          * Draw call for the model
          * @param shader used to draw the model.
          */
         void Draw(Shader& shader);
+        /**
+         * Blends the morph targets of every mesh and uploads the moved vertices. Meshes are
+         * shared by every instance, so call it before drawing each instance.
+         * @param weights one per entry of morphTargetNames.
+         */
+        void applyMorphWeights(const std::vector<float>& weights);
+
+        /**
+         * Bakes every clip into a palette stream on the CPU, see BakedAnimation.
+         * @param rate frames per second.
+         */
+        void bakeAnimations(float rate);
+        /**
+         * Uploads the baked palette stream into a buffer texture, requires a graphics context.
+         */
+        void uploadBakedAnimations();
+        /**
+         * Builds the motion matching features of every clip, see MotionDatabase.
+         * @param settings features to extract.
+         */
+        void buildMotionDatabase(const MotionFeatureSettings& settings);
 
-        std::vector<glm::mat4> getJointTransforms();
+        /**
+         * Measures how far each joint of a compressed clip drifts from its source tracks.
+         * @param animation clip that still holds both representations.
+         * @return the error report, empty if the clip is not compressed or has no source.
+         */
+        CompressionReport measureCompressionError(const Animation& animation) const;
 
       private:
         /**
@@ -76,9 +157,33 @@ namespace Model {
 
         void LoadBones(unsigned int MeshIndex, const aiMesh *pMesh);
         void LoadJoints(aiMesh *mesh, const aiScene *scene);
-        Joint RecurseJoints(aiNode* parent, const aiScene *scene);
+        void LoadSkeleton();
+        void RecurseJoints(aiNode* node, int parent, Skeleton &newSkeleton);
         void LoadAnimation(const aiScene *scene);
-        void addJointsToArray(Joint &headJoint, std::vector<glm::mat4> &jointMatrices);
+        /**
+         * Converts a morph channel into one weight track per target it animates.
+         * @param channel to convert.
+         * @param ticksPerSecond of the clip.
+         * @param tracks to append to.
+         */
+        void LoadMorphTracks(const aiMeshMorphAnim *channel, double ticksPerSecond,
+                             std::vector<MorphTrack> &tracks) const;
+        /**
+         * Classifies every joint as animated, constant or unused, see JointUsage.
+         */
+        void ClassifyJoints();
+        void CompressAnimation(Animation &animation, ClipImportStats &stats);
+        void ReduceAnimation(Animation &animation, const std::vector<float> &jointReach,
+                             const std::vector<size_t> &chainLengths);
+        /**
+         * Prints one line per clip and the model wide totals of importStats.
+         */
+        void PrintImportStats() const;
+
+        /// Node the skeleton is built from once every mesh has been processed.
+        aiNode *skeletonRoot = nullptr;
+        /// Meshes with morph targets under each node, morph channels are named after the node.
+        std::map<std::string, std::vector<size_t>> morphMeshes = {};
 
     };
 }
\ No newline at end of file
@@ -2,11 +2,12 @@
 
 #include <map>
 
-auto ModelManager::GetModelID(const std::string& filename) -> size_t {
+auto ModelManager::GetModelID(const std::string& filename,
+                              const Model::AnimationSettings& settings) -> size_t {
     static std::map<std::string, size_t> nameToId = {};
     auto id                                       = nameToId.find(filename);
     if (id == nameToId.end()) { // file not loaded yet
-        ModelRepo().emplace_back(filename, false);
+        ModelRepo().emplace_back(filename, false, settings);
         nameToId.emplace(filename, ModelRepo().size() - 1);
         return ModelRepo().size() - 1;
     } else {
@@ -6,7 +6,8 @@
 class ModelManager {
   public:
     static auto ModelRepo() -> std::vector<Model::Model> &;
-    static auto GetModelID(const std::string& filename) -> size_t;
+    static auto GetModelID(const std::string& filename,
+                           const Model::AnimationSettings& settings = {}) -> size_t;
     static void Draw(size_t id, Shader *ourShader);
 
     friend class ResourceManager;
@@ -0,0 +1,219 @@
+#include "MorphTargets.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <glm/geometric.hpp>
+#include "Model/Models/SimdLanes.hpp"
+
+/// Weights closer to zero than this leave a target out of the blend.
+static constexpr float MIN_MORPH_WEIGHT = 1e-4f;
+/// Normal offsets no longer than this are dropped.
+static constexpr float MIN_NORMAL_OFFSET = 1e-4f;
+/// Unmoved vertices between two moved ones are stored as zero offsets if there are at most
+/// this many, longer spans vectorize better than more of them.
+static constexpr uint32_t MAX_SPAN_GAP = 8;
+static constexpr float QUANTIZED_MAX = 32767.0f;
+
+namespace {
+    using Model::Simd::Single;
+    using Model::Simd::Widest;
+
+    /**
+     * Adds weight times deltas [first, last) of a span onto the values they offset, with
+     * S::WIDTH vertices per step.
+     * @param deltas x, y and z deltas of the span's first vertex.
+     * @param values x, y and z values of the span's first vertex.
+     * @return the first delta left unapplied.
+     */
+    template <typename S>
+    uint32_t accumulate(const int16_t *const (&deltas)[3], float *const (&values)[3],
+                        float weight, uint32_t first, uint32_t last) {
+        auto scale = S::set1(weight);
+        for (; first + S::WIDTH <= last; first += S::WIDTH) {
+            for (size_t axis = 0; axis < 3; ++axis) {
+                float *value = values[axis] + first;
+                S::store(value, S::add(S::load(value),
+                                       S::mul(S::loadInt16(deltas[axis] + first), scale)));
+            }
+        }
+        return first;
+    }
+
+    /**
+     * Adds a span of quantized deltas onto the values they offset.
+     */
+    void accumulateSpan(const std::vector<int16_t> &x, const std::vector<int16_t> &y,
+                        const std::vector<int16_t> &z, const Model::MorphSpan &span, float weight,
+                        std::vector<float> &valueX, std::vector<float> &valueY,
+                        std::vector<float> &valueZ) {
+        const int16_t *const deltas[3] = {&x[span.offset], &y[span.offset], &z[span.offset]};
+        float *const values[3] = {&valueX[span.first], &valueY[span.first], &valueZ[span.first]};
+        uint32_t first = accumulate<Widest>(deltas, values, weight, 0, span.count);
+        accumulate<Single>(deltas, values, weight, first, span.count);
+    }
+
+    /// Quantizes offsets against the largest component of a target.
+    struct Quantizer {
+        float scale = 0.0f;
+
+        int16_t operator()(float offset) const {
+            return scale > 0.0f ? static_cast<int16_t>(std::lround(offset / scale)) : 0;
+        }
+    };
+}
+
+Model::MorphTargets::MorphTargets(const std::vector<glm::vec3> &basePositions,
+                                  const std::vector<glm::vec3> &baseNormals,
+                                  const std::vector<std::vector<glm::vec3>> &targetPositions,
+                                  const std::vector<std::vector<glm::vec3>> &targetNormals,
+                                  const std::vector<std::string> &names, float threshold) {
+    auto hasNormals = [&](size_t target) {
+        return !baseNormals.empty() && target < targetNormals.size() &&
+               !targetNormals[target].empty();
+    };
+    auto normalOffset = [&](size_t target, size_t vertex) {
+        const auto &normals = targetNormals[target];
+        return vertex < normals.size() && vertex < baseNormals.size()
+                   ? normals[vertex] - baseNormals[vertex]
+                   : glm::vec3(0.0f);
+    };
+    // Whether a target moves a vertex or turns its normal.
+    auto changes = [&](size_t target, size_t vertex) {
+        const auto &positions = targetPositions[target];
+        if (vertex < positions.size() &&
+            glm::length(positions[vertex] - basePositions[vertex]) > threshold) {
+            return true;
+        }
+        return hasNormals(target) && glm::length(normalOffset(target, vertex)) > MIN_NORMAL_OFFSET;
+    };
+    bool anyNormals = false;
+    for (size_t i = 0; i < targetPositions.size(); ++i) {
+        anyNormals = anyNormals || hasNormals(i);
+    }
+    for (uint32_t vertex = 0; vertex < basePositions.size(); ++vertex) {
+        bool changed = false;
+        for (size_t i = 0; i < targetPositions.size() && !changed; ++i) {
+            changed = changes(i, vertex);
+        }
+        if (changed) {
+            vertices.push_back(vertex);
+            base.x.push_back(basePositions[vertex].x);
+            base.y.push_back(basePositions[vertex].y);
+            base.z.push_back(basePositions[vertex].z);
+            if (anyNormals) {
+                glm::vec3 normal = vertex < baseNormals.size() ? baseNormals[vertex] : glm::vec3(0.0f);
+                base.normalX.push_back(normal.x);
+                base.normalY.push_back(normal.y);
+                base.normalZ.push_back(normal.z);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < targetPositions.size(); ++i) {
+        const auto &positions = targetPositions[i];
+        bool normals          = hasNormals(i);
+        MorphTarget target    = {};
+        target.name = i < names.size() ? names[i] : std::string{};
+        float largest       = 0.0f;
+        float largestNormal = 0.0f;
+        for (uint32_t vertex : vertices) {
+            if (vertex < positions.size()) {
+                glm::vec3 offset = glm::abs(positions[vertex] - basePositions[vertex]);
+                largest = std::max(largest, std::max(offset.x, std::max(offset.y, offset.z)));
+            }
+            if (normals) {
+                glm::vec3 offset = glm::abs(normalOffset(i, vertex));
+                largestNormal = std::max(largestNormal,
+                                         std::max(offset.x, std::max(offset.y, offset.z)));
+            }
+        }
+        target.scale       = largest / QUANTIZED_MAX;
+        target.normalScale = largestNormal / QUANTIZED_MAX;
+        Quantizer quantize       = {target.scale};
+        Quantizer quantizeNormal = {target.normalScale};
+        bool storeNormals        = target.normalScale > 0.0f;
+        auto push = [&](const glm::vec3 &offset, const glm::vec3 &normal) {
+            target.x.push_back(quantize(offset.x));
+            target.y.push_back(quantize(offset.y));
+            target.z.push_back(quantize(offset.z));
+            if (storeNormals) {
+                target.normalX.push_back(quantizeNormal(normal.x));
+                target.normalY.push_back(quantizeNormal(normal.y));
+                target.normalZ.push_back(quantizeNormal(normal.z));
+            }
+        };
+        // Last affected vertex of the open span, spans close once the gap grows too long.
+        uint32_t previous = 0;
+        for (uint32_t local = 0; local < vertices.size(); ++local) {
+            uint32_t vertex = vertices[local];
+            if (!changes(i, vertex)) {
+                continue;
+            }
+            if (target.spans.empty() || local - previous > MAX_SPAN_GAP + 1) {
+                target.spans.push_back({local, 0, static_cast<uint32_t>(target.x.size())});
+            } else {
+                for (uint32_t gap = previous + 1; gap < local; ++gap) {
+                    push(glm::vec3(0.0f), glm::vec3(0.0f));
+                }
+            }
+            glm::vec3 offset = vertex < positions.size()
+                                   ? positions[vertex] - basePositions[vertex]
+                                   : glm::vec3(0.0f);
+            push(offset, normals ? normalOffset(i, vertex) : glm::vec3(0.0f));
+            target.spans.back().count = static_cast<uint32_t>(target.x.size()) -
+                                        target.spans.back().offset;
+            previous = local;
+        }
+        targets.push_back(std::move(target));
+    }
+}
+
+bool Model::MorphTargets::apply(const float *weights, MorphBuffer &buffer) const {
+    buffer.x = base.x;
+    buffer.y = base.y;
+    buffer.z = base.z;
+    buffer.normalX = base.normalX;
+    buffer.normalY = base.normalY;
+    buffer.normalZ = base.normalZ;
+    bool blended = false;
+    for (size_t i = 0; i < targets.size(); ++i) {
+        if (std::abs(weights[i]) < MIN_MORPH_WEIGHT) {
+            continue;
+        }
+        const auto &target = targets[i];
+        float weight       = weights[i] * target.scale;
+        float normalWeight = weights[i] * target.normalScale;
+        for (const auto &span : target.spans) {
+            accumulateSpan(target.x, target.y, target.z, span, weight, buffer.x, buffer.y,
+                           buffer.z);
+            if (!target.normalX.empty()) {
+                accumulateSpan(target.normalX, target.normalY, target.normalZ, span,
+                               normalWeight, buffer.normalX, buffer.normalY, buffer.normalZ);
+            }
+        }
+        blended = true;
+    }
+    return blended;
+}
+
+size_t Model::MorphTargets::getTargetCount() const {
+    return targets.size();
+}
+
+const Model::MorphTarget &Model::MorphTargets::getTarget(size_t target) const {
+    return targets.at(target);
+}
+
+const std::vector<uint32_t> &Model::MorphTargets::getVertices() const {
+    return vertices;
+}
+
+size_t Model::MorphTargets::getMemoryUsage() const {
+    size_t bytes = vertices.size() * sizeof(uint32_t) +
+                   (base.x.size() + base.normalX.size()) * 3 * sizeof(float);
+    for (const auto &target : targets) {
+        bytes += target.spans.size() * sizeof(MorphSpan) +
+                 (target.x.size() + target.normalX.size()) * 3 * sizeof(int16_t);
+    }
+    return bytes;
+}
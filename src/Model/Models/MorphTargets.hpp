@@ -0,0 +1,98 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glm/vec3.hpp>
+
+namespace Model {
+    /// Run of consecutive affected vertices whose deltas are stored back to back.
+    struct MorphSpan {
+        /// Index of the first vertex in MorphTargets::getVertices.
+        uint32_t first = 0;
+        uint32_t count = 0;
+        /// Index of the first delta in the target's delta arrays.
+        uint32_t offset = 0;
+    };
+
+    /**
+     * Position and normal offsets of one blend shape, stored only for the vertices it changes.
+     * Offsets are quantized to 16 bits per axis against the largest offset of the target.
+     */
+    struct MorphTarget {
+        std::string name = {};
+        /// Converts a quantized offset back to model units.
+        float scale = 0.0f;
+        /// Converts a quantized normal offset back, zero if the target keeps the base normals.
+        float normalScale = 0.0f;
+        std::vector<MorphSpan> spans = {};
+        std::vector<int16_t> x = {};
+        std::vector<int16_t> y = {};
+        std::vector<int16_t> z = {};
+        /// Normal offsets laid out like the position offsets, empty if normalScale is zero.
+        std::vector<int16_t> normalX = {};
+        std::vector<int16_t> normalY = {};
+        std::vector<int16_t> normalZ = {};
+    };
+
+    /// Positions and normals of the affected vertices after blending, SoA, reused between calls.
+    struct MorphBuffer {
+        std::vector<float> x = {};
+        std::vector<float> y = {};
+        std::vector<float> z = {};
+        /// Blended normals, not normalized. Empty if no target changes normals.
+        std::vector<float> normalX = {};
+        std::vector<float> normalY = {};
+        std::vector<float> normalZ = {};
+    };
+
+    /**
+     * Blend shapes of one mesh. Only vertices moved by at least one target are tracked, and
+     * each target stores its offsets as spans over that set, so blending costs time and memory
+     * in proportion to the vertices the targets move rather than to the mesh. Spans are
+     * accumulated contiguously, 4 (SSE) or 8 (AVX2) vertices at a time.
+     */
+    class MorphTargets {
+      public:
+        MorphTargets() = default;
+        /**
+         * Builds the sparse targets of a mesh.
+         * @param basePositions position of every vertex of the mesh.
+         * @param baseNormals normal of every vertex, empty if the mesh has none.
+         * @param targetPositions absolute position of every vertex, one array per target.
+         * @param targetNormals absolute normal of every vertex, one array per target, empty
+         * for targets that keep the base normals.
+         * @param names one per target.
+         * @param threshold offsets no longer than this are dropped.
+         */
+        MorphTargets(const std::vector<glm::vec3> &basePositions,
+                     const std::vector<glm::vec3> &baseNormals,
+                     const std::vector<std::vector<glm::vec3>> &targetPositions,
+                     const std::vector<std::vector<glm::vec3>> &targetNormals,
+                     const std::vector<std::string> &names, float threshold = 1e-5f);
+
+        /**
+         * Blends every target with a non-zero weight onto the base positions and normals.
+         * @param weights one per target.
+         * @param buffer receives the blended position and normal of every affected vertex, in
+         * the order of getVertices.
+         * @return false if every weight was zero, buffer then holds the base positions.
+         */
+        bool apply(const float *weights, MorphBuffer &buffer) const;
+
+        size_t getTargetCount() const;
+        const MorphTarget &getTarget(size_t target) const;
+        /// Mesh indices of the vertices moved by any target, ascending.
+        const std::vector<uint32_t> &getVertices() const;
+        /**
+         * Heap size of the targets and the affected vertices.
+         * @return size in bytes.
+         */
+        size_t getMemoryUsage() const;
+
+      private:
+        std::vector<MorphTarget> targets = {};
+        std::vector<uint32_t> vertices = {};
+        /// Base position of each affected vertex, SoA.
+        MorphBuffer base = {};
+    };
+}
@@ -0,0 +1,405 @@
+#include "MotionDatabase.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include "Model/Models/SimdLanes.hpp"
+
+/// Frames stored together in columns, the width of the widest SIMD block.
+static constexpr size_t BLOCK_WIDTH = Model::Simd::MAX_WIDTH;
+/// Value of padding frames, far enough from any normalized feature to never be nearest.
+static constexpr float PADDING = 1e15f;
+/// Standard deviations below this leave a feature unscaled.
+static constexpr float DEVIATION_EPSILON = 1e-6f;
+
+/**
+ * Squared distances from a query to one block of frames, Simd::WIDTH frames per register.
+ * @param block BLOCK_WIDTH values of each dimension in turn.
+ * @param distances receives BLOCK_WIDTH distances.
+ */
+template <typename Simd>
+static void blockCosts(const float *block, const float *query, size_t count, float *distances) {
+    using Vector = typename Simd::Vector;
+    constexpr size_t REGISTERS = BLOCK_WIDTH / Simd::WIDTH;
+    Vector sums[REGISTERS];
+    for (auto &sum : sums) {
+        sum = Simd::set1(0.0f);
+    }
+    for (size_t i = 0; i < count; ++i, block += BLOCK_WIDTH) {
+        Vector value = Simd::set1(query[i]);
+        for (size_t r = 0; r < REGISTERS; ++r) {
+            Vector difference = Simd::sub(Simd::load(block + r * Simd::WIDTH), value);
+            sums[r] = Simd::add(sums[r], Simd::mul(difference, difference));
+        }
+    }
+    for (size_t r = 0; r < REGISTERS; ++r) {
+        Simd::store(distances + r * Simd::WIDTH, sums[r]);
+    }
+}
+
+/**
+ * Squared distance from a query to a frame, giving up once it reaches the best so far.
+ */
+static float frameCost(const float *query, const float *frame, size_t count, float best) {
+    float cost = 0.0f;
+    for (size_t i = 0; i < count && cost < best; ++i) {
+        float difference = query[i] - frame[i];
+        cost += difference * difference;
+    }
+    return cost;
+}
+
+/**
+ * Squared distance from a query to the nearest point of a box, a lower bound of the cost of
+ * every frame inside it.
+ */
+static float boxCost(const float *query, const float *boxMin, const float *boxMax, size_t count,
+                     float best) {
+    float cost = 0.0f;
+    for (size_t i = 0; i < count && cost < best; ++i) {
+        float outside = std::max(std::max(boxMin[i] - query[i], query[i] - boxMax[i]), 0.0f);
+        cost += outside * outside;
+    }
+    return cost;
+}
+
+/**
+ * Projects a direction onto the ground plane.
+ * @param fallback returned when the direction is vertical.
+ */
+static glm::vec3 groundDirection(const glm::vec3 &direction, const glm::vec3 &up,
+                                 const glm::vec3 &fallback) {
+    glm::vec3 ground = direction - up * glm::dot(direction, up);
+    float length = glm::length(ground);
+    return length > DEVIATION_EPSILON ? ground / length : fallback;
+}
+
+Model::MotionDatabase::MotionDatabase(const Skeleton &skeleton,
+                                      const std::vector<Animation> &animations,
+                                      const MotionFeatureSettings &newSettings)
+    : settings(newSettings) {
+    auto findJoint = [&skeleton](const std::string &name) {
+        int joint = skeleton.findJoint(name);
+        if (joint < 0) {
+            throw std::runtime_error("Motion feature joint not found: " + name);
+        }
+        return static_cast<size_t>(joint);
+    };
+    std::vector<size_t> joints = {};
+    for (const auto &name : settings.joints) {
+        joints.push_back(findJoint(name));
+    }
+    size_t root = settings.rootJoint.empty() ? 0 : findJoint(settings.rootJoint);
+    size_t jointCount      = joints.size();
+    size_t trajectoryCount = settings.trajectoryTimes.size();
+    featureCount = jointCount * 6 + trajectoryCount * 4;
+    if (featureCount == 0 || skeleton.size() == 0 || settings.rate <= 0.0f) {
+        throw std::runtime_error("Motion database has no features to match");
+    }
+    glm::vec3 up = glm::normalize(settings.up);
+    glm::vec3 defaultFacing = groundDirection(settings.forward, up,
+                                              groundDirection(glm::vec3(1.0f, 0.0f, 0.0f), up,
+                                                              glm::vec3(0.0f, 0.0f, 1.0f)));
+
+    Pose pose = {};
+    std::vector<TrackCursor> cursors = {};
+    std::vector<glm::mat4> modelTransforms(skeleton.size());
+    std::vector<glm::vec3> positions = {};
+    std::vector<glm::vec3> origins = {};
+    std::vector<glm::vec3> facings = {};
+    for (size_t clip = 0; clip < animations.size(); ++clip) {
+        const auto &animation = animations[clip];
+        double length = animation.getLength();
+        auto count = std::max<size_t>(
+            1, static_cast<size_t>(std::ceil(length * settings.rate - 1e-4)));
+        clips.push_back({frameCount, count});
+
+        // One frame more than is stored, at the full length, for velocities and looping.
+        positions.resize((count + 1) * jointCount);
+        origins.resize(count + 1);
+        facings.resize(count + 1);
+        pose = animation.getRestPose(skeleton);
+        cursors.assign(animation.getTrackCount(), {});
+        for (size_t i = 0; i <= count; ++i) {
+            if (!animation.sample(std::min(static_cast<double>(i) / settings.rate, length),
+                                  cursors, pose)) {
+                throw std::runtime_error("Clip has pages that are not resident");
+            }
+            skeleton.localToModel(pose, modelTransforms);
+            for (size_t k = 0; k < jointCount; ++k) {
+                positions[i * jointCount + k] = glm::vec3(modelTransforms[joints[k]][3]);
+            }
+            glm::vec3 origin = glm::vec3(modelTransforms[root][3]);
+            origins[i] = origin - up * glm::dot(origin, up);
+            facings[i] = groundDirection(glm::mat3(modelTransforms[root]) * settings.forward, up,
+                                         i > 0 ? facings[i - 1] : defaultFacing);
+        }
+
+        // A looping clip's trajectory runs past the end and continues from the start, carried
+        // along by the distance the root covers in one cycle. Other clips hold their last frame.
+        bool looping = clip < settings.loopingClips.size() && settings.loopingClips[clip] != 0;
+        glm::vec3 cycleOffset = origins[count] - origins[0];
+        features.resize((frameCount + count) * featureCount);
+        for (size_t i = 0; i < count; ++i) {
+            glm::vec3 facing = facings[i];
+            glm::vec3 side   = glm::cross(up, facing);
+            float *out = &features[(frameCount + i) * featureCount];
+            for (size_t k = 0; k < jointCount; ++k) {
+                glm::vec3 position = positions[i * jointCount + k] - origins[i];
+                *out++ = glm::dot(position, side);
+                *out++ = glm::dot(position, up);
+                *out++ = glm::dot(position, facing);
+            }
+            for (size_t k = 0; k < jointCount; ++k) {
+                glm::vec3 velocity =
+                    (positions[(i + 1) * jointCount + k] - positions[i * jointCount + k]) *
+                    settings.rate;
+                *out++ = glm::dot(velocity, side);
+                *out++ = glm::dot(velocity, up);
+                *out++ = glm::dot(velocity, facing);
+            }
+            float *directions = out + trajectoryCount * 2;
+            for (float time : settings.trajectoryTimes) {
+                size_t ahead  = i + static_cast<size_t>(std::lround(time * settings.rate));
+                size_t future = looping ? ahead % count : std::min(ahead, count);
+                float cycles  = looping ? static_cast<float>(ahead / count) : 0.0f;
+                glm::vec3 position = origins[future] + cycleOffset * cycles - origins[i];
+                *out++        = glm::dot(position, side);
+                *out++        = glm::dot(position, facing);
+                *directions++ = glm::dot(facings[future], side);
+                *directions++ = glm::dot(facings[future], facing);
+            }
+        }
+        frameCount += count;
+    }
+    if (frameCount == 0) {
+        throw std::runtime_error("Motion database has no frames");
+    }
+
+    means.assign(featureCount, 0.0f);
+    scales.assign(featureCount, 1.0f);
+    for (size_t k = 0; k < jointCount; ++k) {
+        normalizeFeatures(k * 3, 3, settings.positionWeight);
+        normalizeFeatures((jointCount + k) * 3, 3, settings.velocityWeight);
+    }
+    size_t trajectory = getTrajectoryOffset();
+    normalizeFeatures(trajectory, trajectoryCount * 2, settings.trajectoryPositionWeight);
+    normalizeFeatures(trajectory + trajectoryCount * 2, trajectoryCount * 2,
+                      settings.trajectoryDirectionWeight);
+
+    blockCount = (frameCount + BLOCK_WIDTH - 1) / BLOCK_WIDTH;
+    columns.assign(blockCount * featureCount * BLOCK_WIDTH, PADDING);
+    for (size_t frame = 0; frame < frameCount; ++frame) {
+        float *block = &columns[frame / BLOCK_WIDTH * featureCount * BLOCK_WIDTH];
+        for (size_t i = 0; i < featureCount; ++i) {
+            block[i * BLOCK_WIDTH + frame % BLOCK_WIDTH] = features[frame * featureCount + i];
+        }
+    }
+    buildBoxes(SMALL_BOX_SIZE, smallBoxMin, smallBoxMax);
+    buildBoxes(LARGE_BOX_SIZE, largeBoxMin, largeBoxMax);
+}
+
+void Model::MotionDatabase::normalizeFeatures(size_t offset, size_t size, float weight) {
+    if (size == 0) {
+        return;
+    }
+    double variance = 0.0;
+    for (size_t i = offset; i < offset + size; ++i) {
+        double mean = 0.0;
+        for (size_t frame = 0; frame < frameCount; ++frame) {
+            mean += features[frame * featureCount + i];
+        }
+        mean /= static_cast<double>(frameCount);
+        for (size_t frame = 0; frame < frameCount; ++frame) {
+            double difference = features[frame * featureCount + i] - mean;
+            variance += difference * difference;
+        }
+        means[i] = static_cast<float>(mean);
+    }
+    // One deviation for the whole feature keeps its axes in proportion.
+    auto deviation = static_cast<float>(
+        std::sqrt(variance / static_cast<double>(frameCount * size)));
+    float scale = deviation > DEVIATION_EPSILON ? weight / deviation : weight;
+    for (size_t i = offset; i < offset + size; ++i) {
+        scales[i] = scale;
+        for (size_t frame = 0; frame < frameCount; ++frame) {
+            float &value = features[frame * featureCount + i];
+            value = (value - means[i]) * scale;
+        }
+    }
+}
+
+void Model::MotionDatabase::buildBoxes(size_t boxSize, std::vector<float> &boxMin,
+                                       std::vector<float> &boxMax) {
+    size_t boxCount = (frameCount + boxSize - 1) / boxSize;
+    boxMin.assign(boxCount * featureCount, std::numeric_limits<float>::max());
+    boxMax.assign(boxCount * featureCount, std::numeric_limits<float>::lowest());
+    for (size_t frame = 0; frame < frameCount; ++frame) {
+        size_t box = frame / boxSize;
+        for (size_t i = 0; i < featureCount; ++i) {
+            float value = features[frame * featureCount + i];
+            boxMin[box * featureCount + i] = std::min(boxMin[box * featureCount + i], value);
+            boxMax[box * featureCount + i] = std::max(boxMax[box * featureCount + i], value);
+        }
+    }
+}
+
+size_t Model::MotionDatabase::getFrameCount() const {
+    return frameCount;
+}
+
+size_t Model::MotionDatabase::getFeatureCount() const {
+    return featureCount;
+}
+
+size_t Model::MotionDatabase::getTrajectoryOffset() const {
+    return settings.joints.size() * 6;
+}
+
+const Model::MotionFeatureSettings &Model::MotionDatabase::getSettings() const {
+    return settings;
+}
+
+const float *Model::MotionDatabase::getFeatures(size_t frame) const {
+    return &features.at(frame * featureCount);
+}
+
+size_t Model::MotionDatabase::getFrame(size_t clip, double time) const {
+    const auto &range = clips.at(clip);
+    auto frame = static_cast<long long>(std::floor(time * settings.rate));
+    auto count = static_cast<long long>(range.frameCount);
+    frame %= count;
+    frame += frame < 0 ? count : 0;
+    return range.firstFrame + static_cast<size_t>(frame);
+}
+
+void Model::MotionDatabase::normalize(float *values) const {
+    for (size_t i = 0; i < featureCount; ++i) {
+        values[i] = (values[i] - means[i]) * scales[i];
+    }
+}
+
+void Model::MotionDatabase::setTrajectory(const glm::vec2 *positions,
+                                          const glm::vec2 *directions, float *query) const {
+    size_t count = settings.trajectoryTimes.size();
+    size_t first = getTrajectoryOffset();
+    for (size_t t = 0; t < count; ++t) {
+        for (size_t axis = 0; axis < 2; ++axis) {
+            size_t position  = first + t * 2 + axis;
+            size_t direction = position + count * 2;
+            query[position]  = (positions[t][static_cast<int>(axis)] - means[position]) *
+                               scales[position];
+            query[direction] = (directions[t][static_cast<int>(axis)] - means[direction]) *
+                               scales[direction];
+        }
+    }
+}
+
+Model::MotionMatch Model::MotionDatabase::search(const float *query, size_t currentFrame) const {
+    auto start = std::chrono::steady_clock::now();
+    float best       = std::numeric_limits<float>::max();
+    size_t bestFrame = 0;
+    if (currentFrame < frameCount) {
+        best      = frameCost(query, &features[currentFrame * featureCount], featureCount, best);
+        bestFrame = currentFrame;
+    }
+
+    constexpr size_t SMALL_PER_LARGE = LARGE_BOX_SIZE / SMALL_BOX_SIZE;
+    size_t smallCount = smallBoxMin.size() / featureCount;
+    size_t largeCount = largeBoxMin.size() / featureCount;
+    for (size_t large = 0; large < largeCount; ++large) {
+        size_t offset = large * featureCount;
+        if (boxCost(query, &largeBoxMin[offset], &largeBoxMax[offset], featureCount, best) >=
+            best) {
+            continue;
+        }
+        size_t smallEnd = std::min((large + 1) * SMALL_PER_LARGE, smallCount);
+        for (size_t small = large * SMALL_PER_LARGE; small < smallEnd; ++small) {
+            offset = small * featureCount;
+            if (boxCost(query, &smallBoxMin[offset], &smallBoxMax[offset], featureCount, best) >=
+                best) {
+                continue;
+            }
+            size_t frameEnd = std::min((small + 1) * SMALL_BOX_SIZE, frameCount);
+            for (size_t frame = small * SMALL_BOX_SIZE; frame < frameEnd; ++frame) {
+                float cost = frameCost(query, &features[frame * featureCount], featureCount, best);
+                if (cost < best) {
+                    best      = cost;
+                    bestFrame = frame;
+                }
+            }
+        }
+    }
+
+    record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now() - start)
+                                     .count()));
+    return makeMatch(bestFrame, best);
+}
+
+Model::MotionMatch Model::MotionDatabase::searchBruteForce(const float *query) const {
+    auto start = std::chrono::steady_clock::now();
+    float best       = std::numeric_limits<float>::max();
+    size_t bestFrame = 0;
+    float distances[BLOCK_WIDTH];
+    for (size_t block = 0; block < blockCount; ++block) {
+        blockCosts<Simd::Widest>(&columns[block * featureCount * BLOCK_WIDTH], query,
+                                 featureCount, distances);
+        for (size_t lane = 0; lane < BLOCK_WIDTH; ++lane) {
+            if (distances[lane] < best) {
+                best      = distances[lane];
+                bestFrame = block * BLOCK_WIDTH + lane;
+            }
+        }
+    }
+
+    record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now() - start)
+                                     .count()));
+    return makeMatch(bestFrame, best);
+}
+
+Model::MotionMatch Model::MotionDatabase::makeMatch(size_t frame, float cost) const {
+    auto clip = std::upper_bound(clips.begin(), clips.end(), frame,
+                                 [](size_t value, const ClipRange &range) {
+                                     return value < range.firstFrame;
+                                 }) -
+                clips.begin() - 1;
+    MotionMatch match = {};
+    match.frame = frame;
+    match.clip  = static_cast<size_t>(clip);
+    match.time  = static_cast<double>(frame - clips[match.clip].firstFrame) / settings.rate;
+    match.cost  = cost;
+    return match;
+}
+
+void Model::MotionDatabase::record(uint64_t nanoseconds) const {
+    queryCount.fetch_add(1, std::memory_order_relaxed);
+    queryNanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed);
+}
+
+uint64_t Model::MotionDatabase::getQueryCount() const {
+    return queryCount.load(std::memory_order_relaxed);
+}
+
+double Model::MotionDatabase::getQueriesPerSecond() const {
+    uint64_t nanoseconds = queryNanoseconds.load(std::memory_order_relaxed);
+    return nanoseconds == 0 ? 0.0
+                            : static_cast<double>(getQueryCount()) * 1e9 /
+                                  static_cast<double>(nanoseconds);
+}
+
+void Model::MotionDatabase::resetStatistics() {
+    queryCount.store(0, std::memory_order_relaxed);
+    queryNanoseconds.store(0, std::memory_order_relaxed);
+}
+
+size_t Model::MotionDatabase::getMemoryUsage() const {
+    return sizeof(*this) + clips.capacity() * sizeof(ClipRange) +
+           (features.capacity() + columns.capacity() + means.capacity() + scales.capacity() +
+            smallBoxMin.capacity() + smallBoxMax.capacity() + largeBoxMin.capacity() +
+            largeBoxMax.capacity()) *
+               sizeof(float);
+}
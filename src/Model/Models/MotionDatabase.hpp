@@ -0,0 +1,169 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include "Model/Models/Animation.hpp"
+#include "Model/Models/Skeleton.hpp"
+
+namespace Model {
+    /**
+     * What a MotionDatabase matches on. Every feature is measured in the character's ground
+     * frame: the root joint projected onto the ground plane, facing along its forward axis.
+     */
+    struct MotionFeatureSettings {
+        /// Joints whose position and velocity are matched, usually the feet and the hips.
+        std::vector<std::string> joints = {};
+        /// Joint whose ground projection is the character's trajectory, empty for the first joint.
+        std::string rootJoint = {};
+        /// Up axis of the model, the ground plane is perpendicular to it.
+        glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f);
+        /// Axis of the root joint the character faces along.
+        glm::vec3 forward = glm::vec3(0.0f, 0.0f, 1.0f);
+        /// Seconds ahead the future trajectory is sampled at.
+        std::vector<float> trajectoryTimes = {0.33f, 0.66f, 1.0f};
+        /// One entry per clip, non-zero for clips that loop. The future trajectory of any other
+        /// clip stops at its last frame rather than continuing from its start.
+        std::vector<uint8_t> loopingClips = {};
+        /// Frames per second each clip is sampled at.
+        float rate = 30.0f;
+        float positionWeight = 1.0f;
+        float velocityWeight = 1.0f;
+        float trajectoryPositionWeight = 1.0f;
+        float trajectoryDirectionWeight = 1.0f;
+    };
+
+    /// Result of a MotionDatabase search.
+    struct MotionMatch {
+        size_t frame = 0;
+        /// Index of the clip in the animation list the database was built from.
+        size_t clip = 0;
+        /// Time of the frame within the clip.
+        double time = 0.0;
+        /// Squared distance between the query and the frame's features.
+        float cost = 0.0f;
+    };
+
+    /**
+     * Feature vectors of every frame of every clip of a model, for picking the frame that best
+     * continues the current pose towards a desired trajectory. A vector holds, in order, the
+     * position of each feature joint, the velocity of each feature joint (3 values each: side,
+     * up, forward), the ground position at each trajectory time and the facing direction at
+     * each trajectory time (2 values each: side, forward). Each
+     * feature is normalized by its mean and standard deviation and scaled by its weight, so a
+     * plain squared distance compares them fairly.
+     *
+     * Features are stored twice: frame by frame for the bounding box search, and for the brute
+     * force search in blocks of 8 frames holding each dimension in turn, so one SIMD register
+     * measures a dimension of a whole block.
+     */
+    class MotionDatabase {
+      public:
+        /// Frames bounded by each small and large box of the search hierarchy.
+        static constexpr size_t SMALL_BOX_SIZE = 16;
+        static constexpr size_t LARGE_BOX_SIZE = 64;
+        /// Marks an unknown frame.
+        static constexpr size_t NO_FRAME = ~static_cast<size_t>(0);
+
+        MotionDatabase() = default;
+        /**
+         * Samples every clip and builds the features, no graphics context is required.
+         * @param skeleton the clips animate.
+         * @param animations clips to sample, sampled through their best available representation.
+         * @param settings features to extract.
+         */
+        MotionDatabase(const Skeleton& skeleton, const std::vector<Animation>& animations,
+                       const MotionFeatureSettings& settings);
+
+        size_t getFrameCount() const;
+        /// Values in each feature vector.
+        size_t getFeatureCount() const;
+        /// Index of the first trajectory value in a feature vector.
+        size_t getTrajectoryOffset() const;
+        const MotionFeatureSettings& getSettings() const;
+        /**
+         * Normalized features of one frame, the usual starting point of a query.
+         * @param frame index of the frame.
+         * @return getFeatureCount() values.
+         */
+        const float* getFeatures(size_t frame) const;
+        /**
+         * Finds the frame of a clip at a time.
+         * @param clip index of the clip.
+         * @param time in seconds, wrapped to the clip length.
+         * @return the frame index.
+         */
+        size_t getFrame(size_t clip, double time) const;
+        /**
+         * Normalizes a feature vector measured in model units.
+         * @param features getFeatureCount() values, normalized in place.
+         */
+        void normalize(float* features) const;
+        /**
+         * Writes a desired trajectory into a query.
+         * @param positions one ground position per trajectory time, in the character's frame.
+         * @param directions one facing direction per trajectory time, in the character's frame.
+         * @param query feature vector whose trajectory values are replaced by normalized ones.
+         */
+        void setTrajectory(const glm::vec2* positions, const glm::vec2* directions,
+                           float* query) const;
+
+        /**
+         * Finds the nearest frame with the box hierarchy, skipping boxes that cannot hold a
+         * better frame than the best found so far.
+         * @param query normalized feature vector.
+         * @param currentFrame frame playing now, tried first to tighten the bound, or NO_FRAME.
+         * @return the nearest frame.
+         */
+        MotionMatch search(const float* query, size_t currentFrame = NO_FRAME) const;
+        /**
+         * Finds the nearest frame by measuring every frame, 4 (SSE) or 8 (AVX2) at a time. Its
+         * cost does not depend on the query but is several times that of search for queries
+         * built from a playing pose, see test/MotionMatchingBenchmark.cpp.
+         * @param query normalized feature vector.
+         * @return the nearest frame.
+         */
+        MotionMatch searchBruteForce(const float* query) const;
+
+        /// Searches run since the statistics were last reset, safe to read while searching.
+        uint64_t getQueryCount() const;
+        double getQueriesPerSecond() const;
+        void resetStatistics();
+        size_t getMemoryUsage() const;
+
+      private:
+        /// Location of one clip's frames.
+        struct ClipRange {
+            size_t firstFrame = 0;
+            size_t frameCount = 0;
+        };
+
+        MotionFeatureSettings settings = {};
+        size_t featureCount = 0;
+        size_t frameCount = 0;
+        /// Blocks of 8 frames in columns, the last one padded.
+        size_t blockCount = 0;
+        std::vector<ClipRange> clips = {};
+        /// Normalized features, frame by frame.
+        std::vector<float> features = {};
+        /// Normalized features in blocks of 8 frames, each block dimension by dimension.
+        std::vector<float> columns = {};
+        /// Per dimension mean and scale, normalized = (raw - mean) * scale.
+        std::vector<float> means = {};
+        std::vector<float> scales = {};
+        /// Per dimension bounds of each box, box by box.
+        std::vector<float> smallBoxMin = {};
+        std::vector<float> smallBoxMax = {};
+        std::vector<float> largeBoxMin = {};
+        std::vector<float> largeBoxMax = {};
+
+        mutable std::atomic<uint64_t> queryCount{0};
+        mutable std::atomic<uint64_t> queryNanoseconds{0};
+
+        void normalizeFeatures(size_t offset, size_t size, float weight);
+        void buildBoxes(size_t boxSize, std::vector<float>& boxMin, std::vector<float>& boxMax);
+        MotionMatch makeMatch(size_t frame, float cost) const;
+        void record(uint64_t nanoseconds) const;
+    };
+}
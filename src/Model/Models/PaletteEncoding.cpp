@@ -0,0 +1,165 @@
+#include "PaletteEncoding.hpp"
+
+#include <cstring>
+#include <glm/gtc/packing.hpp>
+#include <glm/gtx/quaternion.hpp>
+#include "Model/Models/SimdLanes.hpp"
+
+namespace {
+    /**
+     * Stores texels of 4 floats as 32 bit or 16 bit floats.
+     * @param values 4 per texel.
+     * @param texels to store.
+     * @param half store 16 bit floats, two per word.
+     * @param out receives 4 words per texel, or 2 if half.
+     */
+    void storeTexels(const float *values, size_t texels, bool half, uint32_t *out) {
+        if (!half) {
+            std::memcpy(out, values, texels * 4 * sizeof(float));
+            return;
+        }
+        for (size_t texel = 0; texel < texels; ++texel, values += 4, out += 2) {
+#if ANIMTEST_F16C_KERNELS
+            Model::Simd::Sse::storeHalf(out, Model::Simd::Sse::load(values));
+#else
+            out[0] = glm::packHalf2x16(glm::vec2(values[0], values[1]));
+            out[1] = glm::packHalf2x16(glm::vec2(values[2], values[3]));
+#endif
+        }
+    }
+
+    /**
+     * Writes the top three rows of an affine matrix.
+     * @param matrix to convert.
+     * @param rows receives 12 floats.
+     */
+    void toAffineRows(const glm::mat4 &matrix, float *rows) {
+#if ANIMTEST_SSE_KERNELS
+        using Model::Simd::Sse;
+        Sse::Vector c0 = Sse::load(&matrix[0][0]);
+        Sse::Vector c1 = Sse::load(&matrix[1][0]);
+        Sse::Vector c2 = Sse::load(&matrix[2][0]);
+        Sse::Vector c3 = Sse::load(&matrix[3][0]);
+        Sse::transpose(c0, c1, c2, c3);
+        Sse::store(rows, c0);
+        Sse::store(rows + 4, c1);
+        Sse::store(rows + 8, c2);
+#else
+        for (int row = 0; row < 3; ++row) {
+            for (int column = 0; column < 4; ++column) {
+                rows[row * 4 + column] = matrix[column][row];
+            }
+        }
+#endif
+    }
+
+    /**
+     * Writes the unit dual quaternion of a rigid transform, any scale is normalised away.
+     * @param matrix to convert.
+     * @param values receives the real part then the dual part, each as x, y, z, w.
+     */
+    void toDualQuaternion(const glm::mat4 &matrix, float *values) {
+        glm::mat3 basis(glm::normalize(glm::vec3(matrix[0])), glm::normalize(glm::vec3(matrix[1])),
+                        glm::normalize(glm::vec3(matrix[2])));
+        glm::quat real = glm::normalize(glm::quat_cast(basis));
+        // One hemisphere for every bone keeps neighbouring bones from blending the long way.
+        if (real.w < 0.0f) {
+            real = -real;
+        }
+        glm::vec3 translation = matrix[3];
+        glm::quat dual = glm::quat(0.0f, translation.x, translation.y, translation.z) * real * 0.5f;
+        const float packed[8] = {real.x, real.y, real.z, real.w, dual.x, dual.y, dual.z, dual.w};
+        std::memcpy(values, packed, sizeof(packed));
+    }
+}
+
+size_t Model::getRowsPerBone(PaletteEncoding encoding) {
+    switch (encoding) {
+        case PaletteEncoding::MATRIX:
+            return 4;
+        case PaletteEncoding::AFFINE:
+        case PaletteEncoding::AFFINE_HALF:
+            return 3;
+        case PaletteEncoding::DUAL_QUATERNION:
+        case PaletteEncoding::DUAL_QUATERNION_HALF:
+            return 2;
+    }
+    return 4;
+}
+
+bool Model::isHalfPrecision(PaletteEncoding encoding) {
+    return encoding == PaletteEncoding::AFFINE_HALF ||
+           encoding == PaletteEncoding::DUAL_QUATERNION_HALF;
+}
+
+size_t Model::getWordsPerBone(PaletteEncoding encoding) {
+    return getRowsPerBone(encoding) * (isHalfPrecision(encoding) ? 2 : 4);
+}
+
+void Model::encodePalette(const glm::mat4 *palette, size_t boneCount, PaletteEncoding encoding,
+                          std::vector<uint32_t> &out) {
+    size_t words = getWordsPerBone(encoding);
+    size_t rows  = getRowsPerBone(encoding);
+    bool half    = isHalfPrecision(encoding);
+    size_t start = out.size();
+    out.resize(start + boneCount * words);
+    uint32_t *bone = out.data() + start;
+    float values[16] = {};
+    for (size_t i = 0; i < boneCount; ++i, bone += words) {
+        switch (encoding) {
+            case PaletteEncoding::MATRIX:
+                std::memcpy(values, &palette[i][0][0], sizeof(values));
+                break;
+            case PaletteEncoding::AFFINE:
+            case PaletteEncoding::AFFINE_HALF:
+                toAffineRows(palette[i], values);
+                break;
+            case PaletteEncoding::DUAL_QUATERNION:
+            case PaletteEncoding::DUAL_QUATERNION_HALF:
+                toDualQuaternion(palette[i], values);
+                break;
+        }
+        storeTexels(values, rows, half, bone);
+    }
+}
+
+glm::mat4 Model::decodeBone(const uint32_t *words, PaletteEncoding encoding) {
+    float values[16] = {};
+    size_t rows = getRowsPerBone(encoding);
+    if (isHalfPrecision(encoding)) {
+        for (size_t i = 0; i < rows * 2; ++i) {
+            glm::vec2 pair = glm::unpackHalf2x16(words[i]);
+            values[i * 2]     = pair.x;
+            values[i * 2 + 1] = pair.y;
+        }
+    } else {
+        std::memcpy(values, words, rows * 4 * sizeof(float));
+    }
+    glm::mat4 bone(1.0f);
+    switch (encoding) {
+        case PaletteEncoding::MATRIX:
+            std::memcpy(&bone[0][0], values, sizeof(values));
+            break;
+        case PaletteEncoding::AFFINE:
+        case PaletteEncoding::AFFINE_HALF:
+            for (int row = 0; row < 3; ++row) {
+                for (int column = 0; column < 4; ++column) {
+                    bone[column][row] = values[row * 4 + column];
+                }
+            }
+            break;
+        case PaletteEncoding::DUAL_QUATERNION:
+        case PaletteEncoding::DUAL_QUATERNION_HALF: {
+            glm::quat real(values[3], values[0], values[1], values[2]);
+            glm::quat dual(values[7], values[4], values[5], values[6]);
+            float length = glm::length(real);
+            real /= length;
+            dual /= length;
+            glm::quat translation = dual * glm::conjugate(real) * 2.0f;
+            bone = glm::toMat4(real);
+            bone[3] = glm::vec4(translation.x, translation.y, translation.z, 1.0f);
+            break;
+        }
+    }
+    return bone;
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace Model {
+    /**
+     * How a skinning palette is stored for upload, each bone taking a few RGBA texels of the
+     * palette buffer texture. Values are passed to the vertex shader as paletteEncoding.
+     */
+    enum class PaletteEncoding : uint8_t {
+        /// The full matrix, 4 texels or 64 bytes per bone.
+        MATRIX,
+        /// Top three rows of the affine matrix, 3 texels or 48 bytes per bone.
+        AFFINE,
+        /// Rotation and translation as a unit dual quaternion, 2 texels or 32 bytes per bone.
+        /// Blending dual quaternions keeps volume around twisting joints, but scale in the
+        /// palette is lost, so rigs whose bone offsets or scene root scale need AFFINE.
+        DUAL_QUATERNION,
+        /// AFFINE in half precision, 24 bytes per bone. Translations keep about 3 significant
+        /// digits, enough for characters a few units across.
+        AFFINE_HALF,
+        /// DUAL_QUATERNION in half precision, 16 bytes per bone.
+        DUAL_QUATERNION_HALF
+    };
+
+    /**
+     * RGBA texels each bone takes.
+     * @param encoding of the palette.
+     * @return 4, 3 or 2.
+     */
+    size_t getRowsPerBone(PaletteEncoding encoding);
+    /**
+     * Whether the texels hold 16 bit floats, uploaded as RGBA16F instead of RGBA32F.
+     * @param encoding of the palette.
+     * @return true for the half precision encodings.
+     */
+    bool isHalfPrecision(PaletteEncoding encoding);
+    /**
+     * 32 bit words each bone takes, a half precision texel is two words.
+     * @param encoding of the palette.
+     * @return words per bone.
+     */
+    size_t getWordsPerBone(PaletteEncoding encoding);
+
+    /**
+     * Converts a palette into an encoding and appends it to a stream. Matrices and affine rows
+     * are converted 4 (SSE) at a time and half precision with F16C where available.
+     * @param palette one transform per bone.
+     * @param boneCount bones in the palette.
+     * @param encoding to convert to.
+     * @param out receives getWordsPerBone words per bone.
+     */
+    void encodePalette(const glm::mat4 *palette, size_t boneCount, PaletteEncoding encoding,
+                       std::vector<uint32_t> &out);
+    /**
+     * Rebuilds one bone's transform the way the vertex shader reads it, for checks and CPU
+     * skinning.
+     * @param words of the bone, getWordsPerBone of them.
+     * @param encoding of the palette.
+     * @return the bone transform.
+     */
+    glm::mat4 decodeBone(const uint32_t *words, PaletteEncoding encoding);
+}
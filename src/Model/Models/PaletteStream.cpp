@@ -0,0 +1,52 @@
+#include "PaletteStream.hpp"
+#include <stdexcept>
+
+void Model::PaletteStream::clear(PaletteEncoding newEncoding) {
+    words.clear();
+    bases.clear();
+    instanceCount = 0;
+    encoding = newEncoding;
+}
+
+size_t Model::PaletteStream::add(const std::vector<glm::mat4> &palette) {
+    ++instanceCount;
+    auto found = bases.find(palette.data());
+    if (found != bases.end()) {
+        return found->second;
+    }
+    size_t base = getBoneCount();
+    encodePalette(palette.data(), palette.size(), encoding, words);
+    bases.emplace(palette.data(), base);
+    return base;
+}
+
+size_t Model::PaletteStream::addEncoded(const std::vector<uint32_t> &palette) {
+    if (palette.size() % getWordsPerBone(encoding) != 0) {
+        throw std::runtime_error("Encoded palette does not match the palette stream");
+    }
+    ++instanceCount;
+    auto found = bases.find(palette.data());
+    if (found != bases.end()) {
+        return found->second;
+    }
+    size_t base = getBoneCount();
+    words.insert(words.end(), palette.begin(), palette.end());
+    bases.emplace(palette.data(), base);
+    return base;
+}
+
+const std::vector<uint32_t> &Model::PaletteStream::getWords() const {
+    return words;
+}
+
+Model::PaletteEncoding Model::PaletteStream::getEncoding() const {
+    return encoding;
+}
+
+size_t Model::PaletteStream::getBoneCount() const {
+    return words.size() / getWordsPerBone(encoding);
+}
+
+size_t Model::PaletteStream::getInstanceCount() const {
+    return instanceCount;
+}
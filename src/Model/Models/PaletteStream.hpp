@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+#include "Model/Models/PaletteEncoding.hpp"
+
+namespace Model {
+    /**
+     * Skinning palettes of every instance drawn this frame, packed into one stream that is
+     * uploaded to a buffer texture once per frame. Every palette in the stream shares one
+     * PaletteEncoding, each bone taking getRowsPerBone texels, so an instance whose palette
+     * starts at base reads bone b from texels [(base + b) * rows, +rows). Only the bones of each
+     * skeleton are stored, so the stream has no per instance joint limit, and instances sharing
+     * a palette, such as those fed by a PoseCache, share its texels.
+     */
+    class PaletteStream {
+      public:
+        /**
+         * Empties the stream for a new frame, keeping its memory.
+         * @param newEncoding encoding of every palette added this frame.
+         */
+        void clear(PaletteEncoding newEncoding = PaletteEncoding::MATRIX);
+        /**
+         * Encodes and appends an instance's palette, or finds it if the same palette was added
+         * this frame.
+         * @param palette one transform per bone, must stay alive until the stream is cleared.
+         * @return index of the palette's first bone in the stream, the shader's paletteBase.
+         */
+        size_t add(const std::vector<glm::mat4> &palette);
+        /**
+         * Appends a palette the animator already converted to the stream's encoding, see
+         * Animator::getEncodedPalette.
+         * @param palette getWordsPerBone words per bone, must stay alive until the stream is
+         * cleared.
+         * @return index of the palette's first bone in the stream, the shader's paletteBase.
+         */
+        size_t addEncoded(const std::vector<uint32_t> &palette);
+        /**
+         * The packed stream.
+         * @return getWordsPerBone words per bone.
+         */
+        const std::vector<uint32_t> &getWords() const;
+        PaletteEncoding getEncoding() const;
+        /// Bones in the stream, counting shared palettes once.
+        size_t getBoneCount() const;
+        /// Palettes added this frame, counting shared palettes every time.
+        size_t getInstanceCount() const;
+
+      private:
+        std::vector<uint32_t> words = {};
+        PaletteEncoding encoding = PaletteEncoding::MATRIX;
+        /// First bone of each palette added this frame, keyed by the palette's storage.
+        std::unordered_map<const void *, size_t> bases = {};
+        size_t instanceCount = 0;
+    };
+}
@@ -0,0 +1,56 @@
+#include "Pose.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include "Model/Models/PoseKernels.hpp"
+
+Model::Pose::Pose(size_t jointCount) {
+    resize(jointCount);
+}
+
+void Model::Pose::resize(size_t jointCount) {
+    translations.resize(jointCount, glm::vec3(0.0f));
+    rotations.resize(jointCount, glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+}
+
+size_t Model::Pose::size() const {
+    return translations.size();
+}
+
+void Model::Pose::setJoint(size_t index, const Model::JointTransform &transform) {
+    translations[index] = transform.getPosition();
+    rotations[index]    = transform.getRotation();
+}
+
+glm::mat4 Model::Pose::getLocalTransform(size_t index) const {
+    glm::mat4 out(1.0f);
+    out = glm::translate(out, translations[index]);
+    out = out * glm::toMat4(rotations[index]);
+    return out;
+}
+
+void Model::Pose::interpolate(const Model::Pose &first, const Model::Pose &second,
+                              float progression, Model::Pose &out) {
+    out.resize(first.size());
+    Kernels::interpolate(first.translations.data(), first.rotations.data(),
+                         second.translations.data(), second.rotations.data(), progression,
+                         first.size(), out.translations.data(), out.rotations.data());
+}
+
+void Model::Pose::blend(const Model::Pose &layer, float weight, const float *jointWeights,
+                        Model::Pose &inOut) {
+    if (jointWeights == nullptr) {
+        Kernels::interpolate(inOut.translations.data(), inOut.rotations.data(),
+                             layer.translations.data(), layer.rotations.data(), weight,
+                             inOut.size(), inOut.translations.data(), inOut.rotations.data());
+        return;
+    }
+    for (size_t i = 0; i < inOut.size(); ++i) {
+        float jointWeight = weight * jointWeights[i];
+        if (jointWeight > 0.0f) {
+            Kernels::Scalar::interpolate(&inOut.translations[i], &inOut.rotations[i],
+                                         &layer.translations[i], &layer.rotations[i],
+                                         jointWeight, 1, &inOut.translations[i],
+                                         &inOut.rotations[i]);
+        }
+    }
+}
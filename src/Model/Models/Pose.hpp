@@ -0,0 +1,54 @@
+#pragma once
+#include <vector>
+#include <glm/vec3.hpp>
+#include <glm/gtx/quaternion.hpp>
+#include "Model/Models/JointTransform.hpp"
+
+namespace Model {
+    /**
+     * A local-space pose stored as structure of arrays, indexed by joint index.
+     * Sampling writes only the joints a clip has channels for, the others keep what the pose
+     * held before, which is the clip's rest pose for poses started from Animation::getRestPose.
+     */
+    class Pose {
+      public:
+        /// Local translation of each joint.
+        std::vector<glm::vec3> translations = {};
+        /// Local rotation of each joint.
+        std::vector<glm::quat> rotations = {};
+
+        Pose() = default;
+        /**
+         * Constructs an identity pose.
+         * @param jointCount number of joints in the skeleton.
+         */
+        explicit Pose(size_t jointCount);
+
+        /**
+         * Resizes the pose, new joints are set to identity.
+         * @param jointCount number of joints in the skeleton.
+         */
+        void resize(size_t jointCount);
+        size_t size() const;
+        void setJoint(size_t index, const JointTransform& transform);
+        glm::mat4 getLocalTransform(size_t index) const;
+
+        /**
+         * Interpolates two poses of the same size into an existing pose without reallocating.
+         * Rotations are nlerped along the shortest path, see Kernels::interpolate.
+         * @param first pose at progression 0.
+         * @param second pose at progression 1.
+         * @param progression blend factor between the two poses.
+         * @param out pose that receives the result, resized if required.
+         */
+        static void interpolate(const Pose& first, const Pose& second, float progression, Pose& out);
+        /**
+         * Blends a layer over a pose in place.
+         * @param layer pose of the same size to blend in.
+         * @param weight of the layer, 1 replaces the pose.
+         * @param jointWeights optional per joint scale of weight, one entry per joint.
+         * @param inOut pose blended into.
+         */
+        static void blend(const Pose& layer, float weight, const float* jointWeights, Pose& inOut);
+    };
+}
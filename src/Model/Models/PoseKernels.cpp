@@ -0,0 +1,313 @@
+#include "PoseKernels.hpp"
+
+#include <cmath>
+#include "Model/Models/SimdLanes.hpp"
+
+// Scalar reference ------------------------------------------------------------------------------
+
+void Model::Kernels::Scalar::interpolate(const glm::vec3 *firstTranslations,
+                                         const glm::quat *firstRotations,
+                                         const glm::vec3 *secondTranslations,
+                                         const glm::quat *secondRotations, float progression,
+                                         size_t count, glm::vec3 *outTranslations,
+                                         glm::quat *outRotations) {
+    const float inverse = 1.0f - progression;
+    for (size_t i = 0; i < count; ++i) {
+        outTranslations[i] = firstTranslations[i] * inverse + secondTranslations[i] * progression;
+
+        const glm::quat &a = firstRotations[i];
+        const glm::quat &b = secondRotations[i];
+        float dot    = a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+        float weight = dot < 0.0f ? -progression : progression;
+        float x      = a.x * inverse + b.x * weight;
+        float y      = a.y * inverse + b.y * weight;
+        float z      = a.z * inverse + b.z * weight;
+        float w      = a.w * inverse + b.w * weight;
+        float length = std::sqrt(x * x + y * y + z * z + w * w);
+        outRotations[i] = glm::quat(w / length, x / length, y / length, z / length);
+    }
+}
+
+void Model::Kernels::Scalar::slerp(const glm::vec3 *firstTranslations,
+                                   const glm::quat *firstRotations,
+                                   const glm::vec3 *secondTranslations,
+                                   const glm::quat *secondRotations, float progression,
+                                   size_t count, glm::vec3 *outTranslations,
+                                   glm::quat *outRotations) {
+    for (size_t i = 0; i < count; ++i) {
+        outTranslations[i] = glm::mix(firstTranslations[i], secondTranslations[i], progression);
+        outRotations[i]    = glm::slerp(firstRotations[i], secondRotations[i], progression);
+    }
+}
+
+void Model::Kernels::Scalar::composeTransforms(const glm::vec3 *translations,
+                                               const glm::quat *rotations, size_t count,
+                                               glm::mat4 *out) {
+    for (size_t i = 0; i < count; ++i) {
+        const glm::quat &q = rotations[i];
+        float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+        float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+        float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+        glm::mat4 &m = out[i];
+        m[0] = glm::vec4(1.0f - 2.0f * (yy + zz), 2.0f * (xy + wz), 2.0f * (xz - wy), 0.0f);
+        m[1] = glm::vec4(2.0f * (xy - wz), 1.0f - 2.0f * (xx + zz), 2.0f * (yz + wx), 0.0f);
+        m[2] = glm::vec4(2.0f * (xz + wy), 2.0f * (yz - wx), 1.0f - 2.0f * (xx + yy), 0.0f);
+        m[3] = glm::vec4(translations[i], 1.0f);
+    }
+}
+
+glm::mat4 Model::Kernels::Scalar::multiplyAffine(const glm::mat4 &a, const glm::mat4 &b) {
+    glm::mat4 out(1.0f);
+    for (int column = 0; column < 4; ++column) {
+        out[column] = a[0] * b[column][0] + a[1] * b[column][1] + a[2] * b[column][2];
+    }
+    out[3] += a[3];
+    return out;
+}
+
+void Model::Kernels::Scalar::localToModel(const int *parents, glm::mat4 *transforms, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        if (parents[i] >= 0) {
+            transforms[i] = multiplyAffine(transforms[parents[i]], transforms[i]);
+        }
+    }
+}
+
+#if ANIMTEST_SSE_KERNELS
+
+namespace {
+    using Wide = Model::Simd::Widest;
+
+    /// Lerps the translations of whole blocks of joints as a flat float array, WIDTH joints
+    /// hold 3 * WIDTH floats.
+    template<typename Simd>
+    void lerpBlocks(const glm::vec3 *firstTranslations, const glm::vec3 *secondTranslations,
+                    float progression, size_t blocks, glm::vec3 *outTranslations) {
+        using Vector = typename Simd::Vector;
+        const Vector t   = Simd::set1(progression);
+        const Vector inv = Simd::set1(1.0f - progression);
+        const auto *firstFloats  = &firstTranslations[0].x;
+        const auto *secondFloats = &secondTranslations[0].x;
+        auto *outFloats          = &outTranslations[0].x;
+        for (size_t i = 0; i < blocks * 3; i += Simd::WIDTH) {
+            Vector a = Simd::load(firstFloats + i);
+            Vector b = Simd::load(secondFloats + i);
+            Simd::store(outFloats + i, Simd::add(Simd::mul(a, inv), Simd::mul(b, t)));
+        }
+    }
+
+    /// Processes whole blocks of joints and returns how many were handled.
+    template<typename Simd>
+    size_t interpolateBlocks(const glm::vec3 *firstTranslations, const glm::quat *firstRotations,
+                             const glm::vec3 *secondTranslations, const glm::quat *secondRotations,
+                             float progression, size_t count, glm::vec3 *outTranslations,
+                             glm::quat *outRotations) {
+        using Vector = typename Simd::Vector;
+        const size_t blocks = count / Simd::WIDTH * Simd::WIDTH;
+        const Vector t      = Simd::set1(progression);
+        const Vector inv    = Simd::set1(1.0f - progression);
+        lerpBlocks<Simd>(firstTranslations, secondTranslations, progression, blocks,
+                         outTranslations);
+
+        for (size_t i = 0; i < blocks; i += Simd::WIDTH) {
+            Vector ax, ay, az, aw, bx, by, bz, bw;
+            Simd::loadQuats(firstRotations + i, ax, ay, az, aw);
+            Simd::loadQuats(secondRotations + i, bx, by, bz, bw);
+            Vector dot = Simd::add(Simd::add(Simd::mul(ax, bx), Simd::mul(ay, by)),
+                                   Simd::add(Simd::mul(az, bz), Simd::mul(aw, bw)));
+            Vector weight = Simd::negateWhereNegative(t, dot);
+            Vector x = Simd::add(Simd::mul(ax, inv), Simd::mul(bx, weight));
+            Vector y = Simd::add(Simd::mul(ay, inv), Simd::mul(by, weight));
+            Vector z = Simd::add(Simd::mul(az, inv), Simd::mul(bz, weight));
+            Vector w = Simd::add(Simd::mul(aw, inv), Simd::mul(bw, weight));
+            Vector length = Simd::sqrt(Simd::add(Simd::add(Simd::mul(x, x), Simd::mul(y, y)),
+                                                 Simd::add(Simd::mul(z, z), Simd::mul(w, w))));
+            Simd::storeQuats(outRotations + i, Simd::div(x, length), Simd::div(y, length),
+                             Simd::div(z, length), Simd::div(w, length));
+        }
+        return blocks;
+    }
+
+    /// acos on [0, 1], Abramowitz and Stegun 4.4.46, absolute error below 2e-8.
+    template<typename Simd>
+    typename Simd::Vector acosUnit(typename Simd::Vector x) {
+        constexpr float COEFFICIENTS[] = {-0.0012624911f, 0.0066700901f, -0.0170881256f,
+                                          0.0308918810f,  -0.0501743046f, 0.0889789874f,
+                                          -0.2145988016f, 1.5707963050f};
+        typename Simd::Vector polynomial = Simd::set1(COEFFICIENTS[0]);
+        for (size_t i = 1; i < sizeof(COEFFICIENTS) / sizeof(float); ++i) {
+            polynomial = Simd::add(Simd::mul(polynomial, x), Simd::set1(COEFFICIENTS[i]));
+        }
+        return Simd::mul(Simd::sqrt(Simd::max(Simd::sub(Simd::set1(1.0f), x), Simd::set1(0.0f))),
+                         polynomial);
+    }
+
+    /// sin on [0, pi / 2], Taylor series to x^11, error below 6e-8.
+    template<typename Simd>
+    typename Simd::Vector sinQuadrant(typename Simd::Vector x) {
+        constexpr float COEFFICIENTS[] = {-1.0f / 39916800.0f, 1.0f / 362880.0f, -1.0f / 5040.0f,
+                                          1.0f / 120.0f, -1.0f / 6.0f, 1.0f};
+        typename Simd::Vector square     = Simd::mul(x, x);
+        typename Simd::Vector polynomial = Simd::set1(COEFFICIENTS[0]);
+        for (size_t i = 1; i < sizeof(COEFFICIENTS) / sizeof(float); ++i) {
+            polynomial = Simd::add(Simd::mul(polynomial, square), Simd::set1(COEFFICIENTS[i]));
+        }
+        return Simd::mul(polynomial, x);
+    }
+
+    template<typename Simd>
+    size_t slerpBlocks(const glm::vec3 *firstTranslations, const glm::quat *firstRotations,
+                       const glm::vec3 *secondTranslations, const glm::quat *secondRotations,
+                       float progression, size_t count, glm::vec3 *outTranslations,
+                       glm::quat *outRotations) {
+        using Vector = typename Simd::Vector;
+        const size_t blocks = count / Simd::WIDTH * Simd::WIDTH;
+        const Vector t      = Simd::set1(progression);
+        const Vector inv    = Simd::set1(1.0f - progression);
+        // Below this angle sin(angle) is too small to divide by and the weights are linear.
+        const Vector smallest = Simd::set1(1e-6f);
+        lerpBlocks<Simd>(firstTranslations, secondTranslations, progression, blocks,
+                         outTranslations);
+
+        for (size_t i = 0; i < blocks; i += Simd::WIDTH) {
+            Vector ax, ay, az, aw, bx, by, bz, bw;
+            Simd::loadQuats(firstRotations + i, ax, ay, az, aw);
+            Simd::loadQuats(secondRotations + i, bx, by, bz, bw);
+            Vector dot = Simd::add(Simd::add(Simd::mul(ax, bx), Simd::mul(ay, by)),
+                                   Simd::add(Simd::mul(az, bz), Simd::mul(aw, bw)));
+            // Taking the shortest path flips the second rotation where the dot is negative.
+            Vector cosine = Simd::min(Simd::negateWhereNegative(dot, dot), Simd::set1(1.0f));
+            Vector angle  = Simd::max(acosUnit<Simd>(cosine), smallest);
+            Vector sine   = sinQuadrant<Simd>(angle);
+            Vector first  = Simd::div(sinQuadrant<Simd>(Simd::mul(inv, angle)), sine);
+            Vector second = Simd::negateWhereNegative(
+                Simd::div(sinQuadrant<Simd>(Simd::mul(t, angle)), sine), dot);
+            Simd::storeQuats(outRotations + i,
+                             Simd::add(Simd::mul(ax, first), Simd::mul(bx, second)),
+                             Simd::add(Simd::mul(ay, first), Simd::mul(by, second)),
+                             Simd::add(Simd::mul(az, first), Simd::mul(bz, second)),
+                             Simd::add(Simd::mul(aw, first), Simd::mul(bw, second)));
+        }
+        return blocks;
+    }
+
+    template<typename Simd>
+    size_t composeBlocks(const glm::vec3 *translations, const glm::quat *rotations, size_t count,
+                         glm::mat4 *out) {
+        using Vector = typename Simd::Vector;
+        const size_t blocks = count / Simd::WIDTH * Simd::WIDTH;
+        const Vector one    = Simd::set1(1.0f);
+        const Vector two    = Simd::set1(2.0f);
+        const Vector zero   = Simd::set1(0.0f);
+        for (size_t i = 0; i < blocks; i += Simd::WIDTH) {
+            Vector x, y, z, w;
+            Simd::loadQuats(rotations + i, x, y, z, w);
+            Vector xx = Simd::mul(x, x), yy = Simd::mul(y, y), zz = Simd::mul(z, z);
+            Vector xy = Simd::mul(x, y), xz = Simd::mul(x, z), yz = Simd::mul(y, z);
+            Vector wx = Simd::mul(w, x), wy = Simd::mul(w, y), wz = Simd::mul(w, z);
+            Simd::storeColumns(out + i, 0, Simd::sub(one, Simd::mul(two, Simd::add(yy, zz))),
+                               Simd::mul(two, Simd::add(xy, wz)), Simd::mul(two, Simd::sub(xz, wy)), zero);
+            Simd::storeColumns(out + i, 1, Simd::mul(two, Simd::sub(xy, wz)),
+                               Simd::sub(one, Simd::mul(two, Simd::add(xx, zz))),
+                               Simd::mul(two, Simd::add(yz, wx)), zero);
+            Simd::storeColumns(out + i, 2, Simd::mul(two, Simd::add(xz, wy)),
+                               Simd::mul(two, Simd::sub(yz, wx)),
+                               Simd::sub(one, Simd::mul(two, Simd::add(xx, yy))), zero);
+            for (size_t k = 0; k < Simd::WIDTH; ++k) {
+                out[i + k][3] = glm::vec4(translations[i + k], 1.0f);
+            }
+        }
+        return blocks;
+    }
+}
+
+void Model::Kernels::interpolate(const glm::vec3 *firstTranslations, const glm::quat *firstRotations,
+                                 const glm::vec3 *secondTranslations,
+                                 const glm::quat *secondRotations, float progression, size_t count,
+                                 glm::vec3 *outTranslations, glm::quat *outRotations) {
+    size_t done = interpolateBlocks<Wide>(firstTranslations, firstRotations, secondTranslations,
+                                          secondRotations, progression, count, outTranslations,
+                                          outRotations);
+    Scalar::interpolate(firstTranslations + done, firstRotations + done, secondTranslations + done,
+                        secondRotations + done, progression, count - done, outTranslations + done,
+                        outRotations + done);
+}
+
+void Model::Kernels::slerp(const glm::vec3 *firstTranslations, const glm::quat *firstRotations,
+                           const glm::vec3 *secondTranslations, const glm::quat *secondRotations,
+                           float progression, size_t count, glm::vec3 *outTranslations,
+                           glm::quat *outRotations) {
+    // The tail runs the same polynomials one lane at a time, so every joint gets the same
+    // approximation.
+    size_t done = slerpBlocks<Wide>(firstTranslations, firstRotations, secondTranslations,
+                                    secondRotations, progression, count, outTranslations,
+                                    outRotations);
+    slerpBlocks<Model::Simd::Single>(firstTranslations + done, firstRotations + done,
+                                     secondTranslations + done, secondRotations + done,
+                                     progression, count - done, outTranslations + done,
+                                     outRotations + done);
+}
+
+void Model::Kernels::composeTransforms(const glm::vec3 *translations, const glm::quat *rotations,
+                                       size_t count, glm::mat4 *out) {
+    size_t done = composeBlocks<Wide>(translations, rotations, count, out);
+    Scalar::composeTransforms(translations + done, rotations + done, count - done, out + done);
+}
+
+glm::mat4 Model::Kernels::multiplyAffine(const glm::mat4 &a, const glm::mat4 &b) {
+    // One column per register, a single matrix product is too small for 8 lanes to pay off.
+    using Model::Simd::Sse;
+    glm::mat4 out;
+    const Sse::Vector a0 = Sse::load(&a[0][0]);
+    const Sse::Vector a1 = Sse::load(&a[1][0]);
+    const Sse::Vector a2 = Sse::load(&a[2][0]);
+    for (int column = 0; column < 4; ++column) {
+        Sse::Vector result = Sse::add(Sse::add(Sse::mul(a0, Sse::set1(b[column][0])),
+                                               Sse::mul(a1, Sse::set1(b[column][1]))),
+                                      Sse::mul(a2, Sse::set1(b[column][2])));
+        Sse::store(&out[column][0], result);
+    }
+    Sse::store(&out[3][0], Sse::add(Sse::load(&out[3][0]), Sse::load(&a[3][0])));
+    return out;
+}
+
+void Model::Kernels::localToModel(const int *parents, glm::mat4 *transforms, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        if (parents[i] >= 0) {
+            transforms[i] = multiplyAffine(transforms[parents[i]], transforms[i]);
+        }
+    }
+}
+
+#else
+
+void Model::Kernels::interpolate(const glm::vec3 *firstTranslations, const glm::quat *firstRotations,
+                                 const glm::vec3 *secondTranslations,
+                                 const glm::quat *secondRotations, float progression, size_t count,
+                                 glm::vec3 *outTranslations, glm::quat *outRotations) {
+    Scalar::interpolate(firstTranslations, firstRotations, secondTranslations, secondRotations,
+                        progression, count, outTranslations, outRotations);
+}
+
+void Model::Kernels::slerp(const glm::vec3 *firstTranslations, const glm::quat *firstRotations,
+                           const glm::vec3 *secondTranslations, const glm::quat *secondRotations,
+                           float progression, size_t count, glm::vec3 *outTranslations,
+                           glm::quat *outRotations) {
+    Scalar::slerp(firstTranslations, firstRotations, secondTranslations, secondRotations,
+                  progression, count, outTranslations, outRotations);
+}
+
+void Model::Kernels::composeTransforms(const glm::vec3 *translations, const glm::quat *rotations,
+                                       size_t count, glm::mat4 *out) {
+    Scalar::composeTransforms(translations, rotations, count, out);
+}
+
+glm::mat4 Model::Kernels::multiplyAffine(const glm::mat4 &a, const glm::mat4 &b) {
+    return Scalar::multiplyAffine(a, b);
+}
+
+void Model::Kernels::localToModel(const int *parents, glm::mat4 *transforms, size_t count) {
+    Scalar::localToModel(parents, transforms, count);
+}
+
+#endif
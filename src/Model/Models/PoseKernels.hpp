@@ -0,0 +1,97 @@
+#pragma once
+#include <vector>
+#include <glm/matrix.hpp>
+#include <glm/vec3.hpp>
+#include <glm/gtx/quaternion.hpp>
+
+/// SIMD paths are used when the target supports them unless the scalar path is forced.
+#if !defined(ANIMTEST_SCALAR_KERNELS) && (defined(__SSE2__) || defined(_M_X64))
+#    define ANIMTEST_SSE_KERNELS 1
+#endif
+#if !defined(ANIMTEST_SCALAR_KERNELS) && defined(__AVX2__)
+#    define ANIMTEST_AVX2_KERNELS 1
+#endif
+/// Half precision conversion comes with every AVX2 target, MSVC does not announce it separately.
+#if !defined(ANIMTEST_SCALAR_KERNELS) && \
+    (defined(__F16C__) || (defined(_MSC_VER) && defined(__AVX2__)))
+#    define ANIMTEST_F16C_KERNELS 1
+#endif
+
+namespace Model::Kernels {
+    /**
+     * Blends two sets of joint transforms, lerping translations and nlerping rotations along the
+     * shortest path. Joints are processed 4 (SSE) or 8 (AVX2) at a time.
+     * @param firstTranslations translations at progression 0.
+     * @param firstRotations rotations at progression 0.
+     * @param secondTranslations translations at progression 1.
+     * @param secondRotations rotations at progression 1.
+     * @param progression blend factor.
+     * @param count number of joints.
+     * @param outTranslations receives the blended translations, may alias an input.
+     * @param outRotations receives the blended rotations, may alias an input.
+     */
+    void interpolate(const glm::vec3 *firstTranslations, const glm::quat *firstRotations,
+                     const glm::vec3 *secondTranslations, const glm::quat *secondRotations,
+                     float progression, size_t count, glm::vec3 *outTranslations,
+                     glm::quat *outRotations);
+
+    /**
+     * Blends two sets of joint transforms like interpolate, but slerps rotations along the
+     * shortest path so they turn at a constant rate, as glm::slerp does. The angles come from
+     * polynomial fits of acos and sin accurate to about 1e-7.
+     * @param firstTranslations translations at progression 0.
+     * @param firstRotations rotations at progression 0.
+     * @param secondTranslations translations at progression 1.
+     * @param secondRotations rotations at progression 1.
+     * @param progression blend factor.
+     * @param count number of joints.
+     * @param outTranslations receives the blended translations, may alias an input.
+     * @param outRotations receives the blended rotations, may alias an input.
+     */
+    void slerp(const glm::vec3 *firstTranslations, const glm::quat *firstRotations,
+               const glm::vec3 *secondTranslations, const glm::quat *secondRotations,
+               float progression, size_t count, glm::vec3 *outTranslations,
+               glm::quat *outRotations);
+
+    /**
+     * Converts joint translations and rotations into affine matrices.
+     * @param translations of each joint.
+     * @param rotations of each joint, expected to be normalised.
+     * @param count number of joints.
+     * @param out receives one matrix per joint.
+     */
+    void composeTransforms(const glm::vec3 *translations, const glm::quat *rotations, size_t count,
+                           glm::mat4 *out);
+
+    /**
+     * Multiplies two affine matrices, the bottom row of both is assumed to be (0, 0, 0, 1).
+     * @param a left hand matrix.
+     * @param b right hand matrix.
+     * @return a * b.
+     */
+    glm::mat4 multiplyAffine(const glm::mat4 &a, const glm::mat4 &b);
+
+    /**
+     * Applies out[i] = out[parents[i]] * out[i] in order, turning local matrices into model space.
+     * @param parents index of each joint's parent, parents must precede their children.
+     * @param transforms local matrices in, model space matrices out.
+     * @param count number of joints.
+     */
+    void localToModel(const int *parents, glm::mat4 *transforms, size_t count);
+
+    /// Scalar reference implementations the SIMD paths are checked against.
+    namespace Scalar {
+        void interpolate(const glm::vec3 *firstTranslations, const glm::quat *firstRotations,
+                         const glm::vec3 *secondTranslations, const glm::quat *secondRotations,
+                         float progression, size_t count, glm::vec3 *outTranslations,
+                         glm::quat *outRotations);
+        void slerp(const glm::vec3 *firstTranslations, const glm::quat *firstRotations,
+                   const glm::vec3 *secondTranslations, const glm::quat *secondRotations,
+                   float progression, size_t count, glm::vec3 *outTranslations,
+                   glm::quat *outRotations);
+        void composeTransforms(const glm::vec3 *translations, const glm::quat *rotations,
+                               size_t count, glm::mat4 *out);
+        glm::mat4 multiplyAffine(const glm::mat4 &a, const glm::mat4 &b);
+        void localToModel(const int *parents, glm::mat4 *transforms, size_t count);
+    }
+}
@@ -0,0 +1,241 @@
+#include "ResampledAnimation.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include "Model/Models/Animation.hpp"
+#include "Model/Models/PoseKernels.hpp"
+
+namespace {
+    constexpr char MAGIC[4] = {'A', 'N', 'R', 'S'};
+    /// Version 2 stores each page as its translations followed by its rotations.
+    constexpr uint32_t VERSION = 2;
+
+    template<typename T>
+    void writeValue(std::ostream &out, const T &value) {
+        out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    template<typename T>
+    T readValue(std::istream &in) {
+        T value = {};
+        in.read(reinterpret_cast<char *>(&value), sizeof(T));
+        return value;
+    }
+}
+
+Model::ResampledAnimation::ResampledAnimation(const Animation &animation, size_t jointCount,
+                                             double newRate, size_t newFramesPerPage) {
+    rate          = newRate;
+    length        = animation.getLength();
+    framesPerPage = std::max<size_t>(newFramesPerPage, 1);
+    frameCount    = static_cast<size_t>(std::ceil(length * rate)) + 1;
+    if (animation.compressed) {
+        for (const auto &track : animation.compressed->tracks) {
+            joints.push_back(track.joint);
+        }
+    } else {
+        for (const auto &track : animation.getTracks()) {
+            joints.push_back(track.joint);
+        }
+    }
+
+    // A track emptied by static joint elimination in one channel stores the rest pose there, so
+    // the frames hold what sampling the tracks would have left in that channel.
+    Pose pose = animation.restPose.size() == jointCount ? animation.restPose : Pose(jointCount);
+    std::vector<TrackCursor> cursors = {};
+    pages.resize(getPageCount());
+    for (size_t page = 0; page < pages.size(); ++page) {
+        auto &frames = pages[page];
+        frames.translations.reserve(getPageFrameCount(page) * joints.size());
+        frames.rotations.reserve(getPageFrameCount(page) * joints.size());
+        for (size_t frame = 0; frame < getPageFrameCount(page); ++frame) {
+            double time = std::min(static_cast<double>(page * framesPerPage + frame) / rate, length);
+            if (!animation.sample(time, cursors, pose)) {
+                throw std::runtime_error("Clip to resample has pages that are not resident");
+            }
+            for (auto joint : joints) {
+                frames.translations.push_back(pose.translations[joint]);
+                frames.rotations.push_back(pose.rotations[joint]);
+            }
+        }
+    }
+}
+
+size_t Model::ResampledAnimation::getPageCount() const {
+    if (frameCount < 2) {
+        return frameCount;
+    }
+    return (frameCount - 2) / framesPerPage + 1;
+}
+
+size_t Model::ResampledAnimation::getPageFrameCount(size_t page) const {
+    if (frameCount < 2) {
+        return frameCount;
+    }
+    return std::min(framesPerPage, frameCount - 1 - page * framesPerPage) + 1;
+}
+
+size_t Model::ResampledAnimation::getPage(double time) const {
+    if (frameCount < 2) {
+        return 0;
+    }
+    double frame = std::clamp(time * rate, 0.0, static_cast<double>(frameCount - 2));
+    return static_cast<size_t>(frame) / framesPerPage;
+}
+
+bool Model::ResampledAnimation::isResident(size_t page) const {
+    // A clip without animated joints has nothing to load, its empty pages are always resident.
+    return page < pages.size() && (joints.empty() || !pages[page].rotations.empty());
+}
+
+bool Model::ResampledAnimation::sample(double time, Pose &pose, const uint8_t *jointMask) const {
+    if (frameCount == 0) {
+        return true;
+    }
+    double frame = std::clamp(time * rate, 0.0, length * rate);
+    size_t first = std::min(static_cast<size_t>(frame), frameCount > 1 ? frameCount - 2 : 0);
+    size_t page  = first / framesPerPage;
+    if (!isResident(page)) {
+        return false;
+    }
+    size_t current = (first - page * framesPerPage) * joints.size();
+    size_t next    = frameCount > 1 ? current + joints.size() : current;
+    const auto &translations = pages[page].translations;
+    const auto &rotations    = pages[page].rotations;
+    // The closing frame sits at the clip length, so the last segment can be shorter than a
+    // frame and its progression is scaled by its actual duration.
+    double segment    = std::min(1.0, length * rate - static_cast<double>(first));
+    float progression = segment > 0.0
+                            ? static_cast<float>((frame - static_cast<double>(first)) / segment)
+                            : 0.0f;
+    // Channels of consecutive joints are blended straight into the pose as one run.
+    for (size_t i = 0; i < joints.size();) {
+        if (jointMask != nullptr && jointMask[joints[i]] == 0) {
+            ++i;
+            continue;
+        }
+        size_t count = 1;
+        while (i + count < joints.size() && joints[i + count] == joints[i] + count &&
+               (jointMask == nullptr || jointMask[joints[i + count]] != 0)) {
+            ++count;
+        }
+        Kernels::slerp(&translations[current + i], &rotations[current + i],
+                       &translations[next + i], &rotations[next + i], progression, count,
+                       &pose.translations[joints[i]], &pose.rotations[joints[i]]);
+        i += count;
+    }
+    return true;
+}
+
+void Model::ResampledAnimation::stream(double start, double end) {
+    if (loader == nullptr || pages.empty()) {
+        return;
+    }
+    std::vector<bool> wanted(pages.size(), false);
+    size_t first = getPage(start);
+    if (end > length && length > 0.0) {
+        // The window wraps around the end of a looping clip.
+        for (size_t page = first; page < pages.size(); ++page) {
+            wanted[page] = true;
+        }
+        first = 0;
+        end   = std::fmod(end, length);
+    }
+    for (size_t page = first; page <= getPage(end); ++page) {
+        wanted[page] = true;
+    }
+    for (size_t page = 0; page < pages.size(); ++page) {
+        if (wanted[page] && !isResident(page)) {
+            pages[page].translations.resize(getPageFrameCount(page) * joints.size());
+            pages[page].rotations.resize(getPageFrameCount(page) * joints.size());
+            loader(page, pages[page]);
+        } else if (!wanted[page] && !pages[page].rotations.empty()) {
+            pages[page] = {};
+        }
+    }
+}
+
+void Model::ResampledAnimation::write(std::ostream &out) const {
+    // The offset table assumes every page is written in full.
+    for (size_t page = 0; page < pages.size(); ++page) {
+        if (!isResident(page) && loader == nullptr && getPageFrameCount(page) * joints.size() > 0) {
+            throw std::runtime_error("Resampled clip has a page that is neither resident nor loadable");
+        }
+    }
+    out.write(MAGIC, sizeof(MAGIC));
+    writeValue(out, VERSION);
+    writeValue(out, rate);
+    writeValue(out, length);
+    writeValue(out, static_cast<uint64_t>(frameCount));
+    writeValue(out, static_cast<uint64_t>(framesPerPage));
+    writeValue(out, static_cast<uint64_t>(joints.size()));
+    for (auto joint : joints) {
+        writeValue(out, static_cast<uint64_t>(joint));
+    }
+    writeValue(out, static_cast<uint64_t>(pages.size()));
+    // Page offsets are relative to the start of the page data.
+    uint64_t offset = 0;
+    for (size_t page = 0; page < pages.size(); ++page) {
+        writeValue(out, offset);
+        offset += getPageFrameCount(page) * joints.size() *
+                  (sizeof(glm::vec3) + sizeof(glm::quat));
+    }
+    SampledPage loaded = {};
+    for (size_t page = 0; page < pages.size(); ++page) {
+        const auto *frames = &pages[page];
+        if (!isResident(page)) {
+            loaded.translations.resize(getPageFrameCount(page) * joints.size());
+            loaded.rotations.resize(getPageFrameCount(page) * joints.size());
+            if (!loaded.rotations.empty()) {
+                loader(page, loaded);
+            }
+            frames = &loaded;
+        }
+        out.write(reinterpret_cast<const char *>(frames->translations.data()),
+                  static_cast<std::streamsize>(frames->translations.size() * sizeof(glm::vec3)));
+        out.write(reinterpret_cast<const char *>(frames->rotations.data()),
+                  static_cast<std::streamsize>(frames->rotations.size() * sizeof(glm::quat)));
+    }
+}
+
+Model::ResampledAnimation Model::ResampledAnimation::open(std::shared_ptr<std::istream> in) {
+    ResampledAnimation animation = {};
+    char magic[4] = {};
+    in->read(magic, sizeof(magic));
+    if (std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 || readValue<uint32_t>(*in) != VERSION) {
+        return animation;
+    }
+    animation.rate          = readValue<double>(*in);
+    animation.length        = readValue<double>(*in);
+    animation.frameCount    = readValue<uint64_t>(*in);
+    animation.framesPerPage = readValue<uint64_t>(*in);
+    animation.joints.resize(readValue<uint64_t>(*in));
+    for (auto &joint : animation.joints) {
+        joint = readValue<uint64_t>(*in);
+    }
+    std::vector<uint64_t> offsets(readValue<uint64_t>(*in));
+    for (auto &offset : offsets) {
+        offset = readValue<uint64_t>(*in);
+    }
+    auto dataStart = in->tellg();
+    animation.pages.resize(offsets.size());
+    animation.loader = [in, dataStart, offsets](size_t page, SampledPage &frames) {
+        in->seekg(dataStart + static_cast<std::streamoff>(offsets[page]));
+        in->read(reinterpret_cast<char *>(frames.translations.data()),
+                 static_cast<std::streamsize>(frames.translations.size() * sizeof(glm::vec3)));
+        in->read(reinterpret_cast<char *>(frames.rotations.data()),
+                 static_cast<std::streamsize>(frames.rotations.size() * sizeof(glm::quat)));
+    };
+    return animation;
+}
+
+size_t Model::ResampledAnimation::getMemoryUsage() const {
+    size_t bytes = joints.size() * sizeof(size_t) + pages.size() * sizeof(SampledPage);
+    for (const auto &page : pages) {
+        bytes += page.translations.size() * sizeof(glm::vec3) +
+                 page.rotations.size() * sizeof(glm::quat);
+    }
+    return bytes;
+}
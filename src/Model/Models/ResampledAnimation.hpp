@@ -0,0 +1,115 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <vector>
+#include <glm/vec3.hpp>
+#include <glm/gtx/quaternion.hpp>
+#include "Model/Models/Pose.hpp"
+
+namespace Model {
+    class Animation;
+
+    /// Local transforms of the joints in the frames of one page, frame-major, the joints of
+    /// frame f are at [f * joints, (f + 1) * joints).
+    struct SampledPage {
+        std::vector<glm::vec3> translations = {};
+        std::vector<glm::quat> rotations = {};
+    };
+
+    /**
+     * A clip resampled at a fixed rate into frame-major buffers, so any time maps to its frames
+     * with a single multiply and every joint shares one progression, which lets sampling run
+     * through the pose kernels. Frames are split into pages covering a fixed time window, each page
+     * repeating the first frame of the next one so interpolation never crosses a page. Pages can be
+     * released and loaded again on demand, which lets long clips stream by time window.
+     */
+    class ResampledAnimation {
+      public:
+        /// Loads the joints of one page into buffers sized for it.
+        using PageLoader = std::function<void(size_t page, SampledPage& frames)>;
+
+        /// Sample rate in Hz.
+        double rate = 30.0;
+        /// Length of the clip in seconds.
+        double length = 0;
+        size_t frameCount = 0;
+        /// Frames starting in each page, pages hold one extra frame for interpolation.
+        size_t framesPerPage = 64;
+        /// Joint index of each sampled channel, in the order joints are stored in a frame.
+        std::vector<size_t> joints = {};
+        /// Joint data per page, empty while the page is not resident.
+        std::vector<SampledPage> pages = {};
+
+        ResampledAnimation() = default;
+        /**
+         * Resamples a clip. Channels a track does not animate are stored from the clip's
+         * restPose, or as identity if static joints were never eliminated.
+         * @param animation clip to sample, using its best available representation.
+         * @param jointCount number of joints in the skeleton.
+         * @param newRate sample rate in Hz.
+         * @param newFramesPerPage frames per streaming page.
+         */
+        ResampledAnimation(const Animation& animation, size_t jointCount, double newRate,
+                           size_t newFramesPerPage);
+
+        /**
+         * Samples the clip into a pose. Joints without a channel, or every joint if the page
+         * covering time is not resident, are left untouched.
+         * @param time in seconds.
+         * @param pose to write the sampled joints into.
+         * @param jointMask optional, joints with a zero entry are skipped.
+         * @return false if the page covering time is not resident.
+         */
+        bool sample(double time, Pose& pose, const uint8_t* jointMask = nullptr) const;
+
+        size_t getPageCount() const;
+        /**
+         * Finds the page covering a time.
+         * @param time in seconds.
+         * @return the page index.
+         */
+        size_t getPage(double time) const;
+        /**
+         * Whether a page can be sampled without loading it.
+         * @param page index.
+         * @return true if the page holds its frames, always for a clip without joints.
+         */
+        bool isResident(size_t page) const;
+        /**
+         * Makes the pages covering [start, end] resident and releases every other page.
+         * Only valid when a loader is set, must not run while animators sample the clip.
+         * @param start of the window in seconds.
+         * @param end of the window in seconds, may wrap past the clip length.
+         */
+        void stream(double start, double end);
+
+        /**
+         * Writes the clip as a header, a page offset table and the page data. Pages that are not
+         * resident are read through the loader without being kept.
+         * @param out binary stream to write to.
+         * @throws std::runtime_error if a page is neither resident nor loadable, nothing is
+         * written in that case.
+         */
+        void write(std::ostream& out) const;
+        /**
+         * Opens a clip written with write(), reading only the header. Pages are loaded from the
+         * stream by stream().
+         * @param in binary stream that stays open for as long as the clip is used.
+         * @return the clip with no resident pages.
+         */
+        static ResampledAnimation open(std::shared_ptr<std::istream> in);
+
+        /**
+         * Heap size of the resident pages.
+         * @return size in bytes.
+         */
+        size_t getMemoryUsage() const;
+
+      private:
+        PageLoader loader = nullptr;
+        size_t getPageFrameCount(size_t page) const;
+    };
+}
@@ -0,0 +1,204 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <glm/gtx/quaternion.hpp>
+#include <glm/matrix.hpp>
+#include "Model/Models/PoseKernels.hpp"
+
+#if ANIMTEST_SSE_KERNELS
+#    include <immintrin.h>
+#endif
+
+/**
+ * Lane-wise float operations shared by every SIMD kernel, from the pose kernels to the batched
+ * solvers. Each struct wraps one register width so a kernel written once as a template over
+ * the struct runs 1, 4 or 8 problems per step; the data being processed is laid out SoA so
+ * lane k of every register belongs to problem k. loadQuats, storeQuats and storeColumns move
+ * AoS joints in and out of that layout.
+ */
+namespace Model::Simd {
+    /// Widest register any struct below uses, batches are padded to a multiple of it.
+    constexpr size_t MAX_WIDTH = 8;
+
+    /// One lane, for targets without SIMD and for the tail of a batch.
+    struct Single {
+        using Vector = float;
+        static constexpr size_t WIDTH = 1;
+
+        static Vector set1(float value) { return value; }
+        static Vector add(Vector a, Vector b) { return a + b; }
+        static Vector sub(Vector a, Vector b) { return a - b; }
+        static Vector mul(Vector a, Vector b) { return a * b; }
+        static Vector div(Vector a, Vector b) { return a / b; }
+        static Vector sqrt(Vector a) { return std::sqrt(a); }
+        static Vector min(Vector a, Vector b) { return std::min(a, b); }
+        static Vector max(Vector a, Vector b) { return std::max(a, b); }
+        static Vector load(const float *data) { return *data; }
+        static Vector loadInt16(const int16_t *data) { return static_cast<float>(*data); }
+        static Vector gather(const float *base, const int32_t *indices) { return base[*indices]; }
+        static void store(float *data, Vector value) { *data = value; }
+        static Vector negateWhereNegative(Vector value, Vector test) {
+            return test < 0.0f ? -value : value;
+        }
+        static void loadQuats(const glm::quat *q, Vector &x, Vector &y, Vector &z, Vector &w) {
+            x = q->x;
+            y = q->y;
+            z = q->z;
+            w = q->w;
+        }
+        static void storeQuats(glm::quat *q, Vector x, Vector y, Vector z, Vector w) {
+            *q = glm::quat(w, x, y, z);
+        }
+        static void storeColumns(glm::mat4 *out, int column, Vector a, Vector b, Vector c,
+                                 Vector d) {
+            (*out)[column] = glm::vec4(a, b, c, d);
+        }
+    };
+
+#if ANIMTEST_SSE_KERNELS
+    /// 4-wide operations, one lane per problem.
+    struct Sse {
+        using Vector = __m128;
+        static constexpr size_t WIDTH = 4;
+
+        static Vector set1(float value) { return _mm_set1_ps(value); }
+        static Vector add(Vector a, Vector b) { return _mm_add_ps(a, b); }
+        static Vector sub(Vector a, Vector b) { return _mm_sub_ps(a, b); }
+        static Vector mul(Vector a, Vector b) { return _mm_mul_ps(a, b); }
+        static Vector div(Vector a, Vector b) { return _mm_div_ps(a, b); }
+        static Vector sqrt(Vector a) { return _mm_sqrt_ps(a); }
+        static Vector min(Vector a, Vector b) { return _mm_min_ps(a, b); }
+        static Vector max(Vector a, Vector b) { return _mm_max_ps(a, b); }
+        static Vector load(const float *data) { return _mm_loadu_ps(data); }
+        static Vector loadInt16(const int16_t *data) {
+            // Each value lands in the high half of a 32 bit lane, the shift sign extends it.
+            __m128i packed = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(data));
+            return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(packed, packed), 16));
+        }
+        static Vector gather(const float *base, const int32_t *indices) {
+            return _mm_set_ps(base[indices[3]], base[indices[2]], base[indices[1]],
+                              base[indices[0]]);
+        }
+        static void store(float *data, Vector value) { _mm_storeu_ps(data, value); }
+        /// Flips the sign of the lanes of value where test is negative.
+        static Vector negateWhereNegative(Vector value, Vector test) {
+            Vector sign = _mm_and_ps(_mm_cmplt_ps(test, _mm_setzero_ps()), _mm_set1_ps(-0.0f));
+            return _mm_xor_ps(value, sign);
+        }
+        static void transpose(Vector &r0, Vector &r1, Vector &r2, Vector &r3) {
+            _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+        }
+        /// Loads 4 quaternions, lane k of x, y, z and w holding q[k].
+        static void loadQuats(const glm::quat *q, Vector &x, Vector &y, Vector &z, Vector &w) {
+            x = _mm_loadu_ps(&q[0].x);
+            y = _mm_loadu_ps(&q[1].x);
+            z = _mm_loadu_ps(&q[2].x);
+            w = _mm_loadu_ps(&q[3].x);
+            transpose(x, y, z, w);
+        }
+        static void storeQuats(glm::quat *q, Vector x, Vector y, Vector z, Vector w) {
+            transpose(x, y, z, w);
+            _mm_storeu_ps(&q[0].x, x);
+            _mm_storeu_ps(&q[1].x, y);
+            _mm_storeu_ps(&q[2].x, z);
+            _mm_storeu_ps(&q[3].x, w);
+        }
+        /// Stores lane k of (a, b, c, d) as column `column` of out[k].
+        static void storeColumns(glm::mat4 *out, int column, Vector a, Vector b, Vector c,
+                                 Vector d) {
+            transpose(a, b, c, d);
+            _mm_storeu_ps(&out[0][column][0], a);
+            _mm_storeu_ps(&out[1][column][0], b);
+            _mm_storeu_ps(&out[2][column][0], c);
+            _mm_storeu_ps(&out[3][column][0], d);
+        }
+#    if ANIMTEST_F16C_KERNELS
+        /// Stores the lanes as 16 bit floats, two per word.
+        static void storeHalf(uint32_t *data, Vector value) {
+            _mm_storel_epi64(reinterpret_cast<__m128i *>(data),
+                             _mm_cvtps_ph(value, _MM_FROUND_TO_NEAREST_INT));
+        }
+#    endif
+    };
+#endif
+
+#if ANIMTEST_AVX2_KERNELS
+    /// 8-wide operations, one lane per problem. Shuffles stay within each 128 bit half, so the
+    /// AoS helpers take problems k and k + 4 from the low and high half of a register.
+    struct Avx {
+        using Vector = __m256;
+        static constexpr size_t WIDTH = 8;
+
+        static Vector set1(float value) { return _mm256_set1_ps(value); }
+        static Vector add(Vector a, Vector b) { return _mm256_add_ps(a, b); }
+        static Vector sub(Vector a, Vector b) { return _mm256_sub_ps(a, b); }
+        static Vector mul(Vector a, Vector b) { return _mm256_mul_ps(a, b); }
+        static Vector div(Vector a, Vector b) { return _mm256_div_ps(a, b); }
+        static Vector sqrt(Vector a) { return _mm256_sqrt_ps(a); }
+        static Vector min(Vector a, Vector b) { return _mm256_min_ps(a, b); }
+        static Vector max(Vector a, Vector b) { return _mm256_max_ps(a, b); }
+        static Vector load(const float *data) { return _mm256_loadu_ps(data); }
+        static Vector loadInt16(const int16_t *data) {
+            __m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+            return _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(packed));
+        }
+        static Vector gather(const float *base, const int32_t *indices) {
+            return _mm256_i32gather_ps(
+                base, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(indices)), 4);
+        }
+        static void store(float *data, Vector value) { _mm256_storeu_ps(data, value); }
+        static Vector negateWhereNegative(Vector value, Vector test) {
+            Vector mask = _mm256_cmp_ps(test, _mm256_setzero_ps(), _CMP_LT_OQ);
+            return _mm256_xor_ps(value, _mm256_and_ps(mask, _mm256_set1_ps(-0.0f)));
+        }
+        /// Transposes each 128 bit half independently.
+        static void transpose(Vector &r0, Vector &r1, Vector &r2, Vector &r3) {
+            Vector t0 = _mm256_unpacklo_ps(r0, r1);
+            Vector t1 = _mm256_unpackhi_ps(r0, r1);
+            Vector t2 = _mm256_unpacklo_ps(r2, r3);
+            Vector t3 = _mm256_unpackhi_ps(r2, r3);
+            r0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+            r1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+            r2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+            r3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+        }
+        static Vector loadPair(const float *low, const float *high) {
+            return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(low)),
+                                        _mm_loadu_ps(high), 1);
+        }
+        static void storePair(float *low, float *high, Vector value) {
+            _mm_storeu_ps(low, _mm256_castps256_ps128(value));
+            _mm_storeu_ps(high, _mm256_extractf128_ps(value, 1));
+        }
+        static void loadQuats(const glm::quat *q, Vector &x, Vector &y, Vector &z, Vector &w) {
+            x = loadPair(&q[0].x, &q[4].x);
+            y = loadPair(&q[1].x, &q[5].x);
+            z = loadPair(&q[2].x, &q[6].x);
+            w = loadPair(&q[3].x, &q[7].x);
+            transpose(x, y, z, w);
+        }
+        static void storeQuats(glm::quat *q, Vector x, Vector y, Vector z, Vector w) {
+            transpose(x, y, z, w);
+            storePair(&q[0].x, &q[4].x, x);
+            storePair(&q[1].x, &q[5].x, y);
+            storePair(&q[2].x, &q[6].x, z);
+            storePair(&q[3].x, &q[7].x, w);
+        }
+        static void storeColumns(glm::mat4 *out, int column, Vector a, Vector b, Vector c,
+                                 Vector d) {
+            transpose(a, b, c, d);
+            storePair(&out[0][column][0], &out[4][column][0], a);
+            storePair(&out[1][column][0], &out[5][column][0], b);
+            storePair(&out[2][column][0], &out[6][column][0], c);
+            storePair(&out[3][column][0], &out[7][column][0], d);
+        }
+    };
+    using Widest = Avx;
+#elif ANIMTEST_SSE_KERNELS
+    using Widest = Sse;
+#else
+    using Widest = Single;
+#endif
+}
@@ -0,0 +1,206 @@
+#include "Skeleton.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include "Model/Models/PoseKernels.hpp"
+
+size_t Model::Skeleton::addJoint(const std::string &name, int parent, int boneIndex,
+                                 const glm::mat4 &localBindTransform) {
+    assert(parent < static_cast<int>(names.size()));
+    names.push_back(name);
+    parents.push_back(parent);
+    boneIndices.push_back(boneIndex);
+    localBindTransforms.push_back(localBindTransform);
+    inverseBindTransforms.emplace_back(1.0f);
+    bindPose.translations.emplace_back(localBindTransform[3]);
+    glm::mat3 rotation(glm::normalize(glm::vec3(localBindTransform[0])),
+                       glm::normalize(glm::vec3(localBindTransform[1])),
+                       glm::normalize(glm::vec3(localBindTransform[2])));
+    bindPose.rotations.push_back(glm::normalize(glm::quat_cast(rotation)));
+    mapping[name] = names.size() - 1;
+    ++skinnedJointCount;
+    return names.size() - 1;
+}
+
+void Model::Skeleton::calcInverseBindTransforms() {
+    std::vector<glm::mat4> bindTransforms(size());
+    for (size_t i = 0; i < size(); ++i) {
+        bindTransforms[i] = parents[i] < 0 ? localBindTransforms[i]
+                                           : bindTransforms[static_cast<size_t>(parents[i])] *
+                                                 localBindTransforms[i];
+        inverseBindTransforms[i] = glm::inverse(bindTransforms[i]);
+    }
+}
+
+size_t Model::Skeleton::partitionSkinnedJoints() {
+    std::vector<uint8_t> skinned(size(), 0);
+    for (size_t i = size(); i-- > 0;) {
+        skinned[i] |= boneIndices[i] >= 0 ? 1 : 0;
+        if (skinned[i] != 0 && parents[i] >= 0) {
+            skinned[static_cast<size_t>(parents[i])] = 1;
+        }
+    }
+    // A skinned joint's parent is skinned too, so a stable partition keeps parents first.
+    std::vector<size_t> order = {};
+    order.reserve(size());
+    for (int pass = 1; pass >= 0; --pass) {
+        for (size_t i = 0; i < size(); ++i) {
+            if (skinned[i] == pass) {
+                order.push_back(i);
+            }
+        }
+    }
+    std::vector<int> newIndex(size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        newIndex[order[i]] = static_cast<int>(i);
+    }
+    Skeleton sorted = {};
+    for (size_t joint : order) {
+        int parent = parents[joint] >= 0 ? newIndex[static_cast<size_t>(parents[joint])] : -1;
+        sorted.addJoint(names[joint], parent, boneIndices[joint], localBindTransforms[joint]);
+        sorted.inverseBindTransforms.back() = inverseBindTransforms[joint];
+    }
+    names                 = std::move(sorted.names);
+    parents               = std::move(sorted.parents);
+    boneIndices           = std::move(sorted.boneIndices);
+    localBindTransforms   = std::move(sorted.localBindTransforms);
+    inverseBindTransforms = std::move(sorted.inverseBindTransforms);
+    mapping               = std::move(sorted.mapping);
+    bindPose              = std::move(sorted.bindPose);
+    skinnedJointCount     = static_cast<size_t>(std::count(skinned.begin(), skinned.end(), 1));
+    return skinnedJointCount;
+}
+
+size_t Model::Skeleton::size() const {
+    return names.size();
+}
+
+size_t Model::Skeleton::getBoneCount() const {
+    return boneOffsets.size();
+}
+
+int Model::Skeleton::findJoint(const std::string &name) const {
+    auto joint = mapping.find(name);
+    if (joint == mapping.end()) {
+        return -1;
+    }
+    return static_cast<int>(joint->second);
+}
+
+std::vector<float> Model::Skeleton::calculateJointReach() const {
+    std::vector<float> jointReach(size(), 0.0f);
+    // Children follow their parents, so walking backwards finishes every subtree first.
+    for (size_t i = size(); i-- > 0;) {
+        if (parents[i] >= 0) {
+            auto parent = static_cast<size_t>(parents[i]);
+            float offset = glm::length(glm::vec3(localBindTransforms[i][3]));
+            jointReach[parent] = std::max(jointReach[parent], offset + jointReach[i]);
+        }
+    }
+    return jointReach;
+}
+
+std::vector<size_t> Model::Skeleton::calculateChainLengths() const {
+    std::vector<size_t> depth(size(), 1);
+    std::vector<size_t> height(size(), 0);
+    for (size_t i = 0; i < size(); ++i) {
+        if (parents[i] >= 0) {
+            depth[i] = depth[static_cast<size_t>(parents[i])] + 1;
+        }
+    }
+    for (size_t i = size(); i-- > 0;) {
+        if (parents[i] >= 0) {
+            auto parent = static_cast<size_t>(parents[i]);
+            height[parent] = std::max(height[parent], height[i] + 1);
+        }
+    }
+    for (size_t i = 0; i < size(); ++i) {
+        depth[i] += height[i];
+    }
+    return depth;
+}
+
+std::vector<uint8_t> Model::Skeleton::buildReducedJointMask(float minReachFraction) const {
+    std::vector<uint8_t> mask(size(), 1);
+    auto jointReach = calculateJointReach();
+    float rootReach = jointReach.empty() ? 0.0f : jointReach.front();
+    for (size_t i = 0; i < size(); ++i) {
+        if (parents[i] >= 0 && jointReach[i] < rootReach * minReachFraction) {
+            mask[i] = 0;
+        }
+    }
+    return mask;
+}
+
+std::vector<float> Model::Skeleton::buildSubtreeMask(size_t joint, float weight) const {
+    std::vector<float> mask(size(), 0.0f);
+    if (joint >= size()) {
+        return mask;
+    }
+    mask[joint] = weight;
+    // Parents precede their children, so one forward pass reaches the whole subtree.
+    for (size_t i = joint + 1; i < size(); ++i) {
+        if (parents[i] >= 0 && mask[static_cast<size_t>(parents[i])] != 0.0f) {
+            mask[i] = weight;
+        }
+    }
+    return mask;
+}
+
+std::vector<size_t> Model::Skeleton::collectSubtree(size_t joint) const {
+    std::vector<size_t> subtree = {};
+    if (joint >= skinnedJointCount) {
+        return subtree;
+    }
+    std::vector<uint8_t> inside(skinnedJointCount, 0);
+    inside[joint] = 1;
+    subtree.push_back(joint);
+    for (size_t i = joint + 1; i < skinnedJointCount; ++i) {
+        if (parents[i] >= 0 && inside[static_cast<size_t>(parents[i])] != 0) {
+            inside[i] = 1;
+            subtree.push_back(i);
+        }
+    }
+    return subtree;
+}
+
+std::vector<size_t> Model::Skeleton::collectChain(size_t first) const {
+    std::vector<size_t> chain = {};
+    size_t joint = first;
+    while (joint < skinnedJointCount) {
+        chain.push_back(joint);
+        size_t childCount = 0;
+        size_t child      = 0;
+        for (size_t i = joint + 1; i < skinnedJointCount; ++i) {
+            if (parents[i] == static_cast<int>(joint)) {
+                ++childCount;
+                child = i;
+            }
+        }
+        if (childCount != 1) {
+            break;
+        }
+        joint = child;
+    }
+    return chain;
+}
+
+void Model::Skeleton::localToModel(const Pose &pose, std::vector<glm::mat4> &modelTransforms) const {
+    modelTransforms.resize(size());
+    // Joints that do not affect the skin are never evaluated.
+    Kernels::composeTransforms(pose.translations.data(), pose.rotations.data(), skinnedJointCount,
+                               modelTransforms.data());
+    Kernels::localToModel(parents.data(), modelTransforms.data(), skinnedJointCount);
+}
+
+void Model::Skeleton::buildPalette(const std::vector<glm::mat4> &modelTransforms,
+                                   std::vector<glm::mat4> &palette) const {
+    palette.resize(getBoneCount(), glm::mat4(1.0f));
+    for (size_t i = 0; i < skinnedJointCount; ++i) {
+        if (boneIndices[i] >= 0) {
+            auto bone     = static_cast<size_t>(boneIndices[i]);
+            palette[bone] = Kernels::multiplyAffine(
+                Kernels::multiplyAffine(globalInverseTransform, modelTransforms[i]), boneOffsets[bone]);
+        }
+    }
+}
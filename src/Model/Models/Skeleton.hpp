@@ -0,0 +1,142 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+#include <glm/matrix.hpp>
+#include "Model/Models/Pose.hpp"
+
+namespace Model {
+    /**
+     * What a joint contributes to the skinned mesh, found when a model is imported.
+     */
+    enum class JointUsage : uint8_t {
+        /// At least one clip changes the joint over time.
+        ANIMATED,
+        /// Skins vertices or moves joints that do, but keeps a fixed local transform in every clip.
+        CONSTANT,
+        /// Neither the joint nor any of its descendants skin vertices.
+        UNUSED
+    };
+
+    /**
+     * A joint hierarchy flattened into arrays indexed by joint index. Joints are sorted so every
+     * parent comes before its children, which turns hierarchy evaluation into a single forward loop.
+     * Once built, a skeleton is shared read-only by every animator of a model.
+     */
+    class Skeleton {
+      public:
+        /// Joint names ordered by joint index.
+        std::vector<std::string> names = {};
+        /// Index of each joint's parent, -1 for the root.
+        std::vector<int> parents = {};
+        /// Index of each joint into the bone palette, -1 if the joint does not skin any vertices.
+        std::vector<int> boneIndices = {};
+        /// Transform of each joint relative to its parent in the bind pose.
+        std::vector<glm::mat4> localBindTransforms = {};
+        /// Inverse of each joint's model space bind transform.
+        std::vector<glm::mat4> inverseBindTransforms = {};
+        /// Mesh space to bone space offset of each bone, indexed by bone index.
+        std::vector<glm::mat4> boneOffsets = {};
+        /// Inverse of the scene root transform.
+        glm::mat4 globalInverseTransform = glm::mat4(1.0f);
+        /// Maps a joint name to its joint index.
+        std::map<std::string, size_t> mapping = {};
+        /// Local bind transform of each joint, the pose joints without a track are held at.
+        Pose bindPose = {};
+        /// Joints that skin vertices or have descendants that do, see partitionSkinnedJoints.
+        size_t skinnedJointCount = 0;
+
+        /**
+         * Appends a joint, its parent must already have been added.
+         * @param name of the joint.
+         * @param parent index of the parent joint, -1 for the root.
+         * @param boneIndex palette index, -1 if the joint does not skin any vertices.
+         * @param localBindTransform transform relative to the parent in the bind pose.
+         * @return the joint index.
+         */
+        size_t addJoint(const std::string& name, int parent, int boneIndex,
+                        const glm::mat4& localBindTransform);
+
+        /**
+         * Computes the inverse bind transforms, call once every joint has been added.
+         */
+        void calcInverseBindTransforms();
+        /**
+         * Reorders the joints so the ones that affect the skin come first, still with parents
+         * before children. Joints past skinnedJointCount are left out of hierarchy evaluation.
+         * Call before any clip refers to joint indices.
+         * @return the number of joints that affect the skin.
+         */
+        size_t partitionSkinnedJoints();
+
+        size_t size() const;
+        size_t getBoneCount() const;
+
+        /**
+         * Finds the index of a joint.
+         * @param name of the joint.
+         * @return the joint index or -1 if the joint is not part of the skeleton.
+         */
+        int findJoint(const std::string& name) const;
+
+        /**
+         * Distance in the bind pose from each joint to its furthest end effector.
+         * @return one distance per joint.
+         */
+        std::vector<float> calculateJointReach() const;
+
+        /**
+         * Number of joints on the longest chain from the root to an end effector that passes
+         * through each joint, the joint included.
+         * @return one length per joint.
+         */
+        std::vector<size_t> calculateChainLengths() const;
+
+        /**
+         * Builds the joint set evaluated at reduced detail. Joints whose reach is below a fraction
+         * of the root's reach, such as fingers and facial joints, are left out and keep their
+         * last sampled transform.
+         * @param minReachFraction fraction of the root's reach a joint needs to be kept.
+         * @return one entry per joint, zero for joints that are left out.
+         */
+        std::vector<uint8_t> buildReducedJointMask(float minReachFraction) const;
+
+        /**
+         * Builds per joint layer weights covering one joint and everything below it, for
+         * example the upper body from the spine.
+         * @param joint index of the subtree root.
+         * @param weight given to joints in the subtree, every other joint gets zero.
+         * @return one weight per joint.
+         */
+        std::vector<float> buildSubtreeMask(size_t joint, float weight = 1.0f) const;
+        /**
+         * Lists one joint and every posed joint below it, for post processes that move a
+         * subtree in model space.
+         * @param joint index of the subtree root.
+         * @return joint indices, parents before children.
+         */
+        std::vector<size_t> collectSubtree(size_t joint) const;
+        /**
+         * Follows a joint down through single children, for example the joints of a tail.
+         * @param first index of the chain's root.
+         * @return joint indices from first to the joint where the hierarchy ends or branches.
+         */
+        std::vector<size_t> collectChain(size_t first) const;
+
+        /**
+         * Converts a local pose into model space transforms.
+         * @param pose local pose indexed by joint index.
+         * @param modelTransforms receives one transform per joint, resized if required.
+         */
+        void localToModel(const Pose& pose, std::vector<glm::mat4>& modelTransforms) const;
+
+        /**
+         * Builds the skinning palette from model space joint transforms.
+         * @param modelTransforms model space transform of each joint.
+         * @param palette receives one transform per bone, resized if required.
+         */
+        void buildPalette(const std::vector<glm::mat4>& modelTransforms,
+                          std::vector<glm::mat4>& palette) const;
+    };
+}
@@ -0,0 +1,114 @@
+#include "VertexPacking.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <glm/gtc/packing.hpp>
+
+/// Largest finite half float.
+static constexpr float HALF_MAX = 65504.0f;
+/// Largest value of the 15 bit unorms of a packed tangent.
+static constexpr float TANGENT_MAX = 32767.0f;
+static constexpr uint32_t BITANGENT_SIGN_BIT = 0x80000000u;
+
+glm::vec2 Model::octahedralEncode(const glm::vec3 &direction) {
+    float sum = std::abs(direction.x) + std::abs(direction.y) + std::abs(direction.z);
+    if (sum == 0.0f) {
+        return glm::vec2(0.0f);
+    }
+    glm::vec3 octahedron = direction / sum;
+    glm::vec2 encoded(octahedron.x, octahedron.y);
+    if (octahedron.z < 0.0f) {
+        // Fold the lower half over the diagonals onto the corners of the square.
+        float signX = octahedron.x >= 0.0f ? 1.0f : -1.0f;
+        float signY = octahedron.y >= 0.0f ? 1.0f : -1.0f;
+        encoded = glm::vec2((1.0f - std::abs(octahedron.y)) * signX,
+                            (1.0f - std::abs(octahedron.x)) * signY);
+    }
+    return encoded;
+}
+
+glm::vec3 Model::octahedralDecode(const glm::vec2 &encoded) {
+    glm::vec3 direction(encoded.x, encoded.y, 1.0f - std::abs(encoded.x) - std::abs(encoded.y));
+    float fold = std::max(-direction.z, 0.0f);
+    direction.x += direction.x >= 0.0f ? -fold : fold;
+    direction.y += direction.y >= 0.0f ? -fold : fold;
+    return glm::normalize(direction);
+}
+
+bool Model::canPackVertices(const std::vector<Vertex> &vertices) {
+    for (const auto &vertex : vertices) {
+        for (glm::length_t i = 0; i < 4; ++i) {
+            if (vertex.BoneIDs[i] < 0 || vertex.BoneIDs[i] > 255) {
+                return false;
+            }
+        }
+        if (std::abs(vertex.TexCoords.x) > HALF_MAX || std::abs(vertex.TexCoords.y) > HALF_MAX) {
+            return false;
+        }
+    }
+    return true;
+}
+
+PackedVertex Model::packVertex(const Vertex &vertex) {
+    PackedVertex packed = {};
+    packed.Position = vertex.Position;
+    glm::vec2 normal = glm::clamp(octahedralEncode(vertex.Normal), -1.0f, 1.0f);
+    packed.Normal[0] = static_cast<int16_t>(std::lround(normal.x * 32767.0f));
+    packed.Normal[1] = static_cast<int16_t>(std::lround(normal.y * 32767.0f));
+
+    glm::vec2 tangent = glm::clamp(octahedralEncode(vertex.Tangent), -1.0f, 1.0f);
+    auto u = static_cast<uint32_t>(std::lround((tangent.x * 0.5f + 0.5f) * TANGENT_MAX));
+    auto v = static_cast<uint32_t>(std::lround((tangent.y * 0.5f + 0.5f) * TANGENT_MAX));
+    packed.Tangent = u | (v << 15);
+    if (glm::dot(glm::cross(vertex.Normal, vertex.Tangent), vertex.Bitangent) < 0.0f) {
+        packed.Tangent |= BITANGENT_SIGN_BIT;
+    }
+
+    uint32_t texCoords = glm::packHalf2x16(vertex.TexCoords);
+    packed.TexCoords[0] = static_cast<uint16_t>(texCoords & 0xFFFFu);
+    packed.TexCoords[1] = static_cast<uint16_t>(texCoords >> 16);
+
+    // Rounding each weight on its own can leave the sum a step off, which shrinks or grows the
+    // skinned vertex, so the remainder goes to the largest weight.
+    int total = 0;
+    glm::length_t largest = 0;
+    for (glm::length_t i = 0; i < 4; ++i) {
+        packed.BoneIDs[i] = static_cast<uint8_t>(vertex.BoneIDs[i]);
+        float weight = glm::clamp(vertex.BoneWeight[i], 0.0f, 1.0f);
+        packed.BoneWeight[i] = static_cast<uint8_t>(std::lround(weight * 255.0f));
+        total += packed.BoneWeight[i];
+        if (vertex.BoneWeight[i] > vertex.BoneWeight[largest]) {
+            largest = i;
+        }
+    }
+    float sum = vertex.BoneWeight[0] + vertex.BoneWeight[1] + vertex.BoneWeight[2] +
+                vertex.BoneWeight[3];
+    if (total > 0 && std::abs(sum - 1.0f) < 0.01f) {
+        packed.BoneWeight[largest] =
+            static_cast<uint8_t>(std::clamp(packed.BoneWeight[largest] + 255 - total, 0, 255));
+    }
+    return packed;
+}
+
+Vertex Model::unpackVertex(const PackedVertex &packed) {
+    Vertex vertex = {};
+    vertex.Position = packed.Position;
+    vertex.Normal   = octahedralDecode(glm::vec2(packed.Normal[0], packed.Normal[1]) / 32767.0f);
+    glm::vec2 tangent(static_cast<float>(packed.Tangent & 0x7FFFu),
+                      static_cast<float>((packed.Tangent >> 15) & 0x7FFFu));
+    vertex.Tangent   = octahedralDecode(tangent / TANGENT_MAX * 2.0f - 1.0f);
+    float sign       = (packed.Tangent & BITANGENT_SIGN_BIT) != 0 ? -1.0f : 1.0f;
+    vertex.Bitangent = glm::cross(vertex.Normal, vertex.Tangent) * sign;
+    vertex.TexCoords = glm::unpackHalf2x16(static_cast<uint32_t>(packed.TexCoords[0]) |
+                                           (static_cast<uint32_t>(packed.TexCoords[1]) << 16));
+    for (glm::length_t i = 0; i < 4; ++i) {
+        vertex.BoneIDs[i]    = packed.BoneIDs[i];
+        vertex.BoneWeight[i] = static_cast<float>(packed.BoneWeight[i]) / 255.0f;
+    }
+    return vertex;
+}
+
+void Model::packVertices(const std::vector<Vertex> &vertices, std::vector<PackedVertex> &out) {
+    out.resize(vertices.size());
+    std::transform(vertices.begin(), vertices.end(), out.begin(), packVertex);
+}
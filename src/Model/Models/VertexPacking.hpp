@@ -0,0 +1,46 @@
+#pragma once
+#include <vector>
+#include <glm/glm.hpp>
+#include "Model/Models/DataTypes.hpp"
+
+namespace Model {
+    /**
+     * Maps a direction onto the octahedron unfolded into a square, two values per direction
+     * with near uniform precision over the sphere.
+     * @param direction to encode, need not be normalised.
+     * @return coordinates in [-1, 1], (0, 0) for a zero vector.
+     */
+    glm::vec2 octahedralEncode(const glm::vec3 &direction);
+    /**
+     * Inverse of octahedralEncode, the same decode vertshader.vs runs.
+     * @param encoded coordinates in [-1, 1].
+     * @return unit direction.
+     */
+    glm::vec3 octahedralDecode(const glm::vec2 &encoded);
+
+    /**
+     * Whether every vertex of a mesh fits PackedVertex: bone indices below 256 and texture
+     * coordinates within half float range.
+     * @param vertices of the mesh.
+     * @return false if the mesh has to keep the Vertex layout.
+     */
+    bool canPackVertices(const std::vector<Vertex> &vertices);
+    /**
+     * Quantizes a vertex, see PackedVertex.
+     * @param vertex to pack, checked with canPackVertices.
+     * @return the packed vertex.
+     */
+    PackedVertex packVertex(const Vertex &vertex);
+    /**
+     * Rebuilds a vertex the way the vertex shader does, for measuring the quantization.
+     * @param packed vertex from packVertex.
+     * @return the vertex, its bitangent rebuilt from the normal, tangent and sign.
+     */
+    Vertex unpackVertex(const PackedVertex &packed);
+    /**
+     * Packs every vertex of a mesh.
+     * @param vertices of the mesh.
+     * @param out receives one packed vertex per vertex.
+     */
+    void packVertices(const std::vector<Vertex> &vertices, std::vector<PackedVertex> &out);
+}
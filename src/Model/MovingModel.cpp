@@ -5,20 +5,58 @@
 #include <iostream>
 #include "Model/Models/ModelManager.hpp"
 
-void Model::MovingModel::Draw(glm::mat4 projection, glm::mat4 view) {
+/// Texture unit the baked palette stream is bound to, above any material texture.
+static constexpr int BAKED_PALETTE_UNIT = 15;
+/// Texture unit the frame's palette stream is bound to.
+static constexpr int PALETTE_UNIT = 14;
+
+void Model::MovingModel::Draw(glm::mat4 projection, glm::mat4 view, double time,
+                              unsigned int paletteTexture, PaletteEncoding paletteEncoding) {
+    auto &model = ModelManager::GetModel(modelID);
+    if (usesSkinCache() && skinCache.isReady()) {
+        if (skinnedShader == nullptr) {
+            skinnedShader = std::make_unique<Shader>("res/shader/skinnedvertshader.vs",
+                                                     "res/shader/fragshader.fs");
+        }
+        skinnedShader->use();
+        skinnedShader->setMat4("projection", projection);
+        skinnedShader->setMat4("view", view);
+        skinnedShader->setMat4("model", getModelMatrix());
+        skinCache.draw(model, *skinnedShader);
+        return;
+    }
     ourShader->use();
     ourShader->setMat4("projection", projection);
     ourShader->setMat4("view", view);
 
     // render the loaded model
-    glm::mat4 math_model = glm::mat4(1.0f);
-    math_model = glm::translate(math_model, position); // translate it down so it's at the center of the scene
-    math_model = glm::scale(math_model, scale);	// it's a bit too big for our scene, so scale it down
-    math_model *= glm::toMat4(resultRotation);
-    std::vector<glm::mat4> temp = anim->animatedModel->getJointTransforms();
+    glm::mat4 math_model = getModelMatrix();
     ourShader->setBool("animated", true);
-    ourShader->setMat4Array("jointTransforms", temp);
+    bool baked = isBaked();
+    ourShader->setBool("baked", baked);
+    // Both buffer samplers keep their own unit, a sampler left on unit 0 would clash with the
+    // material's 2D texture.
+    ourShader->setInt("bakedPalette", BAKED_PALETTE_UNIT);
+    ourShader->setInt("palette", PALETTE_UNIT);
+    if (baked) {
+        const auto &clip = model.bakedAnimation->getClip(bakedInstance.clip);
+        glActiveTexture(GL_TEXTURE0 + BAKED_PALETTE_UNIT);
+        glBindTexture(GL_TEXTURE_BUFFER, model.bakedPaletteTexture);
+        glActiveTexture(GL_TEXTURE0);
+        ourShader->setInt("bakedBoneCount", static_cast<int>(model.bakedAnimation->getBoneCount()));
+        ourShader->setVec4("bakedClip", glm::vec4(static_cast<float>(clip.firstFrame),
+                                                  static_cast<float>(clip.frameCount), clip.rate,
+                                                  clip.length));
+        ourShader->setFloat("bakedTime", static_cast<float>(time) + bakedInstance.timeOffset);
+    } else {
+        glActiveTexture(GL_TEXTURE0 + PALETTE_UNIT);
+        glBindTexture(GL_TEXTURE_BUFFER, paletteTexture);
+        glActiveTexture(GL_TEXTURE0);
+        ourShader->setInt("paletteBase", static_cast<int>(paletteBase));
+        ourShader->setInt("paletteEncoding", static_cast<int>(paletteEncoding));
+    }
     ourShader->setMat4("model", math_model);
+    model.applyMorphWeights(anim->morphWeights);
     ModelManager::Draw(modelID, ourShader.get());
 }
 Model::MovingModel::MovingModel() {
@@ -27,11 +65,31 @@ Model::MovingModel::MovingModel() {
     //modelID = ModelManager::GetModelID("res/model/model.dae");
     modelID = ModelManager::GetModelID("res/model/Cyl_Anim.fbx");
     auto &model = ModelManager::GetModel(modelID);
-    anim = std::make_shared<Controller::Animator>();
-    anim->animatedModel = &model;
+    anim = std::make_shared<Controller::Animator>(&model);
     anim->queAnimation(&model.animationList.at(0));
 }
 
+bool Model::MovingModel::isBaked() const {
+    return useBakedAnimation && ModelManager::GetModel(modelID).bakedAnimation != nullptr;
+}
+
+bool Model::MovingModel::usesSkinCache() const {
+    return skinOnce && !isBaked() && ModelManager::GetModel(modelID).morphTargetNames.empty();
+}
+
+glm::mat4 Model::MovingModel::getModelMatrix() const {
+    glm::mat4 math_model = glm::mat4(1.0f);
+    math_model = glm::translate(math_model, position); // translate it down so it's at the center of the scene
+    math_model = glm::scale(math_model, scale);	// it's a bit too big for our scene, so scale it down
+    math_model *= glm::toMat4(resultRotation);
+    return math_model;
+}
+
+float Model::MovingModel::getBoundingRadius() const {
+    float maxScale = glm::max(scale.x, glm::max(scale.y, scale.z));
+    return anim->animatedModel->boundingRadius * maxScale;
+}
+
 void Model::MovingModel::SetRotation(glm::vec3 &orig, glm::vec3 &dest) {
     auto world = glm::vec3(0.0f, 0.0f, 1.0f);
     auto result = dest - orig;
@@ -40,7 +98,3 @@ void Model::MovingModel::SetRotation(glm::vec3 &orig, glm::vec3 &dest) {
 
     resultRotation = glm::quat(glm::angleAxis(angle, glm::vec3(0.0f, 1.0f, 0.0f))) * rotation;
 }
-
-void Model::MovingModel::Update(double t, double dt) {
-    anim->update(t, dt);
-}
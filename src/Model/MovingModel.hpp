@@ -4,21 +4,66 @@
 #include "View/Renderer/Shader.hpp"
 #include <glm/gtc/quaternion.hpp>
 #include "Controller/Animator.hpp"
+#include "Model/Models/BakedAnimation.hpp"
+#include "Model/Models/PaletteEncoding.hpp"
+#include "View/Renderer/SkinCache.hpp"
 
 namespace Model {
     class MovingModel {
       public:
         MovingModel();
-        void Draw(glm::mat4 projection, glm::mat4 view);
-        void Update(double t, double dt);
+        /**
+         * Draws the model, skinned by its animator or by its baked palette stream, or placed
+         * from skinCache once it holds a pose when usesSkinCache.
+         * @param projection matrix of the camera.
+         * @param view matrix of the camera.
+         * @param time of the scene in seconds, used for baked playback.
+         * @param paletteTexture buffer texture holding this frame's PaletteStream.
+         * @param paletteEncoding encoding of that stream.
+         */
+        void Draw(glm::mat4 projection, glm::mat4 view, double time, unsigned int paletteTexture,
+                  PaletteEncoding paletteEncoding);
+        /**
+         * Bounding sphere radius of the model in world space.
+         * @return the model's radius scaled by the instance scale.
+         */
+        float getBoundingRadius() const;
+        /**
+         * Transform the model is drawn with, also what IkSystem needs to find the ground.
+         * @return model space to world space.
+         */
+        glm::mat4 getModelMatrix() const;
         glm::vec3 position = glm::vec3(0, 0, 0);
         size_t modelID = 0;
         std::shared_ptr<Controller::Animator> anim = nullptr;
+        /// Play the model's baked palette stream on the GPU instead of using the animator.
+        bool useBakedAnimation = false;
+        /// Clip and phase played when useBakedAnimation is set.
+        BakedInstance bakedInstance = {};
+        /// First bone of the animator's palette in this frame's PaletteStream.
+        size_t paletteBase = 0;
+        /// Skin the model once per pose on the CPU and draw every pass from skinCache.
+        bool skinOnce = false;
+        /// Skinned vertices of the last pose, filled from a Controller::SkinningSystem.
+        View::SkinCache skinCache = {};
+        /**
+         * Whether the model is drawn from its baked palette stream this frame.
+         * @return true if no live palette is needed.
+         */
+        bool isBaked() const;
+        /**
+         * Whether the model is drawn from skinCache. Baked playback skins on the GPU anyway and
+         * models with blend shapes keep GPU skinning, CPU skinning starts from the bind pose.
+         * @return true if skinOnce applies to the model.
+         */
+        bool usesSkinCache() const;
       private:
         void SetRotation(glm::vec3 &orig, glm::vec3 &dest);
         std::vector<glm::mat4> transforms = {};
 
         std::unique_ptr<Shader> ourShader = nullptr;
+        /// Program drawing skinCache, loaded on first use.
+        std::unique_ptr<Shader> skinnedShader = nullptr;
         glm::vec3 scale = glm::vec3(1.5f, 1.5f, 1.5f);
         glm::quat rotation = glm::quat(glm::vec3(glm::radians(-90.0f), 0.0f, 0.0f));
         glm::quat resultRotation = {};
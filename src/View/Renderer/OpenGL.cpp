@@ -121,7 +121,7 @@ void View::OpenGL::SetupMesh(unsigned int &VAO, unsigned int &VBO, unsigned int
                           reinterpret_cast<void *>(offsetof(Vertex, Bitangent)));
     // BoneID's
     glEnableVertexAttribArray(5);
-    glVertexAttribIPointer(5, 4, GL_INT, sizeof(Vertex),
+    glVertexAttribIPointer(5, 4, GL_UNSIGNED_INT, sizeof(Vertex),
                           reinterpret_cast<void *>(offsetof(Vertex, BoneIDs)));
     //Bone Weights
     glEnableVertexAttribArray(6);
@@ -131,6 +131,153 @@ void View::OpenGL::SetupMesh(unsigned int &VAO, unsigned int &VBO, unsigned int
     glBindVertexArray(0);
 }
 
+void View::OpenGL::SetupPackedMesh(unsigned int &VAO, unsigned int &VBO, unsigned int &EBO,
+                                   const std::vector<PackedVertex> &vertices,
+                                   const std::vector<unsigned int> &indices) {
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+    glGenBuffers(1, &EBO);
+
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(vertices.size() * sizeof(PackedVertex)),
+                 vertices.data(), GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+                 static_cast<GLsizeiptr>(indices.size() * sizeof(unsigned int)), indices.data(),
+                 GL_DYNAMIC_DRAW);
+
+    // vertex Positions
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(PackedVertex),
+                          reinterpret_cast<void *>(offsetof(PackedVertex, Position)));
+    // octahedral normal, decoded by the shader
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, sizeof(PackedVertex),
+                          reinterpret_cast<void *>(offsetof(PackedVertex, Normal)));
+    // half float texture coords
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(PackedVertex),
+                          reinterpret_cast<void *>(offsetof(PackedVertex, TexCoords)));
+    // packed tangent and bitangent sign, unpacked by the shader
+    glEnableVertexAttribArray(7);
+    glVertexAttribIPointer(7, 1, GL_UNSIGNED_INT, sizeof(PackedVertex),
+                           reinterpret_cast<void *>(offsetof(PackedVertex, Tangent)));
+    // BoneID's
+    glEnableVertexAttribArray(5);
+    glVertexAttribIPointer(5, 4, GL_UNSIGNED_BYTE, sizeof(PackedVertex),
+                           reinterpret_cast<void *>(offsetof(PackedVertex, BoneIDs)));
+    // unorm Bone Weights
+    glEnableVertexAttribArray(6);
+    glVertexAttribPointer(6, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(PackedVertex),
+                          reinterpret_cast<void *>(offsetof(PackedVertex, BoneWeight)));
+
+    glBindVertexArray(0);
+}
+
+void View::OpenGL::UpdateMeshVertices(unsigned int VBO, size_t firstVertex,
+                                      const std::vector<PackedVertex> &vertices) {
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferSubData(GL_ARRAY_BUFFER, static_cast<GLintptr>(firstVertex * sizeof(PackedVertex)),
+                    static_cast<GLsizeiptr>(vertices.size() * sizeof(PackedVertex)),
+                    vertices.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void View::OpenGL::UpdateMeshVertices(unsigned int VBO, size_t firstVertex,
+                                      const std::vector<Vertex> &vertices) {
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferSubData(GL_ARRAY_BUFFER, static_cast<GLintptr>(firstVertex * sizeof(Vertex)),
+                    static_cast<GLsizeiptr>(vertices.size() * sizeof(Vertex)), vertices.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+/// Channels of a skinned vertex buffer. skinnedvertshader.vs only places vertices and the
+/// fragment shader is unlit, so the skinned normals are not uploaded.
+static constexpr GLuint SKINNED_CHANNELS = 3;
+
+void View::OpenGL::SetupSkinnedMesh(unsigned int &VAO, unsigned int &VBO, unsigned int meshVBO,
+                                    unsigned int EBO, size_t paddedCount, bool packedLayout) {
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    size_t channel = paddedCount * sizeof(float);
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(channel * SKINNED_CHANNELS), nullptr,
+                 GL_STREAM_DRAW);
+    // position x, y, z, each channel tightly packed
+    for (GLuint attribute = 0; attribute < SKINNED_CHANNELS; ++attribute) {
+        glEnableVertexAttribArray(attribute);
+        glVertexAttribPointer(attribute, 1, GL_FLOAT, GL_FALSE, sizeof(float),
+                              reinterpret_cast<void *>(channel * attribute));
+    }
+    // texture coords stay in the mesh's own buffer
+    glBindBuffer(GL_ARRAY_BUFFER, meshVBO);
+    glEnableVertexAttribArray(6);
+    if (packedLayout) {
+        glVertexAttribPointer(6, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(PackedVertex),
+                              reinterpret_cast<void *>(offsetof(PackedVertex, TexCoords)));
+    } else {
+        glVertexAttribPointer(6, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+                              reinterpret_cast<void *>(offsetof(Vertex, TexCoords)));
+    }
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void View::OpenGL::UpdateSkinnedMesh(unsigned int VBO, const Model::SkinnedVertices &vertices) {
+    const std::vector<float> *channels[SKINNED_CHANNELS] = {
+        &vertices.positionX, &vertices.positionY, &vertices.positionZ};
+    auto channel = static_cast<GLsizeiptr>(vertices.positionX.size() * sizeof(float));
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    // Orphan last pose's storage rather than wait on passes still drawing from it.
+    glBufferData(GL_ARRAY_BUFFER, channel * SKINNED_CHANNELS, nullptr, GL_STREAM_DRAW);
+    for (GLintptr i = 0; i < SKINNED_CHANNELS; ++i) {
+        glBufferSubData(GL_ARRAY_BUFFER, channel * i, channel, channels[i]->data());
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+/**
+ * Fills a buffer texture, creating the buffer and texture on first use.
+ * @param buffer identity of the buffer object.
+ * @param texture identity of the buffer texture.
+ * @param data the texels.
+ * @param size of data in bytes.
+ * @param format texel format of the texture.
+ * @param streamed whether the buffer is refilled every frame.
+ */
+static void fillBufferTexture(unsigned int &buffer, unsigned int &texture, const void *data,
+                              size_t size, GLenum format, bool streamed) {
+    if (buffer == 0) {
+        glGenBuffers(1, &buffer);
+        glGenTextures(1, &texture);
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+    // Respecifying a streamed buffer orphans last frame's storage rather than waiting on draws
+    // still reading it.
+    glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(size), data,
+                 streamed ? GL_STREAM_DRAW : GL_STATIC_DRAW);
+    glBindTexture(GL_TEXTURE_BUFFER, texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, format, buffer);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void View::OpenGL::SetupPaletteBuffer(unsigned int &buffer, unsigned int &texture,
+                                      const std::vector<glm::vec4> &rows, bool streamed) {
+    fillBufferTexture(buffer, texture, rows.data(), rows.size() * sizeof(glm::vec4), GL_RGBA32F,
+                      streamed);
+}
+
+void View::OpenGL::SetupPaletteBuffer(unsigned int &buffer, unsigned int &texture,
+                                      const std::vector<uint32_t> &words,
+                                      Model::PaletteEncoding encoding) {
+    fillBufferTexture(buffer, texture, words.data(), words.size() * sizeof(uint32_t),
+                      Model::isHalfPrecision(encoding) ? GL_RGBA16F : GL_RGBA32F, true);
+}
+
 void View::OpenGL::ResizeWindow() {
     auto &engine = BlueEngine::Engine::get();
     int width = 0, height = 0;
@@ -7,7 +7,9 @@
 #include "Model/Models/DataTypes.hpp"
 #include "Skybox.hpp"
 #include "View/EulerCamera.hpp"
+#include "Model/Models/CpuSkinning.hpp"
 #include "Model/Models/Model.hpp"
+#include "Model/Models/PaletteEncoding.hpp"
 #include "Model/Vertix.hpp"
 
 namespace View {
@@ -47,6 +49,75 @@ namespace View {
          */
         static void SetupMesh(unsigned int &VAO, unsigned int &VBO, unsigned int &EBO,
                        std::vector<Vertex> &vertices, std::vector<unsigned int> &indices);
+        /**
+         * Stores a mesh packed as PackedVertex into OpenGL, attribute locations match
+         * SetupMesh and vertshader.vs rebuilds the inputs when packedVertices is set.
+         * @param VAO The vertex array identity.
+         * @param VBO The vertex buffer identity.
+         * @param EBO The element buffer identity.
+         * @param vertices the packed vertices.
+         * @param indices the indices to be passed into OpenGl.
+         */
+        static void SetupPackedMesh(unsigned int &VAO, unsigned int &VBO, unsigned int &EBO,
+                                    const std::vector<PackedVertex> &vertices,
+                                    const std::vector<unsigned int> &indices);
+        /**
+         * Overwrites a range of a mesh's vertex buffer, for vertices changed after SetupMesh.
+         * @param VBO buffer identity from SetupMesh.
+         * @param firstVertex index of the first vertex to overwrite.
+         * @param vertices the new vertices.
+         */
+        static void UpdateMeshVertices(unsigned int VBO, size_t firstVertex,
+                                       const std::vector<Vertex> &vertices);
+        /**
+         * Overwrites a range of a packed mesh's vertex buffer, see SetupPackedMesh.
+         * @param VBO buffer identity from SetupPackedMesh.
+         * @param firstVertex index of the first vertex to overwrite.
+         * @param vertices the new vertices.
+         */
+        static void UpdateMeshVertices(unsigned int VBO, size_t firstVertex,
+                                       const std::vector<PackedVertex> &vertices);
+        /**
+         * Creates the vertex array drawing a mesh's cached skinned vertices, see SkinCache.
+         * Positions come from a buffer holding the position channels of Model::SkinnedVertices
+         * back to back, one float attribute per axis at locations 0-2. Texture coordinates
+         * (location 6) and indices are read from the mesh.
+         * @param VAO identity of the vertex array, created.
+         * @param VBO identity of the skinned vertex buffer, created.
+         * @param meshVBO vertex buffer of the mesh from SetupMesh.
+         * @param EBO index buffer of the mesh from SetupMesh.
+         * @param paddedCount vertices in each channel, see SkinningSource::getPaddedCount.
+         * @param packedLayout whether meshVBO holds PackedVertex rather than Vertex.
+         */
+        static void SetupSkinnedMesh(unsigned int &VAO, unsigned int &VBO, unsigned int meshVBO,
+                                     unsigned int EBO, size_t paddedCount, bool packedLayout);
+        /**
+         * Replaces the contents of a skinned vertex buffer from SetupSkinnedMesh.
+         * @param VBO identity of the skinned vertex buffer.
+         * @param vertices skinned by the CPU.
+         */
+        static void UpdateSkinnedMesh(unsigned int VBO, const Model::SkinnedVertices &vertices);
+        /**
+         * Uploads a palette stream into a buffer texture of RGBA32F texels, creating the buffer
+         * and texture on first use.
+         * @param buffer identity of the buffer object.
+         * @param texture identity of the buffer texture.
+         * @param rows the texels to upload.
+         * @param streamed whether the buffer is refilled every frame, see PaletteStream.
+         */
+        static void SetupPaletteBuffer(unsigned int &buffer, unsigned int &texture,
+                                       const std::vector<glm::vec4> &rows, bool streamed = false);
+        /**
+         * Uploads an encoded palette stream into a streamed buffer texture, RGBA16F texels for
+         * the half precision encodings and RGBA32F otherwise.
+         * @param buffer identity of the buffer object.
+         * @param texture identity of the buffer texture.
+         * @param words the encoded stream, see PaletteStream::getWords.
+         * @param encoding of the stream.
+         */
+        static void SetupPaletteBuffer(unsigned int &buffer, unsigned int &texture,
+                                       const std::vector<uint32_t> &words,
+                                       Model::PaletteEncoding encoding);
         /**
          * The Resize window function for OpenGL
          */
@@ -0,0 +1,41 @@
+#include "SkinCache.hpp"
+#include <glad/glad.h>
+#include "View/Renderer/OpenGL.hpp"
+
+View::SkinCache::~SkinCache() {
+    if (!vertexArrays.empty()) {
+        glDeleteVertexArrays(static_cast<GLsizei>(vertexArrays.size()), vertexArrays.data());
+        glDeleteBuffers(static_cast<GLsizei>(buffers.size()), buffers.data());
+    }
+}
+
+void View::SkinCache::upload(Model::Model &model,
+                             const std::vector<Model::SkinnedVertices> &vertices,
+                             uint64_t poseVersion) {
+    if (poseVersion == 0 || poseVersion == uploadedVersion ||
+        vertices.size() != model.meshes.size()) {
+        return;
+    }
+    if (vertexArrays.empty()) {
+        vertexArrays.resize(vertices.size());
+        buffers.resize(vertices.size());
+        for (size_t mesh = 0; mesh < vertices.size(); ++mesh) {
+            model.meshes[mesh].SetupSkinnedCache(vertexArrays[mesh], buffers[mesh],
+                                                 vertices[mesh].positionX.size());
+        }
+    }
+    for (size_t mesh = 0; mesh < vertices.size(); ++mesh) {
+        View::OpenGL::UpdateSkinnedMesh(buffers[mesh], vertices[mesh]);
+    }
+    uploadedVersion = poseVersion;
+}
+
+void View::SkinCache::draw(Model::Model &model, Shader &shader) {
+    for (size_t mesh = 0; mesh < vertexArrays.size() && mesh < model.meshes.size(); ++mesh) {
+        model.meshes[mesh].DrawSkinned(shader, vertexArrays[mesh]);
+    }
+}
+
+bool View::SkinCache::isReady() const {
+    return uploadedVersion != 0;
+}
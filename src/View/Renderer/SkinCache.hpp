@@ -0,0 +1,52 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Model/Models/CpuSkinning.hpp"
+#include "Model/Models/Model.hpp"
+#include "View/Renderer/Shader.hpp"
+
+namespace View {
+    /**
+     * GPU copy of one instance's skinned vertices, so every pass of a frame draws the same
+     * posed mesh with a vertex shader that only places it (skinnedvertshader.vs) instead of
+     * skinning each vertex again. The vertices are skinned once per pose by
+     * Controller::SkinningSystem and only uploaded when that pose changes.
+     */
+    class SkinCache {
+      public:
+        SkinCache() = default;
+        /**
+         * Deletes the cache's buffers.
+         */
+        ~SkinCache();
+        SkinCache(const SkinCache &) = delete;
+        SkinCache &operator=(const SkinCache &) = delete;
+
+        /**
+         * Uploads an instance's skinned vertices, unless the cache already holds that pose.
+         * @param model whose meshes were skinned.
+         * @param vertices one buffer per mesh, see SkinningSystem::getVertices.
+         * @param poseVersion pose they were skinned with, see SkinningSystem::getPoseVersion.
+         */
+        void upload(Model::Model &model, const std::vector<Model::SkinnedVertices> &vertices,
+                    uint64_t poseVersion);
+        /**
+         * Draws every mesh of the model from the cache.
+         * @param model the cache was uploaded for.
+         * @param shader a program built from skinnedvertshader.vs.
+         */
+        void draw(Model::Model &model, Shader &shader);
+        /**
+         * Whether a pose has been uploaded.
+         * @return true if draw can be used.
+         */
+        bool isReady() const;
+
+      private:
+        /// One vertex array and skinned buffer per mesh.
+        std::vector<unsigned int> vertexArrays = {};
+        std::vector<unsigned int> buffers = {};
+        /// Pose the buffers hold, 0 before the first upload.
+        uint64_t uploadedVersion = 0;
+    };
+}
@@ -0,0 +1,165 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <sstream>
+#include <vector>
+#include "Model/Models/Animation.hpp"
+#include "Model/Models/ResampledAnimation.hpp"
+#include "SyntheticRig.hpp"
+
+namespace {
+    /// Largest difference allowed between a resampled clip and its source tracks.
+    constexpr float TOLERANCE = 1e-4f;
+    constexpr size_t JOINT_COUNT = 24;
+
+    int failures = 0;
+
+    void expectNear(const char *check, double time, size_t joint, const float *sampled,
+                    const float *reference, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            if (!(std::abs(sampled[i] - reference[i]) <= TOLERANCE)) {
+                std::printf("%s: joint %zu at %.3f s component %zu is %g, reference %g\n", check,
+                            joint, time, i, static_cast<double>(sampled[i]),
+                            static_cast<double>(reference[i]));
+                ++failures;
+                return;
+            }
+        }
+    }
+
+    /**
+     * Samples a clip from its source tracks and from a resampled copy at the key times, where
+     * both representations hold the same values, and compares every joint.
+     */
+    void compareResampled(const char *check, const Model::Skeleton &skeleton,
+                          const Model::Animation &clip, double rate) {
+        Model::Animation resampled = clip;
+        resampled.resample(skeleton.size(), rate, 16);
+        std::vector<Model::TrackCursor> cursors = {};
+        auto frames = static_cast<size_t>(std::ceil(clip.getLength() * rate));
+        for (size_t frame = 0; frame <= frames; ++frame) {
+            double time = std::min(static_cast<double>(frame) / rate, clip.getLength());
+            Model::Pose reference = clip.getRestPose(skeleton);
+            Model::Pose pose      = reference;
+            clip.sampleSource(time, cursors, reference);
+            if (!resampled.sample(time, cursors, pose)) {
+                std::printf("%s: nothing sampled at %.3f s\n", check, time);
+                ++failures;
+                return;
+            }
+            for (size_t joint = 0; joint < skeleton.size(); ++joint) {
+                expectNear(check, time, joint, &pose.translations[joint].x,
+                           &reference.translations[joint].x, 3);
+                // q and -q are the same rotation.
+                glm::quat rotation = pose.rotations[joint];
+                if (glm::dot(rotation, reference.rotations[joint]) < 0.0f) {
+                    rotation = -rotation;
+                }
+                expectNear(check, time, joint, &rotation.x, &reference.rotations[joint].x, 4);
+            }
+        }
+    }
+
+    /**
+     * Checks that joints whose translation static joint elimination moved into the rest pose
+     * keep it once the clip is resampled.
+     */
+    void testRestPoseChannels() {
+        auto skeleton = Synthetic::makeSkeleton(JOINT_COUNT);
+        auto clip     = Synthetic::makeClip(*skeleton, 1.0, 1.0f);
+        // Odd joints only rotate, their translation stays at the bind offset.
+        for (auto &track : clip.tracks) {
+            if (track.joint % 2 == 1) {
+                std::fill(track.positions.begin(), track.positions.end(),
+                          skeleton->bindPose.translations[track.joint]);
+            }
+        }
+        clip.eliminateStaticJoints(*skeleton);
+        compareResampled("rest pose channels", *skeleton, clip, 30.0);
+    }
+
+    /**
+     * Checks that a clip static joint elimination emptied still samples once resampled.
+     */
+    void testStaticClip() {
+        auto skeleton = Synthetic::makeSkeleton(JOINT_COUNT);
+        auto clip     = Synthetic::makeClip(*skeleton, 1.0, 0.0f);
+        for (auto &track : clip.tracks) {
+            std::fill(track.positions.begin(), track.positions.end(),
+                      skeleton->bindPose.translations[track.joint]);
+            std::fill(track.rotations.begin(), track.rotations.end(), glm::quat(1, 0, 0, 0));
+        }
+        clip.eliminateStaticJoints(*skeleton);
+        if (!clip.getTracks().empty()) {
+            std::printf("static clip: %zu tracks left\n", clip.getTracks().size());
+            ++failures;
+        }
+        compareResampled("static clip", *skeleton, clip, 30.0);
+    }
+
+    /**
+     * Checks a clip whose length is not a whole number of frames, so the last resampled segment
+     * is shorter than the others and ends on a closing key at the clip length.
+     */
+    void testPartialLastFrame() {
+        constexpr double LENGTH = 1.01;
+        auto skeleton = Synthetic::makeSkeleton(JOINT_COUNT);
+        auto clip     = Synthetic::makeClip(*skeleton, LENGTH, 1.0f);
+        for (auto &track : clip.tracks) {
+            track.positionTimes.push_back(LENGTH);
+            track.positions.push_back(skeleton->bindPose.translations[track.joint]);
+            track.rotationTimes.push_back(LENGTH);
+            track.rotations.push_back(glm::angleAxis(0.5f, glm::vec3(1.0f, 0.0f, 0.0f)));
+        }
+        compareResampled("partial last frame", *skeleton, clip, 30.0);
+    }
+
+    /**
+     * Checks that a resampled clip written out and streamed back samples the same poses, and
+     * that joints outside a mask are left untouched.
+     */
+    void testRoundTrip() {
+        auto skeleton = Synthetic::makeSkeleton(JOINT_COUNT);
+        auto clip     = Synthetic::makeClip(*skeleton, 1.0, 1.0f);
+        Model::ResampledAnimation resampled(clip, skeleton->size(), 30.0, 8);
+        auto stream = std::make_shared<std::stringstream>();
+        resampled.write(*stream);
+        auto opened = Model::ResampledAnimation::open(stream);
+        opened.stream(0.0, opened.length);
+        std::vector<uint8_t> mask(skeleton->size());
+        for (size_t joint = 0; joint < mask.size(); ++joint) {
+            mask[joint] = joint % 5 != 3;
+        }
+        const Model::Pose untouched(skeleton->size());
+        for (double time = 0.0; time <= clip.getLength(); time += 0.07) {
+            Model::Pose reference(skeleton->size());
+            Model::Pose pose(skeleton->size());
+            if (!resampled.sample(time, reference) || !opened.sample(time, pose, mask.data())) {
+                std::printf("round trip: nothing sampled at %.3f s\n", time);
+                ++failures;
+                return;
+            }
+            for (size_t joint = 0; joint < skeleton->size(); ++joint) {
+                const Model::Pose &expected = mask[joint] != 0 ? reference : untouched;
+                expectNear("round trip", time, joint, &pose.translations[joint].x,
+                           &expected.translations[joint].x, 3);
+                expectNear("round trip", time, joint, &pose.rotations[joint].x,
+                           &expected.rotations[joint].x, 4);
+            }
+        }
+    }
+}
+
+/**
+ * Checks that resampling a clip does not change what it samples.
+ */
+int main() {
+    testRestPoseChannels();
+    testStaticClip();
+    testPartialLastFrame();
+    testRoundTrip();
+    std::printf("Animation sampling: %d mismatches\n", failures);
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
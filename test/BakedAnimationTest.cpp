@@ -0,0 +1,113 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "Controller/Animator.hpp"
+#include "Model/Models/BakedAnimation.hpp"
+#include "SyntheticRig.hpp"
+
+namespace {
+    /// Largest difference allowed between a baked palette and the animator's.
+    constexpr float TOLERANCE = 1e-4f;
+    constexpr size_t JOINT_COUNT = 24;
+    constexpr float RATE = 30.0f;
+
+    int failures = 0;
+
+    /**
+     * Plays a clip through an Animator one baked frame per tick, past the end of the clip so it
+     * loops, and checks every palette against BakedAnimation::samplePalette at the same time.
+     */
+    void compareWithAnimator(double length) {
+        auto skeleton = Synthetic::makeSkeleton(JOINT_COUNT);
+        std::vector<Model::Animation> clips = {Synthetic::makeClip(*skeleton, length, 1.0f)};
+        Model::BakedAnimation baked(*skeleton, clips, RATE);
+
+        Controller::Animator animator = {};
+        animator.skeleton    = skeleton;
+        animator.currentPose = Model::Pose(skeleton->size());
+        animator.modelTransforms.assign(skeleton->size(), glm::mat4(1.0f));
+        animator.jointTransforms.assign(skeleton->getBoneCount(), glm::mat4(1.0f));
+        animator.queAnimation(&clips[0]);
+
+        std::vector<glm::mat4> palette = {};
+        auto ticks = static_cast<size_t>(2.5 * length * RATE);
+        for (size_t tick = 0; tick < ticks; ++tick) {
+            animator.update(0.0, 1.0 / RATE);
+            double time = animator.animationTime;
+            baked.samplePalette(0, time, palette);
+            const auto &reference = animator.getJointTransforms();
+            float difference = 0.0f;
+            for (size_t bone = 0; bone < palette.size(); ++bone) {
+                for (int column = 0; column < 4; ++column) {
+                    for (int row = 0; row < 4; ++row) {
+                        difference = std::max(difference, std::abs(palette[bone][column][row] -
+                                                                   reference[bone][column][row]));
+                    }
+                }
+            }
+            if (!(difference <= TOLERANCE)) {
+                std::printf("%.3f s clip: palette at %.4f s differs by %g\n", length, time,
+                            static_cast<double>(difference));
+                ++failures;
+                return;
+            }
+        }
+    }
+
+    /**
+     * Checks that a clip whose length is not a whole number of frames reaches its closing frame
+     * at the end of the clip, and passes halfway between the last two frames halfway through
+     * the shorter last segment.
+     */
+    void testLastSegment(double length) {
+        auto skeleton = Synthetic::makeSkeleton(JOINT_COUNT);
+        auto clip     = Synthetic::makeClip(*skeleton, length, 1.0f);
+        // A closing key at the clip length makes the last segment move.
+        for (auto &track : clip.tracks) {
+            track.positionTimes.push_back(length);
+            track.positions.push_back(skeleton->bindPose.translations[track.joint]);
+            track.rotationTimes.push_back(length);
+            track.rotations.push_back(glm::angleAxis(0.5f, glm::vec3(1.0f, 0.0f, 0.0f)));
+        }
+        std::vector<Model::Animation> clips = {clip};
+        Model::BakedAnimation baked(*skeleton, clips, RATE);
+        size_t last = baked.getClip(0).frameCount - 1;
+        double lastStart = static_cast<double>(last - 1) / RATE;
+
+        std::vector<glm::mat4> palette = {};
+        for (double fraction : {0.5, 0.99999}) {
+            double time = lastStart + (length - lastStart) * fraction;
+            baked.samplePalette(0, time, palette);
+            auto weight = static_cast<float>(fraction);
+            float difference = 0.0f;
+            for (size_t bone = 0; bone < palette.size(); ++bone) {
+                glm::mat4 expected = baked.getBoneTransform(0, last - 1, bone) * (1.0f - weight) +
+                                     baked.getBoneTransform(0, last, bone) * weight;
+                for (int column = 0; column < 4; ++column) {
+                    for (int row = 0; row < 4; ++row) {
+                        difference = std::max(difference, std::abs(palette[bone][column][row] -
+                                                                   expected[column][row]));
+                    }
+                }
+            }
+            if (!(difference <= TOLERANCE)) {
+                std::printf("%.3f s clip: last segment at %.4f s differs by %g\n", length, time,
+                            static_cast<double>(difference));
+                ++failures;
+            }
+        }
+    }
+}
+
+/**
+ * Checks that baked palettes match what an Animator computes for the same clip, without a
+ * graphics context.
+ */
+int main() {
+    compareWithAnimator(1.0);
+    testLastSegment(1.01);
+    std::printf("Baked animation: %d mismatches\n", failures);
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
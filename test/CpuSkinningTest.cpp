@@ -0,0 +1,145 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include "Model/Models/CpuSkinning.hpp"
+#include "Model/Models/SimdLanes.hpp"
+
+namespace {
+    /// Largest difference allowed between skinVertices and the per vertex glm skinning.
+    constexpr float TOLERANCE = 1e-5f;
+    constexpr size_t BONE_COUNT = 40;
+
+    int failures = 0;
+
+    void expectNear(const char *channel, size_t vertex, float skinned, float reference) {
+        float scale = std::max(1.0f, std::abs(reference));
+        if (!(std::abs(skinned - reference) <= TOLERANCE * scale)) {
+            std::printf("%s: vertex %zu is %g, reference %g\n", channel, vertex,
+                        static_cast<double>(skinned), static_cast<double>(reference));
+            ++failures;
+        }
+    }
+
+    /**
+     * Random bone transforms with rotation, translation and some non uniform scale, like a
+     * palette that squashes and stretches.
+     */
+    std::vector<glm::mat4> makePalette(std::mt19937 &random) {
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        std::uniform_real_distribution<float> scale(0.5f, 1.5f);
+        std::vector<glm::mat4> palette(BONE_COUNT);
+        for (auto &bone : palette) {
+            glm::quat rotation = glm::normalize(
+                glm::quat(unit(random), unit(random), unit(random), unit(random)));
+            bone = glm::translate(glm::mat4(1.0f),
+                                  glm::vec3(unit(random), unit(random), unit(random)) * 5.0f) *
+                   glm::mat4_cast(rotation) *
+                   glm::scale(glm::mat4(1.0f), glm::vec3(scale(random), scale(random), 1.0f));
+        }
+        return palette;
+    }
+
+    /**
+     * Random vertices with one to four influences whose weights sum to one. Every seventh
+     * vertex has no normal.
+     */
+    std::vector<Vertex> makeVertices(std::mt19937 &random, size_t count) {
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        std::uniform_real_distribution<float> weight(0.05f, 1.0f);
+        std::vector<Vertex> vertices(count);
+        for (size_t i = 0; i < count; ++i) {
+            auto &vertex = vertices[i];
+            vertex.Position = glm::vec3(unit(random), unit(random), unit(random)) * 2.0f;
+            if (i % 7 != 6) {
+                vertex.Normal = glm::normalize(glm::vec3(unit(random), unit(random), 0.5f));
+            }
+            size_t influences = 1 + random() % NUM_BONES_PER_VEREX;
+            float total = 0.0f;
+            for (size_t influence = 0; influence < influences; ++influence) {
+                auto index = static_cast<glm::length_t>(influence);
+                vertex.BoneIDs[index]    = static_cast<int>(random() % BONE_COUNT);
+                vertex.BoneWeight[index] = weight(random);
+                total += vertex.BoneWeight[index];
+            }
+            vertex.BoneWeight /= total;
+        }
+        return vertices;
+    }
+
+    /**
+     * Skins one vertex with glm, the way the vertex shader does.
+     */
+    void skinVertex(const Vertex &vertex, const std::vector<glm::mat4> &palette,
+                    glm::vec3 &position, glm::vec3 &normal) {
+        glm::mat4 blended(0.0f);
+        for (glm::length_t influence = 0; influence < 4; ++influence) {
+            blended += palette[static_cast<size_t>(vertex.BoneIDs[influence])] *
+                       vertex.BoneWeight[influence];
+        }
+        position = glm::vec3(blended * glm::vec4(vertex.Position, 1.0f));
+        normal   = glm::mat3(blended) * vertex.Normal;
+        float length = glm::length(normal);
+        normal = length > 0.0f ? normal / length : glm::vec3(0.0f);
+    }
+
+    void compare(const std::vector<Vertex> &vertices, const std::vector<glm::mat4> &palette,
+                 const Model::SkinnedVertices &skinned) {
+        for (size_t i = 0; i < vertices.size(); ++i) {
+            glm::vec3 position, normal;
+            skinVertex(vertices[i], palette, position, normal);
+            expectNear("position x", i, skinned.positionX[i], position.x);
+            expectNear("position y", i, skinned.positionY[i], position.y);
+            expectNear("position z", i, skinned.positionZ[i], position.z);
+            expectNear("normal x", i, skinned.normalX[i], normal.x);
+            expectNear("normal y", i, skinned.normalY[i], normal.y);
+            expectNear("normal z", i, skinned.normalZ[i], normal.z);
+        }
+    }
+
+    /**
+     * Skins a mesh in one call and again in ranges of Simd::MAX_WIDTH vertices, the way
+     * SkinningSystem splits meshes into jobs, and compares both with glm.
+     */
+    void testMesh(std::mt19937 &random, size_t vertexCount) {
+        auto palette  = makePalette(random);
+        auto vertices = makeVertices(random, vertexCount);
+        auto source   = Model::SkinningSource::fromVertices(vertices);
+
+        Model::SkinnedVertices whole = {};
+        whole.allocate(source);
+        Model::skinVertices(source, palette, 0, vertexCount, whole);
+        compare(vertices, palette, whole);
+
+        Model::SkinnedVertices ranges = {};
+        ranges.allocate(source);
+        for (size_t first = 0; first < vertexCount; first += Model::Simd::MAX_WIDTH) {
+            Model::skinVertices(source, palette, first, first + Model::Simd::MAX_WIDTH, ranges);
+        }
+        compare(vertices, palette, ranges);
+    }
+}
+
+/**
+ * Checks skinVertices against per vertex glm skinning, at vertex counts that leave a remainder
+ * for both the 4 and the 8 wide paths.
+ */
+int main() {
+    std::mt19937 random(11);
+    for (size_t count : {1u, 3u, 4u, 7u, 8u, 9u, 17u, 64u, 1001u}) {
+        testMesh(random, count);
+    }
+#if ANIMTEST_AVX2_KERNELS
+    const char *path = "AVX2";
+#elif ANIMTEST_SSE_KERNELS
+    const char *path = "SSE";
+#else
+    const char *path = "scalar";
+#endif
+    std::printf("CPU skinning (%s): %d mismatches\n", path, failures);
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,107 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include "Controller/FixedRig.hpp"
+#include "SyntheticRig.hpp"
+
+namespace {
+    constexpr size_t POSES   = 64;
+    constexpr size_t REPEATS = 2000;
+    /// Largest difference allowed between a FixedRig palette entry and the generic one.
+    constexpr float TOLERANCE = 1e-5f;
+
+    template <size_t JointCount>
+    struct SyntheticLayout {
+        static constexpr std::array<int, JointCount> parents =
+            Synthetic::makeParents<JointCount>();
+    };
+
+    /**
+     * Random poses of a skeleton, rotations anywhere and translations near the bind pose.
+     */
+    std::vector<Model::Pose> makePoses(const Model::Skeleton &skeleton, bool moveTranslations) {
+        std::mt19937 random(3);
+        std::uniform_real_distribution<float> angle(-1.0f, 1.0f);
+        std::vector<Model::Pose> poses(POSES, skeleton.bindPose);
+        for (auto &pose : poses) {
+            for (size_t joint = 0; joint < pose.size(); ++joint) {
+                glm::vec3 axis(angle(random), angle(random), angle(random) + 2.0f);
+                pose.rotations[joint] = glm::angleAxis(angle(random), glm::normalize(axis));
+                if (moveTranslations || skeleton.parents[joint] < 0) {
+                    pose.translations[joint] +=
+                        0.05f * glm::vec3(angle(random), angle(random), angle(random));
+                }
+            }
+        }
+        return poses;
+    }
+
+    float largestDifference(const std::vector<glm::mat4> &a, const std::vector<glm::mat4> &b) {
+        float difference = 0.0f;
+        for (size_t i = 0; i < a.size(); ++i) {
+            for (int column = 0; column < 4; ++column) {
+                for (int row = 0; row < 4; ++row) {
+                    difference =
+                        std::max(difference, std::abs(a[i][column][row] - b[i][column][row]));
+                }
+            }
+        }
+        return difference;
+    }
+
+    /**
+     * Times the generic Skeleton path against a FixedRig on the same poses and checks both
+     * build the same palette.
+     * @return false if the palettes differ.
+     */
+    template <size_t JointCount, Controller::RigChannels Channels>
+    bool compare(const char *name) {
+        auto skeleton = Synthetic::makeSkeleton(JointCount);
+        auto rig = Controller::FixedRig<SyntheticLayout<JointCount>, Channels>::create(*skeleton,
+                                                                                      {});
+        if (!rig) {
+            std::printf("%s: the layout does not match the skeleton\n", name);
+            return false;
+        }
+        auto poses = makePoses(*skeleton, Channels == Controller::RigChannels::ALL);
+        std::vector<glm::mat4> modelTransforms(skeleton->size()), palette(skeleton->getBoneCount());
+        std::vector<glm::mat4> rigModelTransforms = modelTransforms, rigPalette = palette;
+
+        float difference = 0.0f;
+        for (const auto &pose : poses) {
+            skeleton->localToModel(pose, modelTransforms);
+            skeleton->buildPalette(modelTransforms, palette);
+            rig->evaluate(pose, rigModelTransforms, rigPalette);
+            difference = std::max(difference, largestDifference(palette, rigPalette));
+        }
+
+        double generic = Synthetic::microsecondsPerCall(REPEATS, [&](size_t i) {
+            skeleton->localToModel(poses[i % POSES], modelTransforms);
+            skeleton->buildPalette(modelTransforms, palette);
+        });
+        double fixed = Synthetic::microsecondsPerCall(REPEATS, [&](size_t i) {
+            rig->evaluate(poses[i % POSES], rigModelTransforms, rigPalette);
+        });
+        std::printf("%-22s %3zu joints: generic %6.2f us, FixedRig %6.2f us, %.2fx, "
+                    "largest difference %.1e\n",
+                    name, JointCount, generic, fixed, generic / fixed,
+                    static_cast<double>(difference));
+        return difference <= TOLERANCE;
+    }
+}
+
+/**
+ * Cost of building a palette through FixedRig against the generic Skeleton path on synthetic
+ * rigs, and a check that both produce the same palette.
+ */
+int main() {
+    bool same = true;
+    same &= compare<24, Controller::RigChannels::ALL>("ALL");
+    same &= compare<64, Controller::RigChannels::ALL>("ALL");
+    same &= compare<24, Controller::RigChannels::ROTATIONS_AND_ROOT>("ROTATIONS_AND_ROOT");
+    same &= compare<64, Controller::RigChannels::ROTATIONS_AND_ROOT>("ROTATIONS_AND_ROOT");
+    return same ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,162 @@
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <vector>
+#include "Controller/IkSystem.hpp"
+#include "SyntheticRig.hpp"
+
+namespace {
+    constexpr size_t REPEATS = 200;
+    /// Joints of the FABRIK chains, a tail or an arm.
+    constexpr size_t CHAIN_JOINTS = 4;
+    constexpr size_t FABRIK_ITERATIONS = 8;
+
+    struct Leg {
+        glm::vec3 root, mid, end, target, pole;
+    };
+
+    std::vector<Leg> makeLegs(std::mt19937 &random, size_t count) {
+        std::uniform_real_distribution<float> offset(-0.2f, 0.2f);
+        std::vector<Leg> legs(count);
+        for (auto &leg : legs) {
+            leg.root   = glm::vec3(offset(random), 1.0f, offset(random));
+            leg.mid    = leg.root + glm::vec3(0.0f, -0.5f, 0.05f);
+            leg.end    = leg.mid + glm::vec3(0.0f, -0.5f, -0.05f);
+            leg.target = leg.end + glm::vec3(offset(random), offset(random), offset(random));
+            leg.pole   = leg.mid + glm::vec3(0.0f, 0.0f, 1.0f);
+        }
+        return legs;
+    }
+
+    std::vector<glm::vec3> makeChains(std::mt19937 &random, size_t count) {
+        std::uniform_real_distribution<float> offset(-0.3f, 0.3f);
+        std::vector<glm::vec3> positions(count * (CHAIN_JOINTS + 1));
+        for (size_t chain = 0; chain < count; ++chain) {
+            glm::vec3 *chainPositions = &positions[chain * (CHAIN_JOINTS + 1)];
+            for (size_t joint = 0; joint < CHAIN_JOINTS; ++joint) {
+                chainPositions[joint] = glm::vec3(0.0f, 0.25f * static_cast<float>(joint), 0.0f);
+            }
+            // The last entry is the target.
+            chainPositions[CHAIN_JOINTS] = glm::vec3(offset(random), 0.6f, offset(random));
+        }
+        return positions;
+    }
+
+    /**
+     * Prints the throughput of solving every problem in one batch, and of solving each one on
+     * its own as a per character solver would.
+     */
+    void report(const char *solver, size_t count, double batched, double single) {
+        std::printf("%-8s %5zu chains: batched %6.2f M/s, one at a time %6.2f M/s, %.1fx\n",
+                    solver, count, static_cast<double>(count) / batched,
+                    static_cast<double>(count) / single, single / batched);
+    }
+
+    void benchmarkTwoBone(std::mt19937 &random, size_t count) {
+        auto legs = makeLegs(random, count);
+        Controller::TwoBoneIkBatch batch = {};
+        double batched = Synthetic::microsecondsPerCall(REPEATS, [&](size_t) {
+            batch.clear();
+            for (const auto &leg : legs) {
+                batch.add(leg.root, leg.mid, leg.end, leg.target, leg.pole);
+            }
+            batch.solve();
+        });
+        double single = Synthetic::microsecondsPerCall(REPEATS, [&](size_t) {
+            for (const auto &leg : legs) {
+                batch.clear();
+                batch.add(leg.root, leg.mid, leg.end, leg.target, leg.pole);
+                batch.solve();
+            }
+        });
+        report("two-bone", count, batched, single);
+    }
+
+    void benchmarkFabrik(std::mt19937 &random, size_t count) {
+        auto positions = makeChains(random, count);
+        Controller::FabrikBatch batch(CHAIN_JOINTS);
+        double batched = Synthetic::microsecondsPerCall(REPEATS, [&](size_t) {
+            batch.clear();
+            for (size_t chain = 0; chain < count; ++chain) {
+                const glm::vec3 *chainPositions = &positions[chain * (CHAIN_JOINTS + 1)];
+                batch.add(chainPositions, chainPositions[CHAIN_JOINTS]);
+            }
+            batch.solve(FABRIK_ITERATIONS);
+        });
+        double single = Synthetic::microsecondsPerCall(REPEATS, [&](size_t) {
+            for (size_t chain = 0; chain < count; ++chain) {
+                const glm::vec3 *chainPositions = &positions[chain * (CHAIN_JOINTS + 1)];
+                batch.clear();
+                batch.add(chainPositions, chainPositions[CHAIN_JOINTS]);
+                batch.solve(FABRIK_ITERATIONS);
+            }
+        });
+        report("FABRIK", count, batched, single);
+    }
+
+    /**
+     * Runs IkSystem over a crowd, two legs and one FABRIK chain per character, including
+     * reading the animators' transforms and writing their palettes.
+     */
+    void benchmarkSystem(size_t characterCount) {
+        auto skeleton = Synthetic::makeSkeleton(24);
+        auto clip     = Synthetic::makeClip(*skeleton, 1.0, 1.0f);
+        Controller::IkSystem system = {};
+        std::vector<std::shared_ptr<Controller::Animator>> animators = {};
+        for (size_t i = 0; i < characterCount; ++i) {
+            auto animator = std::make_shared<Controller::Animator>();
+            animator->skeleton    = skeleton;
+            animator->currentPose = Model::Pose(skeleton->size());
+            animator->modelTransforms.assign(skeleton->size(), glm::mat4(1.0f));
+            animator->jointTransforms.assign(skeleton->getBoneCount(), glm::mat4(1.0f));
+            animator->queAnimation(&clip);
+            size_t character = system.addCharacter(animator);
+            system.setWorldTransform(character,
+                                     glm::translate(glm::mat4(1.0f),
+                                                    glm::vec3(static_cast<float>(i), 0.0f, 0.0f)));
+            // Limbs of the synthetic rig hang off the spine, see Synthetic::makeSkeleton.
+            system.setPelvis(character, 0);
+            system.addLeg(character, 4, 5, 6, glm::vec3(0.0f, 0.0f, 1.0f));
+            system.addLeg(character, 8, 9, 10, glm::vec3(0.0f, 0.0f, 1.0f));
+            system.addChain(character, {12, 13, 14, 15});
+            animators.push_back(std::move(animator));
+        }
+        auto ground = [](float x, float z) { return 0.2f * std::sin(x) * std::cos(z); };
+        double solveTime  = 0.0;
+        double updateTime = 0.0;
+        for (size_t i = 0; i < REPEATS; ++i) {
+            for (auto &animator : animators) {
+                animator->update(0.0, 1.0 / 60.0);
+            }
+            system.update(ground);
+            solveTime  += system.getStats().solveTime;
+            updateTime += system.getStats().updateTime;
+        }
+        double chains = static_cast<double>(system.getStats().twoBoneChains +
+                                            system.getStats().fabrikChains);
+        std::printf("IkSystem %5zu characters: %7.1f us per update, %.1f us solving, "
+                    "%.2f M chains/s\n",
+                    characterCount, updateTime * 1e6 / REPEATS, solveTime * 1e6 / REPEATS,
+                    chains * REPEATS / updateTime * 1e-6);
+    }
+}
+
+/**
+ * Throughput of the batched IK solvers against solving one chain at a time, and of a whole
+ * IkSystem update over a crowd.
+ */
+int main() {
+    std::mt19937 random(5);
+    for (size_t count : {16u, 256u, 4096u}) {
+        benchmarkTwoBone(random, count);
+    }
+    for (size_t count : {16u, 256u, 4096u}) {
+        benchmarkFabrik(random, count);
+    }
+    for (size_t count : {64u, 512u}) {
+        benchmarkSystem(count);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,75 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "Model/Models/Animation.hpp"
+#include "Model/Models/KeyReduction.hpp"
+#include "Model/Models/PoseKernels.hpp"
+#include "SyntheticRig.hpp"
+
+namespace {
+    constexpr size_t JOINT_COUNT = 24;
+    /// Largest end effector drift the reduction is given, in model units.
+    constexpr float POSITION_TOLERANCE = 0.01f;
+    constexpr float ANGLE_TOLERANCE    = 0.05f;
+    /// Rate the reduced clip is checked at, finer than its keys so drift between keys shows.
+    constexpr double CHECK_RATE = 240.0;
+
+    std::vector<glm::vec3> modelPositions(const Model::Skeleton &skeleton,
+                                          const Model::Animation &clip, double time) {
+        std::vector<Model::TrackCursor> cursors = {};
+        Model::Pose pose = clip.getRestPose(skeleton);
+        clip.sampleSource(time, cursors, pose);
+        std::vector<glm::mat4> transforms(skeleton.size());
+        Model::Kernels::Scalar::composeTransforms(pose.translations.data(), pose.rotations.data(),
+                                                  skeleton.size(), transforms.data());
+        Model::Kernels::Scalar::localToModel(skeleton.parents.data(), transforms.data(),
+                                             skeleton.size());
+        std::vector<glm::vec3> positions(skeleton.size());
+        for (size_t joint = 0; joint < skeleton.size(); ++joint) {
+            positions[joint] = glm::vec3(transforms[joint][3]);
+        }
+        return positions;
+    }
+}
+
+/**
+ * Reduces the keys of a clip and checks that no joint of the posed skeleton drifts further
+ * than the position tolerance, even at the end of the longest chain.
+ */
+int main() {
+    auto skeleton = Synthetic::makeSkeleton(JOINT_COUNT);
+    auto clip     = Synthetic::makeClip(*skeleton, 2.0, 0.5f);
+    Model::Animation reduced = clip;
+    auto reach        = skeleton->calculateJointReach();
+    auto chainLengths = skeleton->calculateChainLengths();
+    for (auto &track : reduced.tracks) {
+        Model::reduceKeys(track, POSITION_TOLERANCE, ANGLE_TOLERANCE, reach[track.joint],
+                          chainLengths[track.joint]);
+    }
+
+    int failures = 0;
+    if (reduced.getKeyCount() >= clip.getKeyCount()) {
+        std::printf("no keys removed from %zu\n", clip.getKeyCount());
+        ++failures;
+    }
+    float maxDrift = 0.0f;
+    auto checks = static_cast<size_t>(clip.getLength() * CHECK_RATE);
+    for (size_t check = 0; check <= checks; ++check) {
+        double time    = static_cast<double>(check) / CHECK_RATE;
+        auto source    = modelPositions(*skeleton, clip, time);
+        auto candidate = modelPositions(*skeleton, reduced, time);
+        for (size_t joint = 0; joint < skeleton->size(); ++joint) {
+            maxDrift = std::max(maxDrift, glm::distance(source[joint], candidate[joint]));
+        }
+    }
+    if (!(maxDrift <= POSITION_TOLERANCE)) {
+        std::printf("end effector drift %g exceeds %g\n", static_cast<double>(maxDrift),
+                    static_cast<double>(POSITION_TOLERANCE));
+        ++failures;
+    }
+    std::printf("Key reduction: %zu -> %zu keys, max drift %g\n", clip.getKeyCount(),
+                reduced.getKeyCount(), static_cast<double>(maxDrift));
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,76 @@
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include "Controller/Animator.hpp"
+#include "SyntheticRig.hpp"
+
+namespace {
+    /// Heap allocations made since the program started, to check steady state playback.
+    std::atomic<size_t> allocations = {0};
+
+    constexpr size_t JOINT_COUNT = 80;
+    constexpr size_t UPDATES     = 20000;
+    constexpr double TICK        = 1.0 / 60.0;
+}
+
+void *operator new(size_t size) {
+    ++allocations;
+    if (void *memory = std::malloc(size == 0 ? 1 : size)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void *memory, size_t) noexcept {
+    std::free(memory);
+}
+
+/**
+ * Times Animator::update playing one clip and then with one to MAX_LAYERS layers blended over
+ * it, half of them masked to the upper body. The cost of each layer should stay about the
+ * same as the base clip's sampling cost, and steady state playback should not allocate.
+ */
+int main() {
+    auto skeleton = Synthetic::makeSkeleton(JOINT_COUNT);
+    std::vector<Model::Animation> clips = {};
+    for (size_t i = 0; i <= Controller::Animator::MAX_LAYERS; ++i) {
+        clips.push_back(Synthetic::makeClip(*skeleton, 1.0 + 0.25 * static_cast<double>(i),
+                                            1.0f + static_cast<float>(i)));
+    }
+    std::vector<float> upperBody = skeleton->buildSubtreeMask(1);
+
+    std::printf("%zu joints, %zu updates per run\n", JOINT_COUNT, UPDATES);
+    double baseline = 0.0;
+    int failures = 0;
+    for (size_t layerCount = 0; layerCount <= Controller::Animator::MAX_LAYERS; ++layerCount) {
+        Controller::Animator animator = {};
+        animator.skeleton = skeleton;
+        animator.currentPose = Model::Pose(JOINT_COUNT);
+        animator.modelTransforms.assign(JOINT_COUNT, glm::mat4(1.0f));
+        animator.jointTransforms.assign(skeleton->getBoneCount(), glm::mat4(1.0f));
+        animator.queAnimation(&clips[0]);
+        for (size_t i = 1; i <= layerCount; ++i) {
+            animator.addLayer(&clips[i], 0.5f, i % 2 == 0 ? upperBody.data() : nullptr);
+        }
+        // Warm up so the layers' buffers and the cursors are sized.
+        for (size_t i = 0; i < 60; ++i) {
+            animator.update(0.0, TICK);
+        }
+        size_t allocationsBefore = allocations;
+        double time = Synthetic::microsecondsPerCall(
+            UPDATES, [&animator](size_t) { animator.update(0.0, TICK); });
+        size_t allocated = allocations - allocationsBefore;
+        if (layerCount == 0) {
+            baseline = time;
+        }
+        std::printf("%zu layers: %7.2f us per update, %.2fx single clip, %zu allocations\n",
+                    layerCount, time, time / baseline, allocated);
+        failures += allocated == 0 ? 0 : 1;
+    }
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
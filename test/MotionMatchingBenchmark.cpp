@@ -0,0 +1,75 @@
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include "Model/Models/MotionDatabase.hpp"
+#include "SyntheticRig.hpp"
+
+namespace {
+    /// Budget of one search per character.
+    constexpr double BUDGET_MICROSECONDS = 100.0;
+    constexpr size_t JOINT_COUNT = 40;
+    /// 50 clips of 10 seconds at 30 frames per second.
+    constexpr size_t CLIP_COUNT  = 50;
+    constexpr double CLIP_LENGTH = 10.0;
+    constexpr size_t QUERIES     = 2000;
+}
+
+/**
+ * Times both MotionDatabase searches on a 15000 frame, 30 feature database, the size of a
+ * locomotion set, and checks that they find frames of the same cost. Like a query built from
+ * the playing pose and a desired trajectory, each query keeps the pose features of a frame
+ * and moves its trajectory off the database by noise.
+ */
+int main() {
+    auto skeleton = Synthetic::makeSkeleton(JOINT_COUNT);
+    std::vector<Model::Animation> clips = {};
+    for (size_t i = 0; i < CLIP_COUNT; ++i) {
+        clips.push_back(
+            Synthetic::makeClip(*skeleton, CLIP_LENGTH, 0.5f + 0.05f * static_cast<float>(i)));
+    }
+    Model::MotionFeatureSettings settings = {};
+    // Three joints and three trajectory times give 3 * 6 + 3 * 4 = 30 features.
+    settings.joints = {"joint3", "joint7", "joint11"};
+    settings.loopingClips.assign(CLIP_COUNT, 1);
+    Model::MotionDatabase database(*skeleton, clips, settings);
+
+    std::mt19937 random(11);
+    std::normal_distribution<float> noise(0.0f, 0.5f);
+    std::vector<float> queries(QUERIES * database.getFeatureCount());
+    std::vector<size_t> currentFrames(QUERIES);
+    for (size_t i = 0; i < QUERIES; ++i) {
+        currentFrames[i] = random() % database.getFrameCount();
+        const float *features = database.getFeatures(currentFrames[i]);
+        for (size_t k = 0; k < database.getFeatureCount(); ++k) {
+            bool trajectory = k >= database.getTrajectoryOffset();
+            queries[i * database.getFeatureCount() + k] =
+                features[k] + (trajectory ? noise(random) : 0.0f);
+        }
+    }
+
+    std::vector<Model::MotionMatch> hierarchy(QUERIES), bruteForce(QUERIES);
+    double hierarchyTime = Synthetic::microsecondsPerCall(QUERIES, [&](size_t i) {
+        hierarchy[i] = database.search(&queries[i * database.getFeatureCount()], currentFrames[i]);
+    });
+    database.resetStatistics();
+    double bruteForceTime = Synthetic::microsecondsPerCall(QUERIES, [&](size_t i) {
+        bruteForce[i] = database.searchBruteForce(&queries[i * database.getFeatureCount()]);
+    });
+    double bruteForceRate = database.getQueriesPerSecond();
+
+    int mismatches = 0;
+    for (size_t i = 0; i < QUERIES; ++i) {
+        float scale = std::max(1.0f, bruteForce[i].cost);
+        mismatches += std::abs(hierarchy[i].cost - bruteForce[i].cost) > 1e-4f * scale ? 1 : 0;
+    }
+    std::printf("%zu frames, %zu features, %zu queries\n", database.getFrameCount(),
+                database.getFeatureCount(), QUERIES);
+    std::printf("box hierarchy: %7.2f us per query\n", hierarchyTime);
+    std::printf("brute force:   %7.2f us per query, %.0f queries per second\n", bruteForceTime,
+                bruteForceRate);
+    std::printf("budget %.0f us: %s, %d mismatched costs\n", BUDGET_MICROSECONDS,
+                std::min(hierarchyTime, bruteForceTime) <= BUDGET_MICROSECONDS ? "met" : "missed",
+                mismatches);
+    return mismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,155 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+#include <glm/gtc/quaternion.hpp>
+#include "Model/Models/PoseKernels.hpp"
+
+namespace {
+    /// Largest difference allowed between a SIMD kernel and the scalar reference.
+    constexpr float TOLERANCE = 1e-5f;
+
+    int failures = 0;
+
+    void expectNear(const char *kernel, size_t index, const float *simd, const float *reference,
+                    size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            float scale = std::max(1.0f, std::abs(reference[i]));
+            if (!(std::abs(simd[i] - reference[i]) <= TOLERANCE * scale)) {
+                std::printf("%s: element %zu component %zu is %g, reference %g\n", kernel, index, i,
+                            static_cast<double>(simd[i]), static_cast<double>(reference[i]));
+                ++failures;
+                return;
+            }
+        }
+    }
+
+    glm::vec3 randomTranslation(std::mt19937 &random) {
+        std::uniform_real_distribution<float> distribution(-10.0f, 10.0f);
+        return {distribution(random), distribution(random), distribution(random)};
+    }
+
+    glm::quat randomRotation(std::mt19937 &random) {
+        std::normal_distribution<float> distribution(0.0f, 1.0f);
+        return glm::normalize(glm::quat(distribution(random), distribution(random),
+                                        distribution(random), distribution(random)));
+    }
+
+    using BlendKernel = void (*)(const glm::vec3 *, const glm::quat *, const glm::vec3 *,
+                                 const glm::quat *, float, size_t, glm::vec3 *, glm::quat *);
+
+    /**
+     * Checks a kernel blending two poses against its scalar reference, with random rotations
+     * and with rotations close enough that the slerp falls back to a lerp.
+     */
+    void testBlend(const std::string &name, BlendKernel kernel, BlendKernel reference,
+                   std::mt19937 &random, size_t count) {
+        std::vector<glm::vec3> firstTranslations(count), secondTranslations(count);
+        std::vector<glm::quat> firstRotations(count), secondRotations(count);
+        for (size_t i = 0; i < count; ++i) {
+            firstTranslations[i]  = randomTranslation(random);
+            secondTranslations[i] = randomTranslation(random);
+            firstRotations[i]     = randomRotation(random);
+            secondRotations[i]    = i % 3 == 2 ? glm::normalize(firstRotations[i] +
+                                                                randomRotation(random) * 1e-4f)
+                                               : randomRotation(random);
+        }
+        const std::string translation = name + " translation", rotation = name + " rotation";
+        const std::string aliasedTranslation = name + " aliased translation";
+        const std::string aliasedRotation    = name + " aliased rotation";
+        for (float progression : {0.0f, 0.3f, 1.0f}) {
+            std::vector<glm::vec3> translations(count), referenceTranslations(count);
+            std::vector<glm::quat> rotations(count), referenceRotations(count);
+            kernel(firstTranslations.data(), firstRotations.data(), secondTranslations.data(),
+                   secondRotations.data(), progression, count, translations.data(),
+                   rotations.data());
+            reference(firstTranslations.data(), firstRotations.data(), secondTranslations.data(),
+                      secondRotations.data(), progression, count, referenceTranslations.data(),
+                      referenceRotations.data());
+            for (size_t i = 0; i < count; ++i) {
+                expectNear(translation.c_str(), i, &translations[i].x,
+                           &referenceTranslations[i].x, 3);
+                expectNear(rotation.c_str(), i, &rotations[i].x, &referenceRotations[i].x, 4);
+            }
+            // The output may alias the first input.
+            std::vector<glm::vec3> aliasedTranslations = firstTranslations;
+            std::vector<glm::quat> aliasedRotations    = firstRotations;
+            kernel(aliasedTranslations.data(), aliasedRotations.data(), secondTranslations.data(),
+                   secondRotations.data(), progression, count, aliasedTranslations.data(),
+                   aliasedRotations.data());
+            for (size_t i = 0; i < count; ++i) {
+                expectNear(aliasedTranslation.c_str(), i, &aliasedTranslations[i].x,
+                           &referenceTranslations[i].x, 3);
+                expectNear(aliasedRotation.c_str(), i, &aliasedRotations[i].x,
+                           &referenceRotations[i].x, 4);
+            }
+        }
+    }
+
+    void testComposeTransforms(std::mt19937 &random, size_t count) {
+        std::vector<glm::vec3> translations(count);
+        std::vector<glm::quat> rotations(count);
+        for (size_t i = 0; i < count; ++i) {
+            translations[i] = randomTranslation(random);
+            rotations[i]    = randomRotation(random);
+        }
+        std::vector<glm::mat4> transforms(count), reference(count);
+        Model::Kernels::composeTransforms(translations.data(), rotations.data(), count,
+                                          transforms.data());
+        Model::Kernels::Scalar::composeTransforms(translations.data(), rotations.data(), count,
+                                                  reference.data());
+        for (size_t i = 0; i < count; ++i) {
+            expectNear("composeTransforms", i, &transforms[i][0][0], &reference[i][0][0], 16);
+        }
+    }
+
+    void testHierarchy(std::mt19937 &random, size_t count) {
+        std::vector<int> parents(count);
+        std::vector<glm::mat4> transforms(count);
+        for (size_t i = 0; i < count; ++i) {
+            parents[i] = i == 0 ? -1 : static_cast<int>(random() % i);
+            glm::vec3 translation = randomTranslation(random) * 0.1f;
+            glm::quat rotation    = randomRotation(random);
+            Model::Kernels::Scalar::composeTransforms(&translation, &rotation, 1, &transforms[i]);
+        }
+        for (size_t i = 1; i < count; ++i) {
+            glm::mat4 product   = Model::Kernels::multiplyAffine(transforms[i - 1], transforms[i]);
+            glm::mat4 reference = Model::Kernels::Scalar::multiplyAffine(transforms[i - 1],
+                                                                         transforms[i]);
+            expectNear("multiplyAffine", i, &product[0][0], &reference[0][0], 16);
+        }
+        std::vector<glm::mat4> reference = transforms;
+        Model::Kernels::localToModel(parents.data(), transforms.data(), count);
+        Model::Kernels::Scalar::localToModel(parents.data(), reference.data(), count);
+        for (size_t i = 0; i < count; ++i) {
+            expectNear("localToModel", i, &transforms[i][0][0], &reference[i][0][0], 16);
+        }
+    }
+}
+
+/**
+ * Checks every pose kernel against its scalar reference, at joint counts that leave a remainder
+ * for both the 4 and the 8 wide paths.
+ */
+int main() {
+    std::mt19937 random(7);
+    for (size_t count : {1u, 3u, 4u, 7u, 8u, 9u, 17u, 64u, 131u}) {
+        testBlend("interpolate", Model::Kernels::interpolate,
+                  Model::Kernels::Scalar::interpolate, random, count);
+        testBlend("slerp", Model::Kernels::slerp, Model::Kernels::Scalar::slerp, random, count);
+        testComposeTransforms(random, count);
+        testHierarchy(random, count);
+    }
+#if ANIMTEST_AVX2_KERNELS
+    const char *path = "AVX2";
+#elif ANIMTEST_SSE_KERNELS
+    const char *path = "SSE";
+#else
+    const char *path = "scalar";
+#endif
+    std::printf("Pose kernels (%s): %d mismatches\n", path, failures);
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
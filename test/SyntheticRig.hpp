@@ -0,0 +1,107 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+#include <glm/gtc/matrix_transform.hpp>
+#include "Model/Models/Animation.hpp"
+#include "Model/Models/Skeleton.hpp"
+
+/**
+ * Skeletons and clips built in code, so tests and benchmarks run without importing a model.
+ */
+namespace Synthetic {
+    /// Joints per chain, the first chain is the spine.
+    constexpr size_t CHAIN = 4;
+
+    /**
+     * Parent of a joint of makeSkeleton, every chain after the spine hangs off one of its joints.
+     * @param joint index.
+     * @return the parent, -1 for the root.
+     */
+    constexpr int parentOf(size_t joint) {
+        if (joint % CHAIN != 0) {
+            return static_cast<int>(joint) - 1;
+        }
+        return joint == 0 ? -1 : static_cast<int>((joint / CHAIN - 1) % CHAIN);
+    }
+
+    /**
+     * The hierarchy of makeSkeleton as a constant, for rig layouts, see Controller::FixedRig.
+     * @return the parent of each joint.
+     */
+    template <size_t JointCount>
+    constexpr std::array<int, JointCount> makeParents() {
+        std::array<int, JointCount> parents = {};
+        for (size_t i = 0; i < JointCount; ++i) {
+            parents[i] = parentOf(i);
+        }
+        return parents;
+    }
+
+    /**
+     * Builds a humanoid sized skeleton, a spine with limbs branching off it. Every joint skins
+     * vertices.
+     * @param jointCount number of joints.
+     * @return the skeleton with its bind pose and inverse bind transforms.
+     */
+    inline std::shared_ptr<Model::Skeleton> makeSkeleton(size_t jointCount) {
+        auto skeleton = std::make_shared<Model::Skeleton>();
+        for (size_t i = 0; i < jointCount; ++i) {
+            glm::vec3 offset(i % CHAIN == 0 ? 0.1f : 0.0f, 0.25f, 0.0f);
+            skeleton->addJoint("joint" + std::to_string(i), parentOf(i), static_cast<int>(i),
+                               glm::translate(glm::mat4(1.0f), offset));
+        }
+        skeleton->calcInverseBindTransforms();
+        skeleton->boneOffsets = skeleton->inverseBindTransforms;
+        return skeleton;
+    }
+
+    /**
+     * Builds a looping clip animating every joint at 30 keys per second.
+     * @param skeleton the clip is for.
+     * @param length of the clip in seconds.
+     * @param frequency of the swing in cycles per second, varies the clips.
+     * @return the clip.
+     */
+    inline Model::Animation makeClip(const Model::Skeleton &skeleton, double length,
+                                     float frequency) {
+        constexpr double KEY_RATE = 30.0;
+        auto keyCount = static_cast<size_t>(length * KEY_RATE) + 1;
+        std::vector<Model::JointTrack> tracks(skeleton.size());
+        for (size_t joint = 0; joint < skeleton.size(); ++joint) {
+            auto &track = tracks[joint];
+            track.joint = joint;
+            glm::vec3 bind = skeleton.bindPose.translations[joint];
+            for (size_t key = 0; key < keyCount; ++key) {
+                double time = static_cast<double>(key) / KEY_RATE;
+                auto phase = static_cast<float>(6.2831853 * frequency * time) +
+                             0.3f * static_cast<float>(joint);
+                track.positionTimes.push_back(time);
+                track.positions.push_back(bind + glm::vec3(0.0f, 0.02f * std::sin(phase), 0.0f));
+                track.rotationTimes.push_back(time);
+                track.rotations.push_back(
+                    glm::angleAxis(0.3f * std::sin(phase), glm::vec3(0.0f, 0.0f, 1.0f)));
+            }
+        }
+        return Model::Animation(length, std::move(tracks));
+    }
+
+    /**
+     * Times a function.
+     * @param iterations number of calls.
+     * @param function to call.
+     * @return average time per call in microseconds.
+     */
+    template<typename Function>
+    double microsecondsPerCall(size_t iterations, Function &&function) {
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; ++i) {
+            function(i);
+        }
+        std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count() / static_cast<double>(iterations);
+    }
+}